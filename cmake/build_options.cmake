@@ -4,6 +4,7 @@ option(PDC_UTF8 "Force to UTF8" OFF)
 option(PDC_WIDE "Wide - pulls in sdl-ttf" OFF)
 option(PDCDEBUG "Debug tracing" OFF)
 option(PDC_CHTYPE_32 "CHTYPE_32" OFF)
+option(PDC_THREADS "Thread-safe use_window()/use_screen() locking" OFF)
 option(PDC_OS2_BUILD "Build OS/2 Project" OFF)
 option(PDC_DOS_BUILD "Build DOS Project" OFF)
 option(PDC_DOSVGA_BUILD "Build DOSVGA Project" OFF)
@@ -17,6 +18,7 @@ message(STATUS "PDC_UTF8 ............... ${PDC_UTF8}")
 message(STATUS "PDC_WIDE ............... ${PDC_WIDE}")
 message(STATUS "PDCDEBUG ............... ${PDCDEBUG}")
 message(STATUS "PDC_CHTYPE_32 .......... ${PDC_CHTYPE_32}")
+message(STATUS "PDC_THREADS ............ ${PDC_THREADS}")
 message(STATUS "PDC_OS2_BUILD .......... ${PDC_OS2_BUILD}")
 message(STATUS "PDC_DOS_BUILD .......... ${PDC_DOS_BUILD}")
 message(STATUS "PDC_DOSVGA_BUILD ....... ${PDC_DOSVGA_BUILD}")
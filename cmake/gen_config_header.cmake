@@ -27,6 +27,9 @@ ENDIF (PDC_CHTYPE_32)
 IF(PDCDEBUG)
     ADD_DEFINITIONS(-DPDCDEBUG)
 ENDIF(PDCDEBUG)
+IF(PDC_THREADS)
+    ADD_DEFINITIONS(-DPDC_THREADS)
+ENDIF(PDC_THREADS)
 
 IF ("${CMAKE_BUILD_TYPE}" STREQUAL "Debug")
     ADD_DEFINITIONS(-D_DEBUG)
@@ -76,6 +76,11 @@ if (APPLE)
     endif()
 endif()
 
+if(PDC_THREADS)
+    find_package(Threads REQUIRED)
+    list(APPEND EXTRA_LIBS Threads::Threads)
+endif()
+
 if(PDC_BUILD_SHARED)
     set(PDCURSE_PROJ ${PROJECT_NAME}_pdcurses)
     add_library(${PDCURSE_PROJ} SHARED ${pdc_src_files} ${pdcurses_src_files})
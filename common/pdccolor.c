@@ -20,8 +20,8 @@ See 'pdccolor.txt' for a rationale of how this works. */
 
 int PDC_blink_state = 0;
 
-static PACKED_RGB *rgbs;   /* the 'standard' 256-color palette,  plus any allocated */
-static int _palette_size;
+/* The palette (the 'standard' 256 colors,  plus any allocated) lives in
+SP->palette,  so that each SCREEN created with newterm() has its own. */
 
 PACKED_RGB PDC_default_color( int idx)
 {
@@ -71,19 +71,22 @@ int PDC_init_palette( void)
 
 void PDC_free_palette( void)
 {
-   if( rgbs)
-      free( rgbs);
-   rgbs = NULL;
+   if( SP && SP->palette)
+      {
+      free( SP->palette);
+      SP->palette = NULL;
+      SP->palette_size = 0;
+      }
 }
 
 PACKED_RGB PDC_get_palette_entry( const int idx)
 {
    PACKED_RGB rval;
 
-   if( idx < _palette_size)
+   if( SP && idx < SP->palette_size)
    {
       assert( idx >= 0);
-      rval = rgbs[idx];
+      rval = SP->palette[idx];
    }
    else
       rval = PDC_default_color( idx);
@@ -95,25 +98,31 @@ didn't change (new RGB matched the old one),  and 1 if the color changed. */
 
 int PDC_set_palette_entry( const int idx, const PACKED_RGB rgb)
 {
+   PACKED_RGB *rgbs;
    int rval, i;
 
-   if( idx >= _palette_size)
+   assert( SP);
+   if( !SP)
+      return( -1);
+   if( idx >= SP->palette_size)
       {
-      int new_size = _palette_size;
+      int new_size = SP->palette_size;
       const int initial_palette_size = 8;
 
       if( !new_size)
          new_size = initial_palette_size;
       while( new_size <= idx)
          new_size *= 2;
-      rgbs = (PACKED_RGB *)realloc( rgbs, new_size * sizeof( PACKED_RGB));
+      rgbs = (PACKED_RGB *)realloc( SP->palette, new_size * sizeof( PACKED_RGB));
       assert( rgbs);
       if( !rgbs)
          return( -1);
-      for( i = _palette_size; i < new_size; i++)
+      for( i = SP->palette_size; i < new_size; i++)
          rgbs[i] = PDC_default_color( i);
-      _palette_size = new_size;
+      SP->palette = rgbs;
+      SP->palette_size = new_size;
       }
+   rgbs = SP->palette;
    rval = (rgbs[idx] == rgb ? 1 : 0);
    rgbs[idx] = rgb;
    return( rval);
@@ -176,15 +185,25 @@ void PDC_get_rgb_values( const chtype srcp,
     bool default_foreground = FALSE, default_background = FALSE;
     int foreground_index, background_index;
 
-    extended_pair_content( color, &foreground_index, &background_index);
-    if( foreground_index < 0 && SP->orig_attr)
-        default_foreground = TRUE;
-    else
-        *foreground_rgb = PDC_get_palette_entry( foreground_index);
-    if( background_index < 0 && SP->orig_attr)
-        default_background = TRUE;
+    if( (srcp & A_DIRECT_COLOR) && SP->direct_rgb)
+    {                 /* colors are in the ring set up in refresh.c */
+        const uint64_t rgb = SP->direct_rgb[color & SP->direct_mask];
+
+        *foreground_rgb = (PACKED_RGB)( rgb & 0xffffff);
+        *background_rgb = (PACKED_RGB)( rgb >> 24);
+    }
     else
-        *background_rgb = PDC_get_palette_entry( background_index);
+    {
+        extended_pair_content( color, &foreground_index, &background_index);
+        if( foreground_index < 0 && SP->orig_attr)
+            default_foreground = TRUE;
+        else
+            *foreground_rgb = PDC_get_palette_entry( foreground_index);
+        if( background_index < 0 && SP->orig_attr)
+            default_background = TRUE;
+        else
+            *background_rgb = PDC_get_palette_entry( background_index);
+    }
 
     if( srcp & A_BLINK)
     {
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <curspriv.h>
+
+/* Code to convert a binary trace,  as written by PDC_bintrace_dump() (see
+pdcurses/debug.c),  to text or to the Chrome trace event (JSON) format,
+which can be loaded into chrome://tracing or https://ui.perfetto.dev .
+Compile with
+
+cc -I.. -o trace2txt trace2txt.c
+
+and run as
+
+trace2txt trace.bin          (for one line of text per record)
+trace2txt -j trace.bin > trace.json
+
+doupdate() begin/end records become 'B'/'E' (duration) events in the
+JSON output;  everything else becomes an instant ('i') event.  */
+
+static const char *event_names[] = { "?", "doupdate", "doupdate_end",
+            "wnoutrefresh", "transform_line", "gotoyx", "getch", "resize",
+            "napms" };
+
+static const char *arg_names[][3] = { { "", "", "" },
+            { "clearall", "", "" },
+            { "lines", "runs", "cells" },
+            { "begy", "begx", "lines" },
+            { "line", "x", "len" },
+            { "y", "x", "" },
+            { "key", "modifiers", "" },
+            { "lines", "cols", "" },
+            { "ms", "", "" } };
+
+#define N_EVENTS (int)( sizeof( event_names) / sizeof( event_names[0]))
+
+static const char *category_name( const unsigned category)
+{
+   switch( category)
+      {
+      case TRACE_TIMES:    return( "times");
+      case TRACE_UPDATE:   return( "update");
+      case TRACE_MOVE:     return( "move");
+      case TRACE_CHARPUT:  return( "charput");
+      case TRACE_CALLS:    return( "calls");
+      case TRACE_IEVENT:   return( "ievent");
+      case TRACE_ATTRS:    return( "attrs");
+      default:             return( "other");
+      }
+}
+
+int main( const int argc, const char **argv)
+{
+   const char *filename = NULL;
+   int i, json = 0;
+   FILE *ifile;
+   char magic[8];
+   uint32_t header[4], n;
+   PDC_TRACE_RECORD rec;
+   uint64_t t0 = 0;
+
+   for( i = 1; i < argc; i++)
+      if( !strcmp( argv[i], "-j"))
+         json = 1;
+      else
+         filename = argv[i];
+   if( !filename)
+      {
+      fprintf( stderr, "Usage:  trace2txt [-j] trace.bin\n");
+      return( -1);
+      }
+   ifile = fopen( filename, "rb");
+   if( !ifile)
+      {
+      fprintf( stderr, "Couldn't open '%s'\n", filename);
+      return( -2);
+      }
+   if( !fread( magic, 8, 1, ifile) || !fread( header, sizeof( header), 1, ifile)
+            || memcmp( magic, PDC_BINTRACE_MAGIC, 8))
+      {
+      fprintf( stderr, "'%s' isn't a PDCursesMod binary trace\n", filename);
+      return( -3);
+      }
+   if( header[0] != 0x01020304 || header[1] != sizeof( PDC_TRACE_RECORD))
+      {
+      fprintf( stderr, "Trace was written with a different byte order\n"
+                       "or record layout\n");
+      return( -4);
+      }
+   if( json)
+      printf( "{\"traceEvents\":[\n");
+   for( n = 0; n < header[2] && fread( &rec, sizeof( rec), 1, ifile); n++)
+      {
+      const int ev = (rec.event < N_EVENTS ? rec.event : 0);
+
+      if( !n)
+         t0 = rec.usec;
+      if( json)
+         {
+         const char phase = (ev == PDC_EV_DOUPDATE_BEGIN ? 'B' :
+                             (ev == PDC_EV_DOUPDATE_END ? 'E' : 'i'));
+
+         printf( "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+                 "\"ts\":%lu,\"pid\":1,\"tid\":1,%s\"args\":{",
+                 (n ? ",\n" : ""),
+                 (phase == 'E' ? event_names[PDC_EV_DOUPDATE_BEGIN] : event_names[ev]),
+                 category_name( rec.category), phase,
+                 (unsigned long)( rec.usec - t0),
+                 (phase == 'i' ? "\"s\":\"t\"," : ""));
+         for( i = 0; i < 3 && *arg_names[ev][i]; i++)
+            printf( "%s\"%s\":%ld", (i ? "," : ""), arg_names[ev][i],
+                                    (long)rec.args[i]);
+         printf( "}}");
+         }
+      else
+         {
+         printf( "%12.6f %-8s %-15s", (double)( rec.usec - t0) / 1e+6,
+                  category_name( rec.category), event_names[ev]);
+         for( i = 0; i < 3 && *arg_names[ev][i]; i++)
+            printf( " %s=%ld", arg_names[ev][i], (long)rec.args[i]);
+         printf( "\n");
+         }
+      }
+   if( json)
+      printf( "\n]}\n");
+   fclose( ifile);
+   return( 0);
+}
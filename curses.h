@@ -170,7 +170,8 @@ enum PDC_port
     PDC_PORT_PLAN9 = 9,
     PDC_PORT_LINUX_FB = 10,
     PDC_PORT_OPENGL = 11,
-    PDC_PORT_OS2GUI = 12
+    PDC_PORT_OS2GUI = 12,
+    PDC_PORT_REMOTE = 13
 };
 
 /* Use this structure with PDC_get_version() for run-time info about the
@@ -194,7 +195,8 @@ enum
     PDC_VFLAG_WIDE  = 2,  /* -DPDC_WIDE */
     PDC_VFLAG_UTF8  = 4,  /* -DPDC_FORCE_UTF8 */
     PDC_VFLAG_DLL   = 8,  /* -DPDC_DLL_BUILD */
-    PDC_VFLAG_RGB   = 16  /* -DPDC_RGB */
+    PDC_VFLAG_RGB   = 16, /* -DPDC_RGB */
+    PDC_VFLAG_THREADS = 32  /* -DPDC_THREADS */
 };
 
 /*----------------------------------------------------------------------
@@ -328,6 +330,7 @@ to make the distinction,  and will allow other events to be added later. */
 #define BUTTON_MODIFIER_CONTROL (MOUSE_WHEEL_SCROLL << 2)
 #define BUTTON_MODIFIER_ALT     (MOUSE_WHEEL_SCROLL << 3)
 #define REPORT_MOUSE_POSITION   (MOUSE_WHEEL_SCROLL << 4)
+#define PDC_MOUSE_COALESCE      (MOUSE_WHEEL_SCROLL << 5)  /* PDCurses */
 
 #define ALL_MOUSE_EVENTS        (REPORT_MOUSE_POSITION - 1)
 
@@ -336,7 +339,8 @@ to make the distinction,  and will allow other events to be added later. */
 typedef struct
 {
     short id;       /* unused, always 0 */
-    int x, y, z;    /* x, y same as MOUSE_STATUS; z unused */
+    int x, y, z;    /* x, y same as MOUSE_STATUS; z is the number of
+                       wheel ticks with PDC_MOUSE_COALESCE, else 0 */
     mmask_t bstate; /* equivalent to changes + button[], but
                        in the same format as used for mousemask() */
 } MEVENT;
@@ -409,7 +413,8 @@ Default, 64-bit chtype,  both wide- and 8-bit character builds:
 
    21 character bits (0-20),  enough for full Unicode coverage
    17 attribute bits (21-37)
-    6 currently unused bits (38-43)
+    1 direct color bit (38);  see PDC_wset_rgb()
+    5 currently unused bits (39-43)
    20 color pair bits (44-63),  enough for 1048576 color pairs
 
 32-bit chtypes with wide characters (CHTYPE_32 and PDC_WIDE are #defined):
@@ -511,6 +516,15 @@ capability.
     # define WA_STANDOUT   (WA_REVERSE | WA_BOLD) /* X/Open */
 #endif
 
+/* Cells with WA_DIRECT_COLOR take their colors from the window's RGB
+   plane,  not from a color pair;  see PDC_wset_rgb().  64-bit chtypes only. */
+
+#ifndef CHTYPE_32
+    # define WA_DIRECT_COLOR PDC_ATTRIBUTE_BIT( PDC_CHARTEXT_BITS + PDC_ATTRIBUTE_BITS)
+#else
+    # define WA_DIRECT_COLOR 0
+#endif
+
 #define CHR_MSK       A_CHARTEXT           /* Obsolete */
 #define ATR_MSK       A_ATTRIBUTES         /* Obsolete */
 #define ATR_NRM       A_NORMAL             /* Obsolete */
@@ -542,6 +556,7 @@ capability.
 
 #define A_ITALIC     WA_ITALIC
 #define A_STRIKEOUT  WA_STRIKEOUT
+#define A_DIRECT_COLOR WA_DIRECT_COLOR
 
 /*** Alternate character set macros ***/
 
@@ -1728,6 +1743,12 @@ PDCEX  WINDOW *wgetparent(const WINDOW *);
 PDCEX  int     wgetscrreg(const WINDOW *, int *, int *);
 PDCEX  int     wresize(WINDOW *, int, int);
 
+typedef int (*NCURSES_WINDOW_CB)(WINDOW *, void *);
+typedef int (*NCURSES_SCREEN_CB)(SCREEN *, void *);
+
+PDCEX  int     use_screen(SCREEN *, NCURSES_SCREEN_CB, void *);
+PDCEX  int     use_window(WINDOW *, NCURSES_WINDOW_CB, void *);
+
 PDCEX  bool    has_mouse(void);
 PDCEX  int     mouseinterval(int);
 PDCEX  mmask_t mousemask(mmask_t, mmask_t *);
@@ -1769,11 +1790,22 @@ PDCEX  bool    PDC_getcbreak(void);    /* deprecated;  use is_cbreak() */
 PDCEX  bool    PDC_getecho(void);      /* deprecated;  use is_echo()   */
 PDCEX  void    PDC_debug(const char *, ...);
 PDCEX  void    _tracef(const char *, ...);
+PDCEX  int     PDC_bintrace_start( const unsigned, const int);
+PDCEX  void    PDC_bintrace_stop( void);
+PDCEX  int     PDC_bintrace_dump( const char *);
+PDCEX  int     PDC_record_start( const char *);
+PDCEX  void    PDC_record_stop( void);
+PDCEX  bool    PDC_wait_for_refresh( const int);
 PDCEX  void    PDC_get_version(PDC_VERSION *);
 PDCEX  int     PDC_ungetch(int);
 PDCEX  int     PDC_set_blink(bool);
 PDCEX  int     PDC_set_bold(bool);
 PDCEX  int     PDC_set_line_color(short);
+PDCEX  int     PDC_set_rgb( const int32_t, const int32_t);
+PDCEX  int     PDC_wset_rgb( WINDOW *, const int32_t, const int32_t);
+PDCEX  int     PDC_wprintn( WINDOW *, const char *, const int);
+PDCEX  int     PDC_mvwprintn( WINDOW *, const int, const int, const char *,
+                              const int);
 PDCEX  void    PDC_set_title(const char *);
 
 PDCEX  int     PDC_clearclipboard(void);
@@ -1781,6 +1813,7 @@ PDCEX  int     PDC_freeclipboard(char *);
 PDCEX  int     PDC_getclipboard(char **, long *);
 PDCEX  int     PDC_setclipboard(const char *, long);
 
+PDCEX  int     PDC_get_input_fd(void);
 PDCEX  unsigned long PDC_get_key_modifiers(void);
 PDCEX  int     PDC_return_key_modifiers(bool);
 PDCEX  void    PDC_set_resize_limits( const int new_min_lines,
@@ -1849,7 +1882,6 @@ PDCEX  int     wunderscore(WINDOW *);
 /* Deprecated */
 
 #define PDC_save_key_modifiers(x)  (OK)
-#define PDC_get_input_fd()         0
 
 /* return codes from PDC_getclipboard() and PDC_setclipboard() calls */
 
@@ -94,6 +94,7 @@ void    PDC_set_keyboard_binary(bool);
 void    PDC_transform_line(int, int, int, const chtype *);
 void    PDC_transform_line_sliced(int, int, int, const chtype *);
 const char *PDC_sysname(void);
+void    PDC_wait_for_input(int);
 
 /* Internal cross-module functions */
 
@@ -112,7 +113,17 @@ void    PDC_mark_line_as_changed( WINDOW *win, const int y);
 void    PDC_mark_cells_as_changed( WINDOW *, const int y, const int start, const int end);
 void    PDC_mark_cell_as_changed( WINDOW *, const int y, const int x);
 bool    PDC_touched_range( const WINDOW *win, const int y, int *firstch, int *lastch);
+int     PDC_first_changed_cell( const chtype *, const chtype *, const int len);
+int     PDC_last_changed_cell( const chtype *, const chtype *, const int len);
+int     PDC_first_unchanged_cell( const chtype *, const chtype *, const int len);
 int     PDC_wscrl(WINDOW *win, const int top, const int bottom, int n);
+void    PDC_note_blink_cells( const int row, const chtype *cells, int n);
+uint64_t *PDC_rgb_cell( const WINDOW *win, const chtype *cell, const bool create);
+void    PDC_copy_rgb( WINDOW *dest, const chtype *dcell, const WINDOW *src,
+                      const chtype *scell, const int n);
+bool    PDC_set_cell_rgb( WINDOW *win, const chtype *cell);
+void    PDC_touch_blink_rows( void);
+int     PDC_redraw_blinking_text( void);
 
 #ifdef PDC_WIDE
 int     PDC_mbtowc(wchar_t *, const char *, size_t);
@@ -132,6 +143,93 @@ int PDC_expand_combined_characters( const cchar_t c, cchar_t *added);
 # define PDC_LOG(x)
 #endif
 
+/* Binary trace events,  recorded (when enabled with PDC_bintrace_start())
+into the ring buffer in debug.c.  Each is recorded only if its TRACE_*
+category is in the flags given to PDC_bintrace_start().  Values must not
+be changed,  since they appear in trace dumps;  see common/trace2txt.c. */
+
+#define PDC_EV_DOUPDATE_BEGIN    1  /* clearall                          */
+#define PDC_EV_DOUPDATE_END      2  /* lines changed, runs, cells sent   */
+#define PDC_EV_WNOUTREFRESH      3  /* begy, begx, lines copied          */
+#define PDC_EV_TRANSFORM_LINE    4  /* line, x, len                      */
+#define PDC_EV_GOTOYX            5  /* y, x                              */
+#define PDC_EV_GETCH             6  /* key, key modifiers                */
+#define PDC_EV_RESIZE            7  /* lines, cols                       */
+#define PDC_EV_NAPMS             8  /* milliseconds                      */
+
+typedef struct
+{
+    uint64_t usec;        /* monotonic timestamp, in microseconds */
+    uint16_t event;       /* PDC_EV_xxx */
+    uint16_t category;    /* TRACE_xxx */
+    int32_t  args[3];
+} PDC_TRACE_RECORD;
+
+#define PDC_BINTRACE_MAGIC    "PDCbtrc1"
+
+extern unsigned PDC_bintrace_flags;
+void    PDC_bintrace_record( const int category, const int event,
+                             const long a, const long b, const long c);
+void    PDC_bintrace_free( void);
+
+#define PDC_TRACE( category, event, a, b, c)                             \
+            if (PDC_bintrace_flags & (category))                         \
+                PDC_bintrace_record( category, event, a, b, c)
+
+/* Frame recording (see debug.c and tests/replay.c).  The record types
+appear in recordings,  so they must not be changed. */
+
+#define PDC_RECORD_MAGIC      "PDCrec02"
+
+#define PDC_REC_SIZE          'S'  /* lines, cols                          */
+#define PDC_REC_PAIR          'P'  /* pair, fg, bg                         */
+#define PDC_REC_COLOR         'C'  /* color, red, green, blue              */
+#define PDC_REC_FRAME_BEGIN   'U'  /* usec, clearall                       */
+#define PDC_REC_RUN           'L'  /* line, x, len, cells (+ RGB if direct) */
+#define PDC_REC_FRAME_END     'E'  /* usec, cursor y, x, visibility        */
+#define PDC_REC_KEY           'K'  /* usec, key, modifiers                 */
+#define PDC_REC_MOUSE         'M'  /* usec, x, y, changes, button[0...4]   */
+
+extern FILE *PDC_record_fp;
+void    PDC_record_size( const int lines, const int cols);
+void    PDC_record_pair( const int pair, const int fg, const int bg);
+void    PDC_record_color( const int color, const int red, const int green,
+                          const int blue);
+void    PDC_record_color_pairs( void);
+void    PDC_record_frame_begin( const bool clearall);
+void    PDC_record_run( const int lineno, const int x, const int len,
+                        const chtype *srcp);
+void    PDC_record_frame_end( const int cursor_y, const int cursor_x,
+                              const int visibility);
+void    PDC_record_input( const int key);
+
+#define PDC_RECORD( call)        if (PDC_record_fp) call
+
+/* Startup timing,  enabled by PDC_STARTUP_TIMES;  see debug.c */
+
+uint64_t PDC_startup_clock( void);
+uint64_t PDC_startup_time( const char *phase, const uint64_t since);
+
+/* Locking for the optional threaded mode;  see window.c.  In unthreaded
+builds,  the macros compile to nothing. */
+
+#ifdef PDC_THREADS
+void    PDC_lock_window( const WINDOW *win);
+void    PDC_unlock_window( const WINDOW *win);
+void    PDC_lock_screen( void);
+void    PDC_unlock_screen( void);
+void    PDC_signal_screen( void);
+int     PDC_wait_screen( const int ms);
+
+#define PDC_LOCK_SCREEN( )       PDC_lock_screen( )
+#define PDC_UNLOCK_SCREEN( )     PDC_unlock_screen( )
+#define PDC_SIGNAL_SCREEN( )     PDC_signal_screen( )
+#else
+#define PDC_LOCK_SCREEN( )       ((void)0)
+#define PDC_UNLOCK_SCREEN( )     ((void)0)
+#define PDC_SIGNAL_SCREEN( )     ((void)0)
+#endif
+
 /* Internal macros for attributes */
 
 #ifndef max
@@ -149,7 +247,6 @@ int PDC_expand_combined_characters( const cchar_t c, cchar_t *added);
 
 #define _INBUFSIZ        512  /* size of terminal input buffer */
 #define NUNGETCH         256  /* max # chars to ungetch() */
-#define MAX_PACKET_LEN    90  /* max # chars to send to PDC_transform_line */
 
 #define OFF_SCREEN_WINDOWS_TO_RIGHT_AND_BOTTOM        1
 #define OFF_SCREEN_WINDOWS_TO_LEFT_AND_TOP            2
@@ -187,6 +284,11 @@ struct _win               /* definition of a window */
     int   _pminrow, _pmincol;    /* saved position used only for pads */
     int   _sminrow, _smaxrow;    /* saved position used only for pads */
     int   _smincol, _smaxcol;    /* saved position used only for pads */
+    int   _maxy_alloc;    /* lines and columns allocated,  which may */
+    int   _maxx_alloc;    /* exceed _maxy/_maxx;  see resize_window() */
+    uint64_t *_rgb;       /* direct colors of the lines' cells;  only on */
+                          /* windows owning their lines (see attr.c)     */
+    uint64_t _direct_rgb; /* colors set with PDC_wset_rgb() */
 };
 
 #if PDC_COLOR_BITS < 15
@@ -263,6 +365,28 @@ struct _screen
     unsigned trace_flags;
     bool want_trace_fflush;
     FILE *output_fd, *input_fd;
+    char *blink_rows;     /* rows of curscr that may hold A_BLINK cells */
+    int blink_rows_alloced, n_blink_rows;
+    uint32_t *palette;    /* see common/pdccolor.c */
+    int palette_size;
+    struct _pdc_port_state *port;      /* per-terminal platform state */
+    struct _pdc_saved_modes *saved_modes;    /* see kernel.c */
+    WINDOW *saved_stdscr, *saved_curscr;   /* globals belonging to this */
+    int saved_lines, saved_cols;           /* screen,  stashed while    */
+    int saved_colors, saved_color_pairs;   /* another one is current;   */
+    int saved_tabsize;                     /* see set_term()            */
+    MOUSE_STATUS saved_mouse_status;
+    int mouse_ticks;      /* wheel ticks merged into the last event */
+    bool key_held;        /* if held_key was read ahead while merging */
+    int held_key;         /* mouse events (see getch.c),  and is to */
+    unsigned long held_key_modifiers;     /* be returned next */
+    MOUSE_STATUS held_mouse_status;
+    chtype *direct_cells;    /* runs of curscr with direct colors resolved */
+    uint64_t *direct_rgb;    /* into this ring (see refresh.c),  indexed by */
+    unsigned direct_mask;    /* the cells' color fields,  masked */
+    unsigned direct_counter;
+    char *printw_buf;        /* scratch for vwprintw(),  grown as needed */
+    size_t printw_buf_size;
 };
 
 PDCEX  SCREEN       *SP;          /* curses variables */
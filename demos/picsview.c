@@ -45,6 +45,10 @@ cell,  and the upper half in the background color for that cell.  Thus,
 the 'pixels' making up our image are one character wide,  but only
 half a character high.
 
+   Where the platform supports direct colors (termattrs() includes
+A_DIRECT_COLOR),  the RGB values are set with PDC_set_rgb() instead,
+and no color pairs are used at all.
+
    We start out with the image scaled to fit entirely within the window.
 The loop below goes through 2 * LINES iterations.  On even passes,  we
 compute RGB values for the pixels that will go into the top half of each
@@ -306,6 +310,12 @@ int main( const int argc, const char *argv[])
       int *idxs = xloc + COLS;
       int prev_idx = -1, prev_low_idx = -1;
       int j, pair_num = 16;
+#ifdef A_DIRECT_COLOR
+      const bool direct = ((termattrs( ) & A_DIRECT_COLOR)
+                                 && COLORS > 0x100000);
+#else
+      const bool direct = FALSE;
+#endif
       MEVENT mouse_event;
       double xpix1, ypix1;
 
@@ -353,7 +363,15 @@ int main( const int argc, const char *argv[])
                wchar_t bblock_char = (wchar_t)UNICODE_BBLOCK;
 #endif
 
-               if( low_idx != prev_low_idx || idxs[i] != prev_idx)
+               if( direct && (low_idx != prev_low_idx || idxs[i] != prev_idx))
+                  {
+#ifdef A_DIRECT_COLOR
+                  PDC_set_rgb( low_idx - 256, idxs[i] - 256);
+#endif
+                  prev_low_idx = low_idx;
+                  prev_idx = idxs[i];
+                  }
+               else if( low_idx != prev_low_idx || idxs[i] != prev_idx)
                   {
 #ifdef NCURSES_VERSION
                   init_pair( pair_num, low_idx, idxs[i]);
@@ -378,7 +396,10 @@ int main( const int argc, const char *argv[])
       mvaddstr( LINES - 1, 0, filename_to_show);
       snprintf( buff, sizeof( buff), " %d x %d pixels", xsize, ysize);
       addstr( buff);
-      snprintf( buff, sizeof( buff), "     %d color pairs used", pair_num);
+      if( direct)
+         strcpy( buff, "     direct colors");
+      else
+         snprintf( buff, sizeof( buff), "     %d color pairs used", pair_num);
       addstr( buff);
       if( show_help)
          {
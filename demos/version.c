@@ -23,7 +23,7 @@ int main( void)
 {
    static const char *port_text[] = { "X11", "Win32 console", "Win32a",
          "DOS", "OS/2", "SDL1", "SDL2", "VT", "DOSVGA", "Plan9", "Linux FB",
-         "OpenGL" };
+         "OpenGL", "OS/2 GUI", "Remote" };
    PDC_VERSION vinfo;
 
    printf( "Compiled as version %d.%d.%d, chtype size %d\n",
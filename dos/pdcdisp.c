@@ -146,7 +146,7 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
     {
         attr = srcp[i] & (A_ATTRIBUTES ^ A_ALTCHARSET);
 
-        if (attr != old_attr)
+        if (attr != old_attr || i == MAX_PACKET_SIZE - 1)
         {
             _new_packet(old_attr, lineno, x, i, srcp);
             old_attr = attr;
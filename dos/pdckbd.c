@@ -407,6 +407,25 @@ int PDC_get_key(void)
     return key;
 }
 
+/* wait for input,  or for up to 'ms' milliseconds.  There's no way to
+   block on input here,  so we nap in slices of up to 50 ms */
+
+void PDC_wait_for_input(int ms)
+{
+    PDC_LOG(("PDC_wait_for_input() - called: ms=%d\n", ms));
+
+    PDC_napms((ms < 0 || ms > 50) ? 50 : ms);
+}
+
+/* no descriptor to watch for input on this platform */
+
+int PDC_get_input_fd(void)
+{
+    PDC_LOG(("PDC_get_input_fd() - called\n"));
+
+    return -1;
+}
+
 /* discard any pending keyboard or mouse input -- this is the core
    routine for flushinp() */
 
@@ -5,6 +5,9 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#ifdef PDC_RENDER_POOL
+   #include <pthread.h>
+#endif
 
 #include "curspriv.h"
 #include "pdcfb.h"
@@ -20,47 +23,60 @@
 #include "../common/pdccolor.h"
 
 extern int PDC_blink_state;
+extern bool PDC_lazy_setup_pending;                 /* see pdcscrn.c */
+void PDC_lazy_setup( void);
+
+static void _finish_queued_runs( void);
 
 /* Blinking of text and the cursor in this port has to be handled a
 little strangely.  "When possible",  we check to see if blink_interval
 milliseconds (currently set to 0.5 seconds) has elapsed since the
 blinking text was drawn.  If it has,  we flip the PDC_blink_state
-bit and redraw all blinking text and the cursor.
-
-Currently,  "when possible" is in PDC_napms( ) and in check_key( )
-(see vt/pdckbd.c for the latter).  This does mean that if you set up
-some blinking text,  and then do some processor-intensive stuff and
-aren't checking for keyboard input,  the text will stop blinking. */
-
-void PDC_check_for_blinking( void)
+bit and redraw the blinking text (only rows that refresh.c has flagged
+as possibly holding some) and the cursor.
+
+Currently,  "when possible" is in PDC_napms( ),  check_key( ) and
+PDC_wait_for_input( ) (see vt/pdckbd.c for the latter two).  This does
+mean that if you set up some blinking text,  and then do some
+processor-intensive stuff and aren't checking for keyboard input,  the
+text will stop blinking.  The return value is the number of milliseconds
+until the next blink is due,  so that PDC_wait_for_input( ) knows how
+long it may sleep,  or -1 if nothing is blinking (no text with A_BLINK,
+and a cursor that looks the same in both blink states).  In that case,
+PDC_blink_state is left at zero,  so text drawn later with A_BLINK
+starts out visible. */
+
+long PDC_check_for_blinking( void)
 {
    static long prev_time = 0;
    const long t = PDC_millisecs( );
    const long blink_interval = 500L;
+   const bool cursor_blinks =
+            ((SP->visibility & 0xff) != ((SP->visibility >> 8) & 0xff));
 
+   if( !SP->n_blink_rows && !cursor_blinks)
+   {
+      if( PDC_blink_state)
+         {
+         PDC_blink_state = 0;
+         prev_time = t;
+         }
+      return( -1L);
+   }
    if( !t || t - prev_time > blink_interval)
    {
-      int x1, y, x2;
-
       prev_time = t;
       PDC_blink_state ^= 1;
-      for( y = 0; y < SP->lines; y++)
+      PDC_redraw_blinking_text( );
+      if( cursor_blinks)
       {
-         chtype *c = curscr->_y[y];
+         const int y = SP->cursrow, x = SP->curscol;
 
-         for( x1 = 0; x1 < SP->cols; x1++)
-            if( c[x1] & A_BLINK)
-            {
-               x2 = x1 + 1;
-               while( x2 < SP->cols && c[x2] & A_BLINK)
-                  x2++;
-               PDC_transform_line( y, x1, x2 - x1, c + x1);
-               x1 = x2;
-            }
-         if( SP->visibility && y == SP->cursrow)
-            PDC_transform_line( y, SP->curscol, 1, c + SP->curscol);
+         PDC_transform_line( y, x, 1, curscr->_y[y] + x);
       }
+      _finish_queued_runs( );
    }
+   return( prev_time + blink_interval + 1 - t);
 }
 
                    /* Rarely,  writes to stdout fail if a signal handler is
@@ -152,6 +168,7 @@ void PDC_gotoyx( int row, int col)
         SP->curscol = col;
         PDC_transform_line( row, col, 1, curscr->_y[row] + col);
     }
+    _finish_queued_runs( );
 }
 
 static const uint8_t *_get_raw_glyph_bytes( struct font_info *font, int unicode_point)
@@ -220,13 +237,16 @@ static void _add_combining_character_glyph( uint8_t *glyph, const int code_point
 the PSF file (using _get_raw_glyph_bytes()).  If the glyph has to
 be modified for line drawings or a cursor,  or it's a combined
 character,  or it's bold or italic,  we build the glyph in the
-scratch space and return 'scratch' instead.  */
+scratch space and return 'scratch' instead.  Fonts compiled with psf2c
+have their bold and italic glyphs already made,  so for those,  bold and
+italic text is just an offset into the glyph data.  */
 
 static const uint8_t *_get_glyph( const chtype ch, const int cursor_type,
                                  uint8_t *scratch)
 {
     const uint8_t *rval;
     int c = (int)( ch & A_CHARTEXT);
+    bool styled = FALSE;
 #ifdef USING_COMBINING_CHARACTER_SCHEME
     cchar_t root, newchar;
 
@@ -246,10 +266,19 @@ static const uint8_t *_get_glyph( const chtype ch, const int cursor_type,
     else if( c < (int)' ' || (c >= 0x80 && c <= 0x9f))
         c = ' ';
     rval = _get_raw_glyph_bytes( &PDC_font_info, c);
+    if( PDC_font_info.n_styles > 1)     /* compiled font,  with bold and */
+    {                                   /* italic glyphs already made */
+        const int style = ((ch & A_BOLD) ? 1 : 0) | ((ch & A_ITALIC) ? 2 : 0);
+
+        rval += style * PDC_font_info.n_glyphs * PDC_font_info.charsize;
+        styled = TRUE;
+    }
 #ifdef USING_COMBINING_CHARACTER_SCHEME
-    if( cursor_type || (ch & (LINE_ATTRIBS | A_BOLD | A_ITALIC)) || root)
+    if( cursor_type || (ch & LINE_ATTRIBS) || root
+                || (!styled && (ch & (A_BOLD | A_ITALIC))))
 #else
-    if( cursor_type || (ch & (LINE_ATTRIBS | A_BOLD | A_ITALIC)))
+    if( cursor_type || (ch & LINE_ATTRIBS)
+                || (!styled && (ch & (A_BOLD | A_ITALIC))))
 #endif
     {
         const int font_char_size_in_bytes = (PDC_font_info.width + 7) >> 3;
@@ -258,20 +287,10 @@ static const uint8_t *_get_glyph( const chtype ch, const int cursor_type,
 
         memcpy( scratch, rval, PDC_font_info.charsize);
         rval = (const uint8_t *)scratch;
-        if( ch & A_BOLD)
-            for( i = PDC_font_info.charsize - 1; i >= 0; i--)
-            {
-                scratch[i] |= (scratch[i] >> 1);
-                if( (i % font_char_size_in_bytes) && (scratch[i - 1] & 1))
-                   scratch[i] |= 0x80;
-            }
-        if( ch & A_ITALIC)  /* shift half top of glyph by one pixel right */
-            for( i = (PDC_font_info.height / 2) * font_char_size_in_bytes; i >= 0; i--)
-            {
-                scratch[i] >>= 1;
-                if( (i % font_char_size_in_bytes) && (scratch[i - 1] & 1))
-                   scratch[i] |= 0x80;
-            }
+        if( !styled && (ch & A_BOLD))
+            embolden_glyph( scratch, &PDC_font_info);
+        if( !styled && (ch & A_ITALIC))
+            italicize_glyph( scratch, &PDC_font_info);
 #ifdef USING_COMBINING_CHARACTER_SCHEME
         if( root)
         {
@@ -332,34 +351,13 @@ order from what the other platforms expect : */
 
 #define SWAP_RED_AND_BLUE( rgb) (((rgb) & 0xff00) | ((rgb) >> 16) | (((rgb) & 0xff) << 16))
 
-void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
+static void _draw_run( const int lineno, int x, int len, const chtype *srcp,
+                       const int cursor_to_draw)
 {
     const int font_char_size_in_bytes = (PDC_font_info.width + 7) >> 3;
-    int cursor_to_draw = 0;
     const int line_len = PDC_fb.line_length * 8 / PDC_fb.bits_per_pixel;
     uint8_t scratch[300];
 
-    assert( srcp);
-    assert( x >= 0);
-    assert( len <= SP->cols - x);
-    assert( lineno >= 0);
-    assert( lineno < SP->lines);
-    assert( len > 0);
-    if( lineno == SP->cursrow && x <= SP->curscol && x + len > SP->curscol)
-    {
-        cursor_to_draw = (PDC_blink_state ? SP->visibility & 0xff : (SP->visibility >> 8));
-        if( cursor_to_draw)   /* if there's a cursor appearing in this run of text... */
-        {
-            if( x < SP->curscol)  /* ...draw the part _before_ the cursor (if any)... */
-                PDC_transform_line( lineno, x, SP->curscol - x, srcp);
-            len -= SP->curscol - x;
-            srcp += SP->curscol - x;
-            x = SP->curscol;
-            if( len > 1)          /* ...then the part _after the cursor (if any)... */
-                PDC_transform_line( lineno, x + 1, len - 1, srcp + 1);
-            len = 1;    /* ... then fall through and just draw the cell with the cursor */
-        }
-    }
     while( len)
     {
         int run_len = 0, x1, y1;
@@ -407,7 +405,8 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
             fg = bg;
             bg = temp_rgb;
         }
-        while( run_len < len && !((*srcp ^ srcp[run_len]) & A_ATTRIBUTES))
+        while( run_len < len && !((*srcp ^ srcp[run_len])
+                                 & (A_ATTRIBUTES | A_DIRECT_COLOR)))
             run_len++;
         if( PDC_fb.bits_per_pixel == 32)
         {
@@ -484,6 +483,260 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
     }
 }
 
+#ifdef PDC_RENDER_POOL
+
+/* On a big panel,  rasterizing glyphs is most of the work of a repaint.
+So in PDC_RENDER_POOL builds (make RENDER_THREADS=Y;  this needs only
+pthreads,  not the PDC_THREADS locking),  PDC_transform_line() just
+queues each run (with a copy of its cells,  since the core reuses the
+buffers it passes in),  and _finish_queued_runs() -- called from
+PDC_doupdate(),  and after the port's own drawing outside doupdate() --
+has a pool of threads rasterize them.  Thread n draws the runs on rows
+where (lineno % n_threads) == n,  in the order they were queued,  so runs
+on one row never race,  and different rows never share pixels.  The
+calling thread is thread 0.
+
+   The pool is started the first time it's needed,  with one thread per
+online CPU (at most MAX_RENDER_THREADS),  or as many as the environment
+variable PDC_RENDER_THREADS says;  1 turns it off.  Frames of fewer than
+MIN_THREADED_CELLS cells aren't worth waking the pool for,  and runs with
+direct colors (which are in a ring the core reuses) are drawn right away,
+after whatever was queued before them. */
+
+#define MAX_RENDER_THREADS      16
+#define MIN_THREADED_CELLS     512
+
+typedef struct
+{
+    int lineno, x, len, cursor_to_draw;
+    size_t offset;                      /* into _queued_cells[] */
+} QUEUED_RUN;
+
+static QUEUED_RUN *_queued_runs;
+static chtype *_queued_cells;
+static int _n_queued_runs, _n_runs_alloced;
+static size_t _n_queued_cells, _n_cells_alloced;
+static int _n_render_threads = 0;      /* 0 = pool not started yet */
+static int _render_generation, _n_busy_threads;
+static bool _render_threads_quit;
+static pthread_t _render_threads[MAX_RENDER_THREADS];
+static pthread_mutex_t _render_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _render_start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t _render_done = PTHREAD_COND_INITIALIZER;
+
+static void _draw_queued_rows( const int thread_num)
+{
+    int i;
+
+    for( i = 0; i < _n_queued_runs; i++)
+    {
+        const QUEUED_RUN *run = _queued_runs + i;
+
+        if( run->lineno % _n_render_threads == thread_num)
+            _draw_run( run->lineno, run->x, run->len,
+                       _queued_cells + run->offset, run->cursor_to_draw);
+    }
+}
+
+static void *_render_thread( void *arg)
+{
+    const int thread_num = (int)(intptr_t)arg;
+    int generation = 0;
+
+    pthread_mutex_lock( &_render_lock);
+    while( !_render_threads_quit)
+    {
+        if( generation == _render_generation)
+            pthread_cond_wait( &_render_start, &_render_lock);
+        else
+        {
+            generation = _render_generation;
+            pthread_mutex_unlock( &_render_lock);
+            _draw_queued_rows( thread_num);
+            pthread_mutex_lock( &_render_lock);
+            if( !--_n_busy_threads)
+                pthread_cond_signal( &_render_done);
+        }
+    }
+    pthread_mutex_unlock( &_render_lock);
+    return( NULL);
+}
+
+static void _start_render_threads( void)
+{
+    const char *env = getenv( "PDC_RENDER_THREADS");
+    int n_threads = (env ? atoi( env) : (int)sysconf( _SC_NPROCESSORS_ONLN));
+
+    if( n_threads > MAX_RENDER_THREADS)
+        n_threads = MAX_RENDER_THREADS;
+    _render_generation = 0;
+    _render_threads_quit = FALSE;
+    for( _n_render_threads = 1; _n_render_threads < n_threads; _n_render_threads++)
+        if( pthread_create( _render_threads + _n_render_threads, NULL,
+                    _render_thread, (void *)(intptr_t)_n_render_threads))
+            break;
+}
+
+/* Called from PDC_scr_close() :  stops the pool and frees the queue.
+The pool is restarted if anything is drawn afterward. */
+
+void PDC_free_render_threads( void)
+{
+    int i;
+
+    _finish_queued_runs( );
+    pthread_mutex_lock( &_render_lock);
+    _render_threads_quit = TRUE;
+    pthread_cond_broadcast( &_render_start);
+    pthread_mutex_unlock( &_render_lock);
+    for( i = 1; i < _n_render_threads; i++)
+        pthread_join( _render_threads[i], NULL);
+    _n_render_threads = 0;
+    free( _queued_runs);
+    free( _queued_cells);
+    _queued_runs = NULL;
+    _queued_cells = NULL;
+    _n_runs_alloced = 0;
+    _n_cells_alloced = 0;
+}
+
+static void _finish_queued_runs( void)
+{
+    int i;
+
+    if( !_n_queued_runs)
+        return;
+    if( _n_render_threads > 1 && _n_queued_cells >= MIN_THREADED_CELLS)
+    {
+        pthread_mutex_lock( &_render_lock);
+        _n_busy_threads = _n_render_threads - 1;
+        _render_generation++;
+        pthread_cond_broadcast( &_render_start);
+        pthread_mutex_unlock( &_render_lock);
+        _draw_queued_rows( 0);
+        pthread_mutex_lock( &_render_lock);
+        while( _n_busy_threads)
+            pthread_cond_wait( &_render_done, &_render_lock);
+        pthread_mutex_unlock( &_render_lock);
+    }
+    else
+        for( i = 0; i < _n_queued_runs; i++)
+            _draw_run( _queued_runs[i].lineno, _queued_runs[i].x,
+                       _queued_runs[i].len,
+                       _queued_cells + _queued_runs[i].offset,
+                       _queued_runs[i].cursor_to_draw);
+    _n_queued_runs = 0;
+    _n_queued_cells = 0;
+}
+
+static void _queue_run( const int lineno, const int x, const int len,
+                        const chtype *srcp, const int cursor_to_draw)
+{
+    QUEUED_RUN *run;
+    int i;
+
+    if( !_n_render_threads)
+        _start_render_threads( );
+    if( _n_render_threads < 2)
+    {
+        _draw_run( lineno, x, len, srcp, cursor_to_draw);
+        return;
+    }
+    if( SP->direct_rgb)
+        for( i = 0; i < len; i++)
+            if( srcp[i] & A_DIRECT_COLOR)
+            {
+                _finish_queued_runs( );
+                _draw_run( lineno, x, len, srcp, cursor_to_draw);
+                return;
+            }
+    if( _n_queued_runs == _n_runs_alloced)
+    {
+        const int new_size = (_n_runs_alloced ? _n_runs_alloced * 2 : 256);
+        QUEUED_RUN *new_runs = (QUEUED_RUN *)realloc( _queued_runs,
+                                         new_size * sizeof( QUEUED_RUN));
+
+        if( new_runs)
+        {
+            _queued_runs = new_runs;
+            _n_runs_alloced = new_size;
+        }
+    }
+    if( _n_queued_cells + len > _n_cells_alloced)
+    {
+        size_t new_size = (_n_cells_alloced ? _n_cells_alloced : 4096);
+        chtype *new_cells;
+
+        while( new_size < _n_queued_cells + len)
+            new_size *= 2;
+        new_cells = (chtype *)realloc( _queued_cells, new_size * sizeof( chtype));
+        if( new_cells)
+        {
+            _queued_cells = new_cells;
+            _n_cells_alloced = new_size;
+        }
+    }
+    if( _n_queued_runs == _n_runs_alloced
+                 || _n_queued_cells + len > _n_cells_alloced)
+    {                      /* out of memory : just draw it now */
+        _finish_queued_runs( );
+        _draw_run( lineno, x, len, srcp, cursor_to_draw);
+        return;
+    }
+    run = _queued_runs + _n_queued_runs++;
+    run->lineno = lineno;
+    run->x = x;
+    run->len = len;
+    run->cursor_to_draw = cursor_to_draw;
+    run->offset = _n_queued_cells;
+    memcpy( _queued_cells + _n_queued_cells, srcp, len * sizeof( chtype));
+    _n_queued_cells += len;
+}
+#else
+void PDC_free_render_threads( void)
+{
+}
+
+static void _finish_queued_runs( void)
+{
+}
+#endif
+
+void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
+{
+    int cursor_to_draw = 0;
+
+    if( PDC_lazy_setup_pending)
+        PDC_lazy_setup( );
+    assert( srcp);
+    assert( x >= 0);
+    assert( len <= SP->cols - x);
+    assert( lineno >= 0);
+    assert( lineno < SP->lines);
+    assert( len > 0);
+    if( lineno == SP->cursrow && x <= SP->curscol && x + len > SP->curscol)
+    {
+        cursor_to_draw = (PDC_blink_state ? SP->visibility & 0xff : (SP->visibility >> 8));
+        if( cursor_to_draw)   /* if there's a cursor appearing in this run of text... */
+        {
+            if( x < SP->curscol)  /* ...draw the part _before_ the cursor (if any)... */
+                PDC_transform_line( lineno, x, SP->curscol - x, srcp);
+            len -= SP->curscol - x;
+            srcp += SP->curscol - x;
+            x = SP->curscol;
+            if( len > 1)          /* ...then the part _after the cursor (if any)... */
+                PDC_transform_line( lineno, x + 1, len - 1, srcp + 1);
+            len = 1;    /* ... then fall through and just draw the cell with the cursor */
+        }
+    }
+#ifdef PDC_RENDER_POOL
+    _queue_run( lineno, x, len, srcp, cursor_to_draw);
+#else
+    _draw_run( lineno, x, len, srcp, cursor_to_draw);
+#endif
+}
+
 void PDC_doupdate(void)
 {
+    _finish_queued_runs( );
 }
@@ -8,6 +8,7 @@
 #endif
 
 void PDC_puts_to_stdout( const char *buff);        /* pdcdisp.c */
+void PDC_free_render_threads( void);               /* pdcdisp.c */
 
 struct video_info
 {
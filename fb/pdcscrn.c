@@ -6,6 +6,7 @@
 #include <termios.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <fcntl.h>
 #include "pdcfb.h"
 #include "psf.c"
@@ -22,11 +23,17 @@ struct video_info PDC_fb;
 #else
    #include "../dosvga/font.h"
 #endif
+#ifdef PDC_COMPILED_FONTS
+   #include "pdcfonts.h"
+#else
+   #define N_COMPILED_FONTS 0
+#endif
 
 static struct termios orig_term;
 
 #include <assert.h>
 #include "curspriv.h"
+#include "../vt/pdcvt.h"
 #include "../common/pdccolor.h"
 #include "../common/pdccolor.c"
 
@@ -34,7 +41,6 @@ static struct termios orig_term;
 int PDC_expand_combined_characters( const cchar_t c, cchar_t *added);
 #endif
 
-int PDC_rows = -1, PDC_cols = -1;
 bool PDC_resize_occurred = FALSE;
 const int STDIN = 0;
 chtype PDC_capabilities = 0;
@@ -62,6 +68,7 @@ void PDC_reset_prog_mode( void)
     SP->_trap_mbe = _stored_trap_mbe;
     PDC_mouse_set( );          /* clear any mouse event captures */
     PDC_resize_occurred = FALSE;
+    PDC_watch_input( TRUE);
 }
 
 void PDC_reset_shell_mode( void)
@@ -71,7 +78,7 @@ void PDC_reset_shell_mode( void)
 int PDC_resize_screen(int nlines, int ncols)
 {
 #ifdef NO_RESIZING_YET
-   if( PDC_rows == -1)     /* initscr( ) hasn't been called;  we're just */
+   if( !SP || !SP->port)   /* initscr( ) hasn't been called;  we're just */
       {                    /* setting desired size at startup */
       initial_PDC_rows = nlines;
       initial_PDC_cols = ncols;
@@ -80,8 +87,8 @@ int PDC_resize_screen(int nlines, int ncols)
       {
       char tbuff[50];
 
-      PDC_rows = nlines;
-      PDC_cols = ncols;
+      SP->port->rows = nlines;
+      SP->port->cols = ncols;
       }
 #else
     INTENTIONALLY_UNUSED_PARAMETER( nlines);
@@ -102,20 +109,44 @@ void PDC_save_screen_mode(int i)
 
 bool PDC_has_rgb_color = TRUE;
 struct font_info PDC_font_info;
-static uint8_t *_loaded_font_bytes;
+static uint8_t *_rotated_font_bytes;
+
+/* Fonts are parsed (and their glyph indices built) once,  the first time
+they're used,  and kept around so that PDC_cycle_font() can switch between
+them cheaply.  Font 0 is the built-in one;  fonts 1 to 9 come from the
+PDC_FONT and PDC_FONT2...PDC_FONT9 environment variables,  and are mmap()ed
+rather than read into memory.  If the library was built with fonts
+compiled in (COMPILED_FONTS=Y;  see psf2c.c),  those replace the built-in
+font as fonts 0 to N_COMPILED_FONTS - 1,  and the PDC_FONTx ones follow. */
+
+#define FIRST_FILE_FONT (N_COMPILED_FONTS ? N_COMPILED_FONTS : 1)
+#define MAX_FONTS (FIRST_FILE_FONT + 9)
 
-static void _unload_font( void)
+static struct
 {
-   if( _loaded_font_bytes)
-   {
-      free( _loaded_font_bytes);
-      _loaded_font_bytes = NULL;
-   }
-   if( PDC_font_info.unicode_info)
+   struct font_info info;
+   void *map;
+   size_t map_len;
+   bool loaded, indexed;
+} _fonts[MAX_FONTS];
+
+static void _unload_fonts( void)
+{
+   int i;
+
+   for( i = 0; i < MAX_FONTS; i++)
+      {
+      free_psf_or_vgafont( &_fonts[i].info);
+      if( _fonts[i].map)
+         munmap( _fonts[i].map, _fonts[i].map_len);
+      }
+   memset( _fonts, 0, sizeof( _fonts));
+   if( _rotated_font_bytes)
    {
-      free( PDC_font_info.unicode_info);
-      PDC_font_info.unicode_info = NULL;
+      free( _rotated_font_bytes);
+      _rotated_font_bytes = NULL;
    }
+   PDC_font_info.glyphs = NULL;
 }
 
 #ifndef USE_DRM
@@ -131,8 +162,10 @@ void PDC_scr_close( void)
    SP->_trap_mbe = 0;
    PDC_mouse_set( );          /* clear any mouse event captures */
    tcsetattr( STDIN, TCSANOW, &orig_term);
+   PDC_watch_input( FALSE);
    PDC_draw_rectangle( 0, 0, PDC_fb.xres, PDC_fb.yres, 0);
    PDC_doupdate( );
+   PDC_free_render_threads( );
    PDC_puts_to_stdout( NULL);      /* free internal cache */
 #ifdef USE_DRM
    close_drm( );
@@ -140,7 +173,7 @@ void PDC_scr_close( void)
    munmap( PDC_fb.framebuf, PDC_fb.smem_len);
    close( _framebuffer_fd);
 #endif
-   _unload_font( );
+   _unload_fonts( );
    return;
 }
 
@@ -150,6 +183,8 @@ void PDC_scr_free( void)
 #ifdef USING_COMBINING_CHARACTER_SCHEME
     PDC_expand_combined_characters( 0, NULL);
 #endif
+    free( SP->port);
+    SP->port = NULL;
 }
 
 int PDC_n_ctrl_c = 0;
@@ -193,19 +228,20 @@ this function two or three times. */
 void PDC_rotate_font( void)
 {
    struct font_info new_font;
-   uint32_t i;
+   uint32_t i, n_glyphs = PDC_font_info.n_glyphs * PDC_font_info.n_styles;
    int stride, ostride;
    uint8_t *new_glyphs;
 
+   PDC_doupdate( );        /* draw anything queued with the old font */
    memcpy( &new_font, &PDC_font_info, sizeof( struct font_info));
    new_font.height = PDC_font_info.width;
    new_font.width = PDC_font_info.height;
    stride = (PDC_font_info.width + 7) >> 3;
    ostride = (new_font.width + 7) >> 3;
    new_font.charsize = ostride * new_font.height;
-   new_glyphs = (uint8_t *)calloc( new_font.charsize * new_font.n_glyphs, 1);
+   new_glyphs = (uint8_t *)calloc( new_font.charsize * n_glyphs, 1);
    new_font.glyphs = new_glyphs;
-   for( i = 0; i < new_font.n_glyphs; i++)
+   for( i = 0; i < n_glyphs; i++)
       {
       int x, y;
       const uint8_t *src = PDC_font_info.glyphs + i * PDC_font_info.charsize;
@@ -221,84 +257,170 @@ void PDC_rotate_font( void)
    PDC_orientation = (PDC_orientation + 1) & 3;
    if( PDC_orientation & 1)
       {
-      PDC_rows = PDC_fb.xres / PDC_font_info.width;
-      PDC_cols = PDC_fb.yres / PDC_font_info.height;
+      SP->port->rows = PDC_fb.xres / PDC_font_info.width;
+      SP->port->cols = PDC_fb.yres / PDC_font_info.height;
       }
    else
       {
-      PDC_cols = PDC_fb.xres / PDC_font_info.width;
-      PDC_rows = PDC_fb.yres / PDC_font_info.height;
+      SP->port->cols = PDC_fb.xres / PDC_font_info.width;
+      SP->port->rows = PDC_fb.yres / PDC_font_info.height;
       }
    PDC_resize_occurred = TRUE;
-   SP->cols = PDC_cols;
-   SP->lines = PDC_rows;
+   SP->cols = SP->port->cols;
+   SP->lines = SP->port->rows;
    if (SP)
        SP->resized = TRUE;
-   if( _loaded_font_bytes)
-      free( _loaded_font_bytes);
-   _loaded_font_bytes = new_glyphs;
+   if( _rotated_font_bytes)
+      free( _rotated_font_bytes);
+   _rotated_font_bytes = new_glyphs;
    _clear_unused_part_of_screen( );
 }
 
-static int _load_psf_font( const int font_num)
+static int _parse_psf_font( const int font_num)
 {
-    int rval;
+    struct font_info *f = &_fonts[font_num].info;
 
-    _unload_font( );
-    PDC_font_info.glyphs = NULL;
+#ifdef PDC_COMPILED_FONTS
+    if( font_num < N_COMPILED_FONTS)
+    {
+        load_compiled_font( f, PDC_compiled_fonts + font_num);
+#ifndef PDC_WIDE
+        if( PDC_compiled_fonts[font_num].cp437_index)
+            f->page_map = NULL;      /* narrow builds use CP437 as-is */
+#endif
+        _fonts[font_num].loaded = TRUE;
+        return( 0);
+    }
+#endif
     if( !font_num)
-        load_psf_or_vgafont( &PDC_font_info, font_bytes, sizeof( font_bytes));
+        load_psf_or_vgafont( f, font_bytes, sizeof( font_bytes));
     else
     {
         char env_var[20];
         const char *font_filename;
+        int fd;
+        struct stat st;
+        void *map;
 
         strcpy( env_var, "PDC_FONT");
-        if( font_num > 1)
+        if( font_num > FIRST_FILE_FONT)
         {
-            env_var[8] = (char)( font_num + '0');
+            env_var[8] = (char)( font_num - FIRST_FILE_FONT + '1');
             env_var[9] = '\0';
         }
         font_filename = getenv( env_var);
-        if( font_filename)
+        if( !font_filename)
+            return( -1);
+        fd = open( font_filename, O_RDONLY);
+        if( fd < 0)
+            return( -2);
+        if( fstat( fd, &st) || st.st_size < 4)
+        {
+            close( fd);
+            return( -3);
+        }
+        map = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close( fd);
+        if( map == MAP_FAILED)
+            return( -4);
+        if( load_psf_or_vgafont( f, (const uint8_t *)map, (long)st.st_size))
         {
-            FILE *font_fp = fopen( font_filename, "rb");
-
-            if( font_fp)
-            {
-                uint8_t *buff;
-                long n_bytes;
-
-                fseek( font_fp, 0L, SEEK_END);
-                n_bytes = ftell( font_fp);
-                fseek( font_fp, 0L, SEEK_SET);
-                buff = (uint8_t *)malloc( n_bytes + 1);
-                buff[n_bytes] = '\0';
-                if( fread( buff, 1, n_bytes, font_fp) != (size_t)n_bytes)
-                    return( -5);
-                fclose( font_fp);
-                if( !load_psf_or_vgafont( &PDC_font_info, buff, n_bytes))
-                {
-                    uint32_t glyph_buff_size = PDC_font_info.n_glyphs * PDC_font_info.charsize;
-
-                    _loaded_font_bytes = (uint8_t *)malloc( glyph_buff_size);
-
-                    memcpy( _loaded_font_bytes, PDC_font_info.glyphs, glyph_buff_size);
-                    PDC_font_info.glyphs = _loaded_font_bytes;
-                }
-                free( buff);
-            }
+            munmap( map, (size_t)st.st_size);
+            memset( f, 0, sizeof( struct font_info));
+            return( -5);
         }
+        _fonts[font_num].map = map;
+        _fonts[font_num].map_len = (size_t)st.st_size;
     }
 
+    _fonts[font_num].loaded = TRUE;
+    return( 0);
+}
+
+#ifndef USE_DRM
+static bool _hw_palette_loaded;
+
+static void _load_hw_palette( void)
+{
+    uint16_t r[256], g[256], b[256];
+    struct fb_cmap pal;
+    int i;
+
+    for( i = 0; i < 256; i++)
+    {
+        const PACKED_RGB col = PDC_get_palette_entry( i);
+
+        r[i] = (uint16_t)( Get_RValue( col) * 257);
+        g[i] = (uint16_t)( Get_GValue( col) * 257);
+        b[i] = (uint16_t)( Get_BValue( col) * 257);
+    }
+    pal.start = 0;
+    pal.len = 256;
+    pal.red   = r;
+    pal.green = g;
+    pal.blue  = b;
+    pal.transp = NULL;
+    if( ioctl( _framebuffer_fd, FBIOPUTCMAP, &pal))
+        fprintf( stderr, "Error setting palette.\n");
+    _hw_palette_loaded = TRUE;
+}
+#endif
+
+/* A font's Unicode-to-glyph index,  and an 8-bit framebuffer's hardware
+palette,  aren't needed until something is drawn.  So rather than at
+startup or when the font changes,  they're set up by PDC_lazy_setup(),
+which PDC_transform_line() calls when PDC_lazy_setup_pending is set. */
+
+bool PDC_lazy_setup_pending = TRUE;
+
+void PDC_lazy_setup( void)
+{
+    struct font_info *f = &_fonts[curr_font].info;
+    uint64_t t = PDC_startup_clock( );
+
+    if( !_fonts[curr_font].indexed)
+    {
 #ifdef PDC_WIDE
             /* If there's no Unicode info,  the font is probably a CP437 one. */
             /* We can use the data in uni_info.h to make the translations. */
-    if( !PDC_font_info.unicode_info)
-       PDC_font_info.unicode_info =  _decipher_psf2_unicode_table(
-               font_bytes + UNICODE_INFO_OFFSET, UNICODE_INFO_SIZE,
-               &PDC_font_info.unicode_info_size);
+        if( !f->unicode_info && !f->page_map)
+            f->unicode_info =  _decipher_psf2_unicode_table(
+                    font_bytes + UNICODE_INFO_OFFSET, UNICODE_INFO_SIZE,
+                    &f->unicode_info_size);
 #endif
+        index_psf_or_vgafont_glyphs( f);
+        _fonts[curr_font].indexed = TRUE;
+        t = PDC_startup_time( "font index (lazy)", t);
+    }
+    PDC_font_info.unicode_info = f->unicode_info;
+    PDC_font_info.unicode_info_size = f->unicode_info_size;
+    PDC_font_info.glyph_index = f->glyph_index;
+    PDC_font_info.n_index_pages = f->n_index_pages;
+#ifndef USE_DRM
+    if( PDC_fb.bits_per_pixel == 8 && !_hw_palette_loaded)
+    {
+        _load_hw_palette( );
+        PDC_startup_time( "hardware palette (lazy)", t);
+    }
+#endif
+    PDC_lazy_setup_pending = FALSE;
+}
+
+static int _load_psf_font( const int font_num)
+{
+    int rval;
+
+    if( font_num >= MAX_FONTS)
+        return( -1);
+    PDC_doupdate( );        /* draw anything queued with the old font */
+    if( !_fonts[font_num].loaded && _parse_psf_font( font_num))
+        return( -1);
+    if( _rotated_font_bytes)
+    {
+        free( _rotated_font_bytes);
+        _rotated_font_bytes = NULL;
+    }
+    memcpy( &PDC_font_info, &_fonts[font_num].info, sizeof( struct font_info));
     if( PDC_font_info.glyphs)
     {
         const int new_cols = PDC_fb.xres / PDC_font_info.width;
@@ -306,8 +428,8 @@ static int _load_psf_font( const int font_num)
         static bool first_load = TRUE;
         int orientation = PDC_orientation;
 
-        PDC_rows = new_rows;
-        PDC_cols = new_cols;
+        SP->port->rows = new_rows;
+        SP->port->cols = new_cols;
         PDC_orientation = 0;
         while( orientation--)
             PDC_rotate_font( );
@@ -320,6 +442,7 @@ static int _load_psf_font( const int font_num)
         first_load = FALSE;
         rval = 0;
         curr_font = font_num;
+        PDC_lazy_setup_pending = TRUE;
         if( !PDC_orientation)
             _clear_unused_part_of_screen( );
     }
@@ -387,6 +510,13 @@ int PDC_scr_open(void)
     assert( SP);
     if (!SP || PDC_init_palette( ))
         return ERR;
+            /* the keyboard/mouse code shared with VT keeps its state here */
+    SP->port = (struct _pdc_port_state *)calloc( 1,
+                                      sizeof( struct _pdc_port_state));
+    if( !SP->port)
+        return ERR;
+    SP->port->rows = SP->port->cols = -1;
+    SP->port->tracking_state = -1;
     setbuf( stdin, NULL);
     sigemptyset(&sa.sa_mask);
     sa.sa_flags = 0;
@@ -396,7 +526,7 @@ int PDC_scr_open(void)
         fprintf( stderr, "Sigaction (INT) failed\n");
         return( -1);
     }
-    if( _load_psf_font( 1))
+    if( _load_psf_font( FIRST_FILE_FONT))
         _load_psf_font( 0);
     SP->mouse_wait = PDC_CLICK_PERIOD;
     SP->visibility = 0;                /* no cursor,  by default */
@@ -407,6 +537,8 @@ int PDC_scr_open(void)
     SP->orig_fore = SP->orig_back = -1;
     SP->termattrs = A_COLOR | WA_ITALIC | WA_UNDERLINE | WA_LEFT | WA_RIGHT |
                     WA_REVERSE | WA_STRIKEOUT | WA_TOP | WA_BLINK | WA_DIM | WA_BOLD;
+    if( PDC_has_rgb_color)       /* 8-bit framebuffers use the palette */
+        SP->termattrs |= WA_DIRECT_COLOR;
 
     SP->lines = PDC_get_rows();
     SP->cols = PDC_get_columns();
@@ -423,16 +555,9 @@ int PDC_scr_open(void)
     }
 
     SP->_preserve = (getenv("PDC_PRESERVE_SCREEN") != NULL);
-    if( PDC_fb.bits_per_pixel == 8)        /* 256 color palette */
-    {
-        int i, r, g, b;
-
-        for( i = 0; i < 256; i++)
-        {
-        PDC_color_content( i, &r, &g, &b);
-        PDC_init_color( i, r, g, b);
-        }
-    }
+#ifndef USE_DRM
+    _hw_palette_loaded = FALSE;     /* see PDC_lazy_setup() */
+#endif
     PDC_reset_prog_mode();
     PDC_LOG(("PDC_scr_open exit\n"));
     return( 0);
@@ -476,8 +601,8 @@ int PDC_init_color( int color, int red, int green, int blue)
     if( !PDC_set_palette_entry( color, new_rgb))
         curscr->_clear = TRUE;
 #ifndef USE_DRM
-    if( PDC_fb.bits_per_pixel == 8)        /* 256 color palette */
-    {
+    if( PDC_fb.bits_per_pixel == 8 && _hw_palette_loaded)
+    {                   /* if not yet loaded,  PDC_lazy_setup() will do it */
         struct fb_cmap pal;
         uint16_t r = (uint16_t)( red * 131 / 2);
         uint16_t g = (uint16_t)( green * 131 / 2);
@@ -12,9 +12,19 @@ https://www.win.tue.nl/~aeb/linux/kbd/font-formats-1.html
    and for the (much simpler) 'vgafont' font format;  see _load_vgafont()
 below. The PSF fonts can contain Unicode information,  a table basically
 saying "Unicode point x corresponds to glyph y".  This code reads that
-information (if it's provided) and sorts it by Unicode point,  so that
-when the glyph for a given Unicode point is desired,  we can
-binary-search for it. */
+information (if it's provided) and sorts it by Unicode point.  Looking
+up glyphs happens for every cell drawn,  so index_psf_or_vgafont_glyphs()
+then turns the sorted list into a two-level table :  one pointer per
+256-code-point page,  each pointing to 256 glyph indices (or NULL if the
+font has nothing in that page).  Only pages the font covers,  in the BMP
+or beyond,  are allocated.  If that can't be done,  we binary-search the
+sorted list instead.
+
+   Fonts can also be compiled into C tables ahead of time by psf2c.c;
+load_compiled_font() then just points a font_info at them,  with no
+parsing,  sorting,  or allocation at all.  Such fonts carry their own
+(const) two-level index,  and bold,  italic and bold italic copies of
+every glyph,  made by the embolden_glyph() and italicize_glyph() below. */
 
 
 #define PSF1_MAGIC0     0x36
@@ -46,11 +56,14 @@ static int _load_psf1( struct font_info *f, const uint8_t *buff, const long file
    struct psf1_header hdr;
    int n_references_found = 0;
 
-   if( buff[0] != PSF1_MAGIC0 && buff[1] != PSF1_MAGIC1)
+   if( filelen < (long)sizeof( hdr)
+            || (buff[0] != PSF1_MAGIC0 && buff[1] != PSF1_MAGIC1))
       return( -1);
    memcpy( &hdr, buff, sizeof( hdr));
    f->font_type = 1;
    f->n_glyphs = ((hdr.mode & PSF1_MODE512) ? 512 : 256);
+   if( filelen < 4 + (long)f->n_glyphs * (long)hdr.charsize)
+      return( -1);          /* truncated:  glyphs run past end of file */
    f->headersize = 4;
    f->charsize = f->height = hdr.charsize;
    f->width = 8;
@@ -63,7 +76,7 @@ static int _load_psf1( struct font_info *f, const uint8_t *buff, const long file
       uint32_t *tptr = (uint32_t *)malloc( max_info_size * 2 * sizeof( uint32_t));
 
       f->unicode_info = tptr;
-      for( ; i < (size_t)filelen; i += 2)
+      for( ; i + 1 < (size_t)filelen; i += 2)
          {
          const unsigned ival = buff[i] | ((unsigned)buff[i + 1] << 8);
 
@@ -132,7 +145,12 @@ static uint32_t *_decipher_psf2_unicode_table( const uint8_t *buff, const size_t
       else if( buff[i] != PSF2_STARTSEQ)
          {
          unsigned cval;    /* decipher UTF8 value */
+         const size_t n_bytes = ((buff[i] & 0xe0) == 0xc0 ? 2 :
+                            ((buff[i] & 0xf0) == 0xe0 ? 3 :
+                            ((buff[i] & 0xf0) == 0xf0 ? 4 : 1)));
 
+         if( i + n_bytes > info_len)      /* truncated table */
+            break;
          if( !(buff[i] & 0x80))           /* plain ASCII */
             cval = (unsigned)buff[i];
          else if( (buff[i] & 0xe0) == 0xc0) /* two-byte UTF8 : code */
@@ -165,10 +183,14 @@ static int _load_psf2( struct font_info *f, const uint8_t *buff, const long file
 {
    struct psf2_header hdr;
 
-   if( buff[0] != PSF2_MAGIC0 || buff[1] != PSF2_MAGIC1
+   if( filelen < (long)sizeof( hdr)
+            || buff[0] != PSF2_MAGIC0 || buff[1] != PSF2_MAGIC1
             || buff[2] != PSF2_MAGIC2 || buff[3] != PSF2_MAGIC3)
       return( -1);
    memcpy( &hdr, buff, sizeof( hdr));
+   if( (uint64_t)hdr.headersize + (uint64_t)hdr.length * hdr.charsize
+                  > (uint64_t)filelen)
+      return( -1);          /* truncated:  glyphs run past end of file */
    f->font_type = 2;
    f->n_glyphs = hdr.length;
    f->headersize = hdr.headersize;
@@ -219,6 +241,11 @@ static int _load_vgafont( struct font_info *f, const uint8_t *buff, const long f
 
 int load_psf_or_vgafont( struct font_info *f, const uint8_t *buff, const long filelen)
 {
+   f->glyph_index = NULL;
+   f->n_index_pages = 0;
+   f->n_styles = 1;
+   f->page_map = NULL;
+   f->page_map_size = 0;
    if( _load_psf1( f, buff, filelen) && _load_psf2( f, buff, filelen)
                      && _load_vgafont( f, buff, filelen))
       return( -1);
@@ -226,11 +253,88 @@ int load_psf_or_vgafont( struct font_info *f, const uint8_t *buff, const long fi
       return( 0);
 }
 
+#define GLYPH_INDEX_PAGES    0x1100      /* 0x110000 / 256 */
+
+static void _free_glyph_index( struct font_info *f)
+{
+   if( f->glyph_index)
+      {
+      uint32_t i;
+
+      for( i = 0; i < f->n_index_pages; i++)
+         if( f->glyph_index[i])
+            free( f->glyph_index[i]);
+      free( f->glyph_index);
+      f->glyph_index = NULL;
+      f->n_index_pages = 0;
+      }
+}
+
+void free_psf_or_vgafont( struct font_info *f)
+{
+   _free_glyph_index( f);
+   if( f->unicode_info)
+      free( f->unicode_info);
+   f->unicode_info = NULL;
+   f->unicode_info_size = 0;
+}
+
+void index_psf_or_vgafont_glyphs( struct font_info *f)
+{
+   uint32_t i;
+
+   if( !f->unicode_info || !f->unicode_info_size || f->glyph_index)
+      return;
+            /* 'unicode_info' is sorted,  so the last point is the highest */
+   f->n_index_pages = (f->unicode_info[(f->unicode_info_size - 1) * 2] >> 8) + 1;
+   if( f->n_index_pages > GLYPH_INDEX_PAGES)
+      f->n_index_pages = GLYPH_INDEX_PAGES;
+   f->glyph_index = (int32_t **)calloc( f->n_index_pages, sizeof( int32_t *));
+   if( !f->glyph_index)
+      f->n_index_pages = 0;
+   for( i = 0; f->glyph_index && i < f->unicode_info_size; i++)
+      {
+      const uint32_t point = f->unicode_info[i * 2];
+      const uint32_t page = point >> 8;
+      int32_t *tptr;
+
+      if( page >= f->n_index_pages)
+         continue;
+      if( !f->glyph_index[page])
+         {
+         f->glyph_index[page] = (int32_t *)malloc( 256 * sizeof( int32_t));
+         if( !f->glyph_index[page])
+            {            /* out of memory : fall back to bsearch() */
+            _free_glyph_index( f);
+            return;
+            }
+         memset( f->glyph_index[page], 0xff, 256 * sizeof( int32_t));
+         }
+      tptr = f->glyph_index[page] + (point & 0xff);
+      if( *tptr < 0)
+         *tptr = (int32_t)f->unicode_info[i * 2 + 1];
+      }
+}
+
 int find_psf_or_vgafont_glyph( struct font_info *f, const uint32_t unicode_point)
 {
    int rval = -1;
 
-   if( f->unicode_info)
+   if( f->page_map)
+      {
+      const uint32_t page = unicode_point >> 8;
+
+      if( page < f->page_map_size && f->page_map[page])
+         rval = (int)f->pages[(f->page_map[page] - 1) * 256 + (unicode_point & 0xff)];
+      }
+   else if( f->glyph_index)
+      {
+      const uint32_t page = unicode_point >> 8;
+
+      if( page < f->n_index_pages && f->glyph_index[page])
+         rval = (int)f->glyph_index[page][unicode_point & 0xff];
+      }
+   else if( f->unicode_info)
       {
       const uint32_t *tptr = (const uint32_t *)bsearch( &unicode_point, f->unicode_info,
                   f->unicode_info_size, 2 * sizeof( uint32_t), _compare_unicode_info);
@@ -242,3 +346,47 @@ int find_psf_or_vgafont_glyph( struct font_info *f, const uint32_t unicode_point
       rval = (int)unicode_point;
    return( rval);
 }
+
+void load_compiled_font( struct font_info *f, const struct compiled_font *cf)
+{
+   memset( f, 0, sizeof( struct font_info));
+   f->font_type = 3;
+   f->n_glyphs = cf->n_glyphs;
+   f->charsize = cf->charsize;
+   f->height = cf->height;
+   f->width = cf->width;
+   f->glyphs = cf->glyphs;
+   f->n_styles = 4;
+   f->page_map_size = cf->page_map_size;
+   f->page_map = cf->page_map;
+   f->pages = cf->pages;
+}
+
+/* Bold glyphs are made by ORing each row with itself shifted one pixel
+right;  italics,  by shifting the top half of the glyph one pixel right. */
+
+void embolden_glyph( uint8_t *glyph, const struct font_info *f)
+{
+   const int stride = (f->width + 7) >> 3;
+   int i;
+
+   for( i = f->charsize - 1; i >= 0; i--)
+      {
+      glyph[i] |= (glyph[i] >> 1);
+      if( (i % stride) && (glyph[i - 1] & 1))
+         glyph[i] |= 0x80;
+      }
+}
+
+void italicize_glyph( uint8_t *glyph, const struct font_info *f)
+{
+   const int stride = (f->width + 7) >> 3;
+   int i;
+
+   for( i = (f->height / 2) * stride; i >= 0; i--)
+      {
+      glyph[i] >>= 1;
+      if( (i % stride) && (glyph[i - 1] & 1))
+         glyph[i] |= 0x80;
+      }
+}
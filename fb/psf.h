@@ -6,8 +6,34 @@ struct font_info {
         uint32_t height, width; /* max dimensions of glyphs */
         uint32_t *unicode_info;
         uint32_t unicode_info_size;
+        int32_t **glyph_index;  /* Unicode -> glyph, in 256-point pages */
+        uint32_t n_index_pages; /* up to the highest page the font has */
         const uint8_t *glyphs;
+        uint32_t n_styles;      /* 4 if bold,  italic,  and bold italic */
+                                /* copies of the glyphs follow them     */
+        uint32_t page_map_size; /* for compiled fonts,  Unicode -> glyph */
+        const uint16_t *page_map;   /* is pages[(page_map[page] - 1) * 256 */
+        const int32_t *pages;       /* + (point & 0xff)];  see psf2c.c     */
+};
+
+/* Fonts compiled to C by psf2c.c.  'glyphs' holds the plain glyphs,
+then bold,  italic,  and bold italic ones.  'cp437_index' is set if the
+font had no Unicode table,  and the index was made from the CP437 one. */
+
+struct compiled_font {
+        const char *name;
+        uint32_t n_glyphs, charsize, height, width;
+        const uint8_t *glyphs;
+        uint32_t page_map_size;
+        const uint16_t *page_map;
+        const int32_t *pages;
+        int cp437_index;
 };
 
 int load_psf_or_vgafont( struct font_info *f, const uint8_t *buff, const long filelen);
 int find_psf_or_vgafont_glyph( struct font_info *f, const uint32_t unicode_point);
+void index_psf_or_vgafont_glyphs( struct font_info *f);
+void free_psf_or_vgafont( struct font_info *f);
+void load_compiled_font( struct font_info *f, const struct compiled_font *cf);
+void embolden_glyph( uint8_t *glyph, const struct font_info *f);
+void italicize_glyph( uint8_t *glyph, const struct font_info *f);
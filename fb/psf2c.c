@@ -0,0 +1,172 @@
+/* Compiles PSF (or 'vgafont') fonts into C tables,  so that they can be
+built into the framebuffer port instead of being read,  parsed,  and
+indexed at startup.  Run as
+
+psf2c font1.psf [font2.psf ...] > pdcfonts.h
+
+   (the Makefile does this for you with COMPILED_FONTS=Y;  set FONTS to
+the list of fonts you want.)  For each font,  the output has :
+
+   -- the glyphs,  followed by bold,  italic,  and bold italic copies of
+them,  made with the same code (in psf.c) the port uses to synthesize
+those styles on the fly.  So drawing bold or italic text with a compiled
+font is just an offset into the glyph data;
+   -- the same two-level Unicode-to-glyph index that psf.c builds at run
+time,  but as const tables :  'page_map' has one entry per 256-point page
+(zero if the font has nothing on that page,  otherwise the page's slot
+number plus one),  and 'pages' has 256 glyph numbers (-1 = no glyph) per
+slot.  Only pages the font covers get slots.
+
+   Fonts without a Unicode table are assumed to be CP437 ones,  just as
+the port does at run time,  and are indexed with the CP437 table from
+psf_wide.h.  Such fonts are flagged with 'cp437_index',  so that narrow
+builds can ignore the index and use the glyphs as-is.
+
+   All of this ends up in a PDC_compiled_fonts[] array,  of length
+N_COMPILED_FONTS;  see pdcscrn.c for how it's used.  This is a host
+tool :  it doesn't use or link to PDCursesMod itself. */
+
+#include <stdio.h>
+#include "psf.c"
+#include "psf_wide.h"
+
+static void _output_bytes( const uint8_t *bytes, const size_t n_bytes)
+{
+   size_t i;
+
+   for( i = 0; i < n_bytes; i++)
+      printf( "%s0x%02x,%s", (i % 16 ? " " : "    "), bytes[i],
+                     (i % 16 == 15 || i == n_bytes - 1) ? "\n" : "");
+}
+
+static const char *_base_name( const char *path)
+{
+   const char *rval = strrchr( path, '/');
+
+   return( rval ? rval + 1 : path);
+}
+
+static int _compile_font( const char *filename, const int font_num)
+{
+   FILE *ifile = fopen( filename, "rb");
+   struct font_info f;
+   uint8_t *buff, *glyph;
+   long filelen;
+   uint32_t i, page, n_pages = 0, n_slots = 0;
+   int style, cp437_index = 0;
+
+   if( !ifile)
+      {
+      fprintf( stderr, "Couldn't open '%s'\n", filename);
+      return( -1);
+      }
+   fseek( ifile, 0L, SEEK_END);
+   filelen = ftell( ifile);
+   fseek( ifile, 0L, SEEK_SET);
+   buff = (uint8_t *)malloc( filelen);
+   if( !buff || !fread( buff, filelen, 1, ifile)
+               || load_psf_or_vgafont( &f, buff, filelen))
+      {
+      fprintf( stderr, "'%s' isn't a PSF or vgafont font\n", filename);
+      free( buff);
+      fclose( ifile);
+      return( -2);
+      }
+   fclose( ifile);
+   if( !f.unicode_info)
+      {
+      f.unicode_info = _decipher_psf2_unicode_table(
+               font_bytes + UNICODE_INFO_OFFSET, UNICODE_INFO_SIZE,
+               &f.unicode_info_size);
+      cp437_index = 1;
+      }
+   index_psf_or_vgafont_glyphs( &f);
+   if( !f.glyph_index)
+      {
+      fprintf( stderr, "Couldn't index '%s'\n", filename);
+      return( -3);
+      }
+
+   printf( "/* %s : %u glyphs,  %u x %u pixels */\n\n", _base_name( filename),
+               (unsigned)f.n_glyphs, (unsigned)f.width, (unsigned)f.height);
+   printf( "static const uint8_t _cfont%d_glyphs[%lu] = {\n", font_num,
+               (unsigned long)f.n_glyphs * f.charsize * 4);
+   glyph = (uint8_t *)malloc( f.charsize);
+   for( style = 0; style < 4; style++)
+      {
+      static const char *style_names[4] = { "plain", "bold", "italic",
+                                             "bold italic" };
+
+      printf( "            /* %s */\n", style_names[style]);
+      for( i = 0; i < f.n_glyphs; i++)
+         {
+         memcpy( glyph, f.glyphs + i * f.charsize, f.charsize);
+         if( style & 1)
+            embolden_glyph( glyph, &f);
+         if( style & 2)
+            italicize_glyph( glyph, &f);
+         _output_bytes( glyph, f.charsize);
+         }
+      }
+   free( glyph);
+   printf( "};\n\n");
+
+   for( page = 0; page < f.n_index_pages; page++)
+      if( f.glyph_index[page])
+         n_pages = page + 1;
+   printf( "static const uint16_t _cfont%d_page_map[%u] = {\n", font_num,
+               (unsigned)n_pages);
+   for( page = 0; page < n_pages; page++)
+      printf( "%s%u,%s", (page % 16 ? " " : "    "),
+               (unsigned)( f.glyph_index[page] ? ++n_slots : 0),
+               (page % 16 == 15 || page == n_pages - 1) ? "\n" : "");
+   printf( "};\n\n");
+
+   printf( "static const int32_t _cfont%d_pages[%lu] = {\n", font_num,
+               (unsigned long)n_slots * 256);
+   for( page = 0; page < n_pages; page++)
+      if( f.glyph_index[page])
+         {
+         printf( "            /* U+%04X */\n", (unsigned)( page << 8));
+         for( i = 0; i < 256; i++)
+            {
+            int32_t glyph_num = f.glyph_index[page][i];
+
+            if( glyph_num >= (int32_t)f.n_glyphs)
+               glyph_num = -1;
+            printf( "%s%d,%s", (i % 16 ? " " : "    "), (int)glyph_num,
+                        (i % 16 == 15) ? "\n" : "");
+            }
+         }
+   printf( "};\n\n");
+
+   printf( "#define CFONT%d { \"%s\", %u, %u, %u, %u, _cfont%d_glyphs, \\\n"
+           "            %u, _cfont%d_page_map, _cfont%d_pages, %d }\n\n",
+               font_num, _base_name( filename),
+               (unsigned)f.n_glyphs, (unsigned)f.charsize,
+               (unsigned)f.height, (unsigned)f.width, font_num,
+               (unsigned)n_pages, font_num, font_num, cp437_index);
+   free_psf_or_vgafont( &f);
+   free( buff);
+   return( 0);
+}
+
+int main( const int argc, const char **argv)
+{
+   int i;
+
+   if( argc < 2)
+      {
+      fprintf( stderr, "Usage:  psf2c font1.psf [font2.psf ...] > pdcfonts.h\n");
+      return( -1);
+      }
+   printf( "/* Made by psf2c from the PSF fonts listed below.  Don't edit. */\n\n");
+   for( i = 1; i < argc; i++)
+      if( _compile_font( argv[i], i - 1))
+         return( -2);
+   printf( "static const struct compiled_font PDC_compiled_fonts[] = {\n");
+   for( i = 1; i < argc; i++)
+      printf( "    CFONT%d%s\n", i - 1, (i < argc - 1 ? "," : ""));
+   printf( "};\n\n#define N_COMPILED_FONTS %d\n", argc - 1);
+   return( 0);
+}
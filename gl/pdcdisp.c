@@ -672,6 +672,8 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
     _new_packet(old_attr, lineno, x, i, srcp);
 }
 
+static SDL_TimerID blinker_id = 0;
+
 static Uint32 _blink_timer(Uint32 interval, void *param)
 {
     SDL_Event event;
@@ -682,40 +684,35 @@ static Uint32 _blink_timer(Uint32 interval, void *param)
     return(interval);
 }
 
-void PDC_blink_text(void)
+static void _stop_blinker(void)
 {
-    static SDL_TimerID blinker_id = 0;
-    int i, j, k;
+    if (blinker_id)
+        SDL_RemoveTimer(blinker_id);
+    blinker_id = 0;
+    blinked_off = FALSE;
+}
+
+/* Only rows that refresh.c has flagged as holding blinking text are
+   redrawn. Once there are none, the timer is stopped, so an idle
+   screen gets no wakeups; PDC_doupdate() restarts it when blinking
+   text is next sent. */
 
+void PDC_blink_text(void)
+{
     oldch = (chtype)(-1);
 
     if (!(SP->termattrs & A_BLINK))
-    {
-        SDL_RemoveTimer(blinker_id);
-        blinker_id = 0;
-    }
+        _stop_blinker();
     else if (!blinker_id)
     {
         blinker_id = SDL_AddTimer(500, _blink_timer, NULL);
-        blinked_off = TRUE;
+        blinked_off = FALSE;
     }
+    else
+        blinked_off = !blinked_off;
 
-    blinked_off = !blinked_off;
-
-    for (i = 0; i < SP->lines; i++)
-    {
-        const chtype *srcp = curscr->_y[i];
-
-        for (j = 0; j < SP->cols; j++)
-            if (srcp[j] & A_BLINK)
-            {
-                k = j;
-                while (k < SP->cols && (srcp[k] & A_BLINK))
-                    k++;
-                PDC_transform_line(i, j, k - j, srcp + j);
-                j = k;
-            }
-    }
+    if (!PDC_redraw_blinking_text())
+        _stop_blinker();
 
     oldch = (chtype)(-1);
 
@@ -732,6 +729,9 @@ void PDC_doupdate(void)
     short hcol = SP->line_color;
     int layer;
 
+    if ((SP->termattrs & A_BLINK) && SP->n_blink_rows && !blinker_id)
+        blinker_id = SDL_AddTimer(500, _blink_timer, NULL);
+
     ensure_glyph_grid(1);
 
     /* Upload grid buffers at the start, before we queue the commands that need
@@ -210,6 +210,7 @@ static void _clean(void)
         pdc_window = NULL;
     }
 
+    PDC_stop_input_ticks();
     SDL_Quit();
     pdc_sheight = pdc_swidth = 0;
 }
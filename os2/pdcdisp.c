@@ -20,11 +20,13 @@ void PDC_gotoyx(int row, int col)
     VioSetCurPos(row, col, 0);
 }
 
+/* PDC_transform_line() breaks runs longer than this */
+
+#define MAX_PACKET_SIZE 256
+
 void _new_packet(attr_t attr, int lineno, int x, int len, const chtype *srcp)
 {
-    /* this should be enough for the maximum width of a screen. */
-
-    char temp_line[256];
+    char temp_line[MAX_PACKET_SIZE];
     int j;
     short fore, back;
     unsigned char mapped_attr;
@@ -85,7 +87,7 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
     {
         attr = srcp[i] & (A_ATTRIBUTES ^ A_ALTCHARSET);
 
-        if (attr != old_attr)
+        if (attr != old_attr || i == MAX_PACKET_SIZE)
         {
             _new_packet(old_attr, lineno, x, i, srcp);
             old_attr = attr;
@@ -650,8 +650,15 @@ int waddch( WINDOW *win, const chtype ch)
 
         /* Only change 'dirty' cells if the character to be added is
            different from the character/attribute that is already in
-           that position in the window. */
+           that position in the window.  With direct colors (see
+           PDC_wset_rgb()),  the colors are in the RGB plane instead. */
 
+        if (text & A_DIRECT_COLOR)
+        {
+            text &= ~A_COLOR;
+            if (PDC_set_cell_rgb( win, &win->_y[y][x]))
+                PDC_mark_cell_as_changed( win, y, x);
+        }
         if (win->_y[y][x] != text)
         {
             PDC_mark_cell_as_changed( win, y, x);
@@ -41,6 +41,9 @@ addchstr
    newline or other special characters, nor does any line wrapping
    occur.
 
+   Cells with A_DIRECT_COLOR set take the window's current direct colors
+   (see PDC_wset_rgb()).
+
 ### Return Value
 
    All functions return OK or ERR.
@@ -89,6 +92,8 @@ int waddchnstr(WINDOW *win, const chtype *ch, int n)
 
     for (; n && *ch; n--, x++, ptr++, ch++)
     {
+        if ((*ch & A_DIRECT_COLOR) && PDC_set_cell_rgb( win, ptr))
+            PDC_mark_cell_as_changed( win, y, x);
         if (*ptr != *ch)
         {
             PDC_mark_cell_as_changed( win, y, x);
@@ -64,6 +64,55 @@ addstr
 
 **man-end****************************************************************/
 
+/* Most strings are mostly printable ASCII,  which waddch() would just
+store with the window's attributes.  So runs of it are copied straight
+into the line here,  with the attributes worked out once and the changed
+cells marked once,  rather than through waddch() a character at a time.
+The last column is left to waddch(),  so that wrapping and scrolling
+happen just as they always have;  so are direct colors.  Returns the
+number of characters added,  which may be zero.  'len' < 0 means "up to
+the first character that isn't printable ASCII". */
+
+static int _add_ascii_run( WINDOW *win, const char *str, int len)
+{
+    const int x = win->_curx, y = win->_cury;
+    chtype attr = win->_attrs, *dest;
+    int i, first = -1, last = -1;
+
+    if( y >= win->_maxy || x >= win->_maxx || y < 0 || x < 0)
+        return( 0);
+    if( len < 0 || len > win->_maxx - 1 - x)
+        len = win->_maxx - 1 - x;
+    if (!(attr & A_COLOR))
+        attr |= win->_bkgd & A_ATTRIBUTES;
+    else
+        attr |= win->_bkgd & (A_ATTRIBUTES ^ A_COLOR);
+    if( attr & A_DIRECT_COLOR)
+        return( 0);
+    dest = win->_y[y] + x;
+    for( i = 0; i < len && str[i] >= ' ' && str[i] < 0x7f; i++)
+    {
+        const chtype text = (str[i] == ' ' ? win->_bkgd & A_CHARTEXT
+                                  : (chtype)str[i]) | attr;
+
+        if( dest[i] != text)
+        {
+            if( first < 0)
+                first = i;
+            last = i;
+            dest[i] = text;
+        }
+    }
+    if( first >= 0)
+        PDC_mark_cells_as_changed( win, y, x + first, x + last);
+    if( i)
+    {
+        win->_curx = x + i;
+        PDC_sync( win);
+    }
+    return( i);
+}
+
 int waddnstr(WINDOW *win, const char *str, int n)
 {
     int i = 0;
@@ -77,16 +126,27 @@ int waddnstr(WINDOW *win, const char *str, int n)
 
     while( (i < n || n < 0) && str[i])
     {
+        const int n_added = _add_ascii_run( win, str + i, (n < 0 ? -1 : n - i));
 #ifdef PDC_WIDE
         wchar_t wch;
-        int retval = PDC_mbtowc(&wch, str + i, n >= 0 ? n - i : 6);
+        int retval;
+#else
+        chtype wch;
+#endif
 
+        if( n_added)
+        {
+            i += n_added;
+            continue;
+        }
+#ifdef PDC_WIDE
+        retval = PDC_mbtowc(&wch, str + i, n >= 0 ? n - i : 6);
         if (retval <= 0)
             return OK;
 
         i += retval;
 #else
-        chtype wch = (unsigned char)(str[i++]);
+        wch = (unsigned char)(str[i++]);
 #endif
         if (waddch(win, wch) == ERR)
             return ERR;
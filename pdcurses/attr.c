@@ -50,6 +50,9 @@ attr
     int underscore(void);
     int wunderscore(WINDOW *win);
 
+    int PDC_set_rgb(int32_t fg, int32_t bg);
+    int PDC_wset_rgb(WINDOW *win, int32_t fg, int32_t bg);
+
 ### Description
 
    These functions manipulate the current attributes and/or colors of
@@ -97,6 +100,21 @@ attr
    wunderscore() turns on the A_UNDERLINE attribute; wunderend() turns
    it off. underscore() and underend() are the stdscr versions.
 
+   PDC_wset_rgb() sets the window's colors directly,  as RGB values from
+   0 to 0xffffff (red in the low byte,  as with init_extended_color()'s
+   colors 256 and up),  instead of through a color pair.  Where the
+   platform supports it (termattrs() includes A_DIRECT_COLOR),  the
+   window's attributes get A_DIRECT_COLOR in place of a color pair,  and
+   the colors of each cell then written with waddch() and friends are
+   kept in an RGB plane alongside the window's lines.  No color pair is
+   allocated,  so pictures and heat maps can use as many colors as they
+   like without filling (and churning) the pair table.  Elsewhere,  a
+   pair is found or allocated with alloc_pair(),  which requires COLORS
+   to include the RGB colors.  Setting a color pair,  or turning off
+   A_DIRECT_COLOR,  ends direct coloring.  Cells drawn by the line and
+   border functions use the background's colors.  PDC_set_rgb() is the
+   stdscr version.
+
 ### Return Value
 
    All functions return OK on success and ERR on error.
@@ -132,6 +150,8 @@ attr
     wunderend                   -       -       Y
     underscore                  -       -       Y
     wunderscore                 -       -       Y
+    PDC_set_rgb                 -       -       -
+    PDC_wset_rgb                -       -       -
 
 **man-end****************************************************************/
 
@@ -143,7 +163,7 @@ int wattroff(WINDOW *win, chtype attrs)
     if (!win)
         return ERR;
 
-    win->_attrs &= (~attrs & A_ATTRIBUTES);
+    win->_attrs &= (~attrs & (A_ATTRIBUTES | A_DIRECT_COLOR));
 
     return OK;
 }
@@ -165,6 +185,8 @@ int wattron(WINDOW *win, chtype attrs)
     if (!win)
         return ERR;
 
+    if (attrs & A_COLOR)
+        win->_attrs &= ~A_DIRECT_COLOR;
     if ((win->_attrs & A_COLOR) && (attrs & A_COLOR))
     {
         oldcolr = win->_attrs & A_COLOR;
@@ -251,7 +273,8 @@ int wcolor_set(WINDOW *win, short color_pair, void *opts)
     if (!win)
         return ERR;
 
-    win->_attrs = (win->_attrs & ~A_COLOR) | COLOR_PAIR(integer_color_pair);
+    win->_attrs = (win->_attrs & ~(A_COLOR | A_DIRECT_COLOR))
+                                 | COLOR_PAIR(integer_color_pair);
 
     return OK;
 }
@@ -428,3 +451,37 @@ int wunderscore(WINDOW *win)
 
     return wattron(win, A_UNDERLINE);
 }
+
+int PDC_wset_rgb(WINDOW *win, const int32_t fg, const int32_t bg)
+{
+    int pair;
+
+    PDC_LOG(("PDC_wset_rgb() - called: fg=%06lx bg=%06lx\n",
+             (long)fg, (long)bg));
+
+    assert( win);
+    if (!win || fg < 0 || fg > 0xffffff || bg < 0 || bg > 0xffffff)
+        return ERR;
+
+    if (SP->termattrs & A_DIRECT_COLOR)
+    {
+        win->_attrs = (win->_attrs & ~A_COLOR) | A_DIRECT_COLOR;
+        win->_direct_rgb = (uint64_t)fg | ((uint64_t)bg << 24);
+        return OK;
+    }
+
+    /* no direct color here;  fall back to a color pair */
+
+    if (COLORS < 256 + 0x1000000
+                || (pair = alloc_pair( (int)fg + 256, (int)bg + 256)) < 0)
+        return ERR;
+
+    return wcolor_set(win, 0, &pair);
+}
+
+int PDC_set_rgb(const int32_t fg, const int32_t bg)
+{
+    PDC_LOG(("PDC_set_rgb() - called\n"));
+
+    return PDC_wset_rgb(stdscr, fg, bg);
+}
@@ -193,6 +193,11 @@ https://www.projectpluto.com/hashing.htm for details.    */
                 if( iter % GROUP_SIZE == 0) idx += iter - GROUP_SIZE;  \
                 idx &= (SP->pair_hash_tbl_size - 1); }
 
+/* Only find_pair() (and therefore alloc_pair()) needs the hash table,
+so it isn't built until one of them is first called;  until then,
+_init_pair_core() leaves it alone.  Programs that only use init_pair()
+never build it at all. */
+
 static void _check_hash_tbl( void)
 {
    assert( SP && SP->pairs);
@@ -347,6 +352,7 @@ static void _init_pair_core(int pair, int fg, int bg)
 
     assert( SP->pairs_allocated);
     assert( pair < COLOR_PAIRS);
+    PDC_RECORD( PDC_record_pair( pair, fg, bg));
     if( pair >= SP->pairs_allocated)
     {
         int i, new_size = SP->pairs_allocated * 2;
@@ -375,8 +381,9 @@ static void _init_pair_core(int pair, int fg, int bg)
     _normalize(&fg, &bg);
 
     refresh_pair = (p->f != UNSET_COLOR_PAIR && (p->f != fg || p->b != bg));
-    _check_hash_tbl( );
-    if( pair && p->f != UNSET_COLOR_PAIR)
+    if( SP->pair_hash_tbl)
+        _check_hash_tbl( );
+    if( SP->pair_hash_tbl && pair && p->f != UNSET_COLOR_PAIR)
     {
        int idx = _hash_color_pair( p->f, p->b), iter;
 
@@ -391,7 +398,7 @@ static void _init_pair_core(int pair, int fg, int bg)
        _unlink_color_pair( pair);
     p->f = fg;
     p->b = bg;
-    if( pair && fg != UNSET_COLOR_PAIR)
+    if( SP->pair_hash_tbl && pair && fg != UNSET_COLOR_PAIR)
     {
        int idx = _hash_color_pair( fg, bg), iter;
 
@@ -407,6 +414,18 @@ static void _init_pair_core(int pair, int fg, int bg)
         _set_cells_to_refresh_for_pair_change( pair);
 }
 
+/* Called when a frame recording starts (see debug.c),  so that it
+includes the pairs that were set up before then. */
+
+void PDC_record_color_pairs( void)
+{
+    int i;
+
+    for( i = 0; i < SP->pairs_allocated; i++)
+        if( SP->pairs[i].f != UNSET_COLOR_PAIR)
+            PDC_record_pair( i, SP->pairs[i].f, SP->pairs[i].b);
+}
+
 int init_extended_pair(int pair, int fg, int bg)
 {
     PDC_LOG(("init_pair() - called: pair %d fg %d bg %d\n", pair, fg, bg));
@@ -441,6 +460,7 @@ int init_extended_color(int color, int red, int green, int blue)
 
     SP->dirty = TRUE;
     curscr->_clear = TRUE;
+    PDC_RECORD( PDC_record_color( color, red, green, blue));
     return PDC_init_color(color, red, green, blue);
 }
 
@@ -618,10 +638,20 @@ int color_content( short color, short *red, short *green, short *blue)
 
 int find_pair( int fg, int bg)
 {
-    int idx = _hash_color_pair( fg, bg), iter;
+    int idx, iter;
 
     assert( SP);
     assert( SP->pairs_allocated);
+    if( !SP->pair_hash_tbl)
+    {
+        const uint64_t t0 = PDC_startup_clock( );
+
+        _check_hash_tbl( );
+        PDC_startup_time( "color pair hash table (lazy)", t0);
+        if( !SP->pair_hash_tbl)
+            return( -1);
+    }
+    idx = _hash_color_pair( fg, bg);
     for( iter = 0; SP->pair_hash_tbl[idx]; iter++)
     {
         int i;
@@ -16,6 +16,11 @@ debug
     void trace( const unsigned);
     void PDC_debug(const char *, ...);
     void _tracef(const char *, ...);
+    int PDC_bintrace_start( const unsigned flags, const int n_records);
+    void PDC_bintrace_stop( void);
+    int PDC_bintrace_dump( const char *filename);
+    int PDC_record_start( const char *filename);
+    void PDC_record_stop( void);
 
 ### Description
 
@@ -42,6 +47,50 @@ debug
    file contents are fflushed after each write. The default is not. Set
    it to enable this (may affect performance).
 
+   PDC_bintrace_start() starts recording fixed-size binary records of
+   selected events (refreshes, lines sent to the platform layer, cursor
+   moves, keystrokes, resizes) into an in-memory ring buffer holding the
+   most recent n_records events (rounded up to a power of two;  zero
+   gets a default of 65536).  Only events in the TRACE_* categories set
+   in 'flags' are recorded.  Unlike traceon(),  this is available in all
+   builds,  and costs only a test of a flag when the category is off.
+   PDC_bintrace_stop() stops recording;  the buffer is kept,  so it can
+   still be dumped,  and is freed when the last SCREEN is deleted.
+   Calling PDC_bintrace_start() again empties the buffer and starts over.
+
+   PDC_bintrace_dump() writes the buffer to a file,  oldest record
+   first.  The program in common/trace2txt.c will convert such a file
+   to text or to Chrome trace (JSON) format.
+
+   If the environment variable PDC_BINTRACE is set when initscr() is
+   called,  it is read as the flags for PDC_bintrace_start() (e.g.,
+   PDC_BINTRACE=0x9c for TRACE_UPDATE | TRACE_MOVE | TRACE_CHARPUT |
+   TRACE_IEVENT),  and the buffer is dumped to "trace.bin" by endwin().
+   Creating further SCREENs with newterm() leaves a running trace alone.
+
+   PDC_record_start() starts writing a compact binary recording of
+   everything drawn to the given file:  every cell sent to the platform
+   layer by doupdate() (and by color pair changes),  the cursor, color
+   pair and palette changes,  resizes,  and keyboard and mouse input,
+   with timestamps.  The program in tests/replay.c plays a recording
+   back through any port as fast as it can,  and reports how long each
+   frame took.  PDC_record_stop() closes the file;  delscreen() of the
+   last remaining SCREEN also does this.  Palette changes made before
+   recording starts are not recorded,  and combined characters are
+   recorded as their base character.  Cells with direct colors (see
+   PDC_wset_rgb()) are recorded with their RGB values.  If the
+   environment variable PDC_RECORD is set when initscr() is called,
+   recording to the file it names starts then;  creating further
+   SCREENs with newterm() leaves a running recording alone.
+
+   If the environment variable PDC_STARTUP_TIMES names a file,
+   newterm() (and so initscr()) appends to it how long each phase of
+   starting up took:  opening the platform layer,  setting up colors,
+   creating curscr and stdscr,  and so on.  Things that are set up
+   lazily,  the first time they're needed (such as the hash table used
+   by find_pair() and alloc_pair(),  and some platforms' fonts and
+   palettes),  add a line when that happens.
+
 ### Portability
                              X/Open  ncurses  NetBSD
     traceon                     -       -       -
@@ -50,6 +99,11 @@ debug
     curses_trace                -       Y       -
     PDC_debug                   -       -       -
     _tracef                     -       Y       -
+    PDC_bintrace_start          -       -       -
+    PDC_bintrace_stop           -       -       -
+    PDC_bintrace_dump           -       -       -
+    PDC_record_start            -       -       -
+    PDC_record_stop             -       -       -
 
 **man-end****************************************************************/
 
@@ -154,3 +208,385 @@ void trace( const unsigned param)
 {
    curses_trace( param);
 }
+
+/* Binary tracing.  Records are written into a ring buffer whose size is
+a power of two;  the write index is claimed with an atomic increment,  so
+there's no locking,  and the index is never reset,  so that the dump can
+tell which records are the oldest.  Timestamps come from the monotonic
+clock if we have one,  else from PDC_millisecs().
+
+   The ring's size,  index and records are published together,  through
+one pointer,  so a recorder always sees a consistent set.  Another thread
+may be past the flag test and about to write a record when tracing is
+stopped or restarted,  so rings are never freed while curses is running:
+stopping just clears the flags,  and a restart with a different size
+keeps the old ring on a 'retired' chain.  PDC_bintrace_free() releases
+them all when the last SCREEN is deleted. */
+
+unsigned PDC_bintrace_flags = 0;
+
+struct _bintrace_ring
+{
+    uint32_t size, next;
+    struct _bintrace_ring *retired;
+    PDC_TRACE_RECORD *records;
+};
+
+static struct _bintrace_ring *_bintrace = NULL;
+
+#define DEFAULT_BINTRACE_RECORDS    65536
+
+#if defined( __GNUC__) || defined( __clang__)
+   #define _ATOMIC_INC( x)   __atomic_fetch_add( &(x), 1, __ATOMIC_RELAXED)
+   #define _ATOMIC_LOAD( x)  __atomic_load_n( &(x), __ATOMIC_ACQUIRE)
+   #define _ATOMIC_STORE( x, val)  __atomic_store_n( &(x), val, __ATOMIC_RELEASE)
+#elif defined( _MSC_VER)
+   #include <intrin.h>
+   #define _ATOMIC_INC( x)   ((uint32_t)_InterlockedIncrement( (volatile long *)&(x)) - 1)
+   #define _ATOMIC_LOAD( x)  (*(volatile struct _bintrace_ring **)&(x))
+   #define _ATOMIC_STORE( x, val)  _InterlockedExchangePointer( (void * volatile *)&(x), val)
+#else
+   #define _ATOMIC_INC( x)   (x)++
+   #define _ATOMIC_LOAD( x)  (x)
+   #define _ATOMIC_STORE( x, val)  (x) = (val)
+#endif
+
+static uint64_t _bintrace_usec( void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec t;
+
+    clock_gettime( CLOCK_MONOTONIC, &t);
+    return( (uint64_t)t.tv_sec * 1000000 + (uint64_t)t.tv_nsec / 1000);
+#else
+    return( (uint64_t)PDC_millisecs( ) * 1000);
+#endif
+}
+
+void PDC_bintrace_record( const int category, const int event,
+                          const long a, const long b, const long c)
+{
+    struct _bintrace_ring *ring = (struct _bintrace_ring *)_ATOMIC_LOAD( _bintrace);
+    PDC_TRACE_RECORD *rec;
+
+    if( !ring)
+        return;
+    rec = ring->records + (_ATOMIC_INC( ring->next) & (ring->size - 1));
+    rec->usec = _bintrace_usec( );
+    rec->event = (uint16_t)event;
+    rec->category = (uint16_t)category;
+    rec->args[0] = (int32_t)a;
+    rec->args[1] = (int32_t)b;
+    rec->args[2] = (int32_t)c;
+}
+
+int PDC_bintrace_start( const unsigned flags, const int n_records)
+{
+    struct _bintrace_ring *ring = _bintrace;
+    uint32_t size = 1;
+
+    PDC_bintrace_stop( );
+    while( size < (uint32_t)(n_records > 0 ? n_records : DEFAULT_BINTRACE_RECORDS))
+        size <<= 1;
+    if( ring && ring->size == size)
+        ring->next = 0;
+    else
+    {
+        ring = (struct _bintrace_ring *)calloc( 1,
+                 sizeof( struct _bintrace_ring) + size * sizeof( PDC_TRACE_RECORD));
+        if( !ring)
+            return( ERR);
+        ring->size = size;
+        ring->records = (PDC_TRACE_RECORD *)( ring + 1);
+        ring->retired = _bintrace;
+        _ATOMIC_STORE( _bintrace, ring);
+    }
+    PDC_bintrace_flags = flags & TRACE_MAXIMUM;
+    return( OK);
+}
+
+void PDC_bintrace_stop( void)
+{
+    PDC_bintrace_flags = 0;
+}
+
+void PDC_bintrace_free( void)
+{
+    PDC_bintrace_flags = 0;
+    while( _bintrace)
+    {
+        struct _bintrace_ring *retired = _bintrace->retired;
+
+        free( _bintrace);
+        _bintrace = retired;
+    }
+}
+
+/* The dump is a 24-byte header -- the eight-byte PDC_BINTRACE_MAGIC,  then
+four uint32_ts : 0x01020304 (so the reader can check byte order),  the
+record size,  the number of records,  and a reserved zero -- followed by
+the records,  in native byte order. */
+
+int PDC_bintrace_dump( const char *filename)
+{
+    const struct _bintrace_ring *ring = _bintrace;
+    uint32_t header[4], n_records, start, next;
+    FILE *ofile;
+    int rval = OK;
+
+    if( !ring || !filename)
+        return( ERR);
+    next = ring->next;
+    if( next > ring->size)
+    {
+        n_records = ring->size;
+        start = next & (ring->size - 1);
+    }
+    else
+    {
+        n_records = next;
+        start = 0;
+    }
+    ofile = fopen( filename, "wb");
+    if( !ofile)
+        return( ERR);
+    header[0] = 0x01020304;
+    header[1] = (uint32_t)sizeof( PDC_TRACE_RECORD);
+    header[2] = n_records;
+    header[3] = 0;
+    if( !fwrite( PDC_BINTRACE_MAGIC, 8, 1, ofile)
+                || !fwrite( header, sizeof( header), 1, ofile))
+        rval = ERR;
+    else if( n_records)
+    {
+        const uint32_t n_at_end = min( n_records, ring->size - start);
+
+        if( !fwrite( ring->records + start, sizeof( PDC_TRACE_RECORD),
+                               n_at_end, ofile))
+            rval = ERR;
+        else if( n_at_end < n_records && !fwrite( ring->records,
+                    sizeof( PDC_TRACE_RECORD), n_records - n_at_end, ofile))
+            rval = ERR;
+    }
+    fclose( ofile);
+    return( rval);
+}
+
+/* Frame recording.  Unlike the binary trace,  this keeps everything
+needed to reproduce the screen:  each doupdate() is written out as the
+runs of cells it sent to the platform layer,  along with the cursor,
+color pair and palette changes,  resizes and input events.  It's
+streamed to the file as it happens,  so recordings can be long.
+
+   The file is PDC_RECORD_MAGIC,  then records of a type byte (one of
+the PDC_REC_xxx values in curspriv.h) followed by unsigned LEB128 varints
+(seven bits per byte,  low bits first).  Signed values are "zigzag"
+encoded (0, -1, 1, -2, ... become 0, 1, 2, 3, ...).  Timestamps are the
+microseconds since the previous timestamp.  The cells of a run are each
+XORed with the previous cell before encoding,  so that a run of text in
+one attribute costs about a byte per cell.  A cell with A_DIRECT_COLOR
+is followed by its colors from curscr's RGB plane (fg | bg << 24),  since
+its color field doesn't hold them.  See tests/replay.c. */
+
+FILE *PDC_record_fp = NULL;
+static uint64_t _record_prev_usec;
+
+#define ZIGZAG( x)       ((unsigned long)(x) << 1 ^ (unsigned long)((x) < 0 ? -1 : 0))
+
+static void _record_varint( uint64_t ival)
+{
+    while( ival >= 0x80)
+    {
+        putc( (int)( ival & 0x7f) | 0x80, PDC_record_fp);
+        ival >>= 7;
+    }
+    putc( (int)ival, PDC_record_fp);
+}
+
+static void _record_time( void)
+{
+    const uint64_t usec = _bintrace_usec( );
+
+    _record_varint( usec - _record_prev_usec);
+    _record_prev_usec = usec;
+}
+
+void PDC_record_size( const int lines, const int cols)
+{
+    putc( PDC_REC_SIZE, PDC_record_fp);
+    _record_varint( lines);
+    _record_varint( cols);
+}
+
+void PDC_record_pair( const int pair, const int fg, const int bg)
+{
+    putc( PDC_REC_PAIR, PDC_record_fp);
+    _record_varint( pair);
+    _record_varint( ZIGZAG( fg));
+    _record_varint( ZIGZAG( bg));
+}
+
+void PDC_record_color( const int color, const int red, const int green,
+                       const int blue)
+{
+    putc( PDC_REC_COLOR, PDC_record_fp);
+    _record_varint( color);
+    _record_varint( ZIGZAG( red));
+    _record_varint( ZIGZAG( green));
+    _record_varint( ZIGZAG( blue));
+}
+
+void PDC_record_frame_begin( const bool clearall)
+{
+    putc( PDC_REC_FRAME_BEGIN, PDC_record_fp);
+    _record_time( );
+    _record_varint( clearall ? 1 : 0);
+}
+
+/* Combined characters are private to this process,  so only the base
+character is recorded. */
+
+void PDC_record_run( const int lineno, const int x, const int len,
+                     const chtype *srcp)
+{
+    const uint64_t *rgb = (curscr->_rgb ? PDC_rgb_cell( curscr, srcp, FALSE)
+                                        : NULL);
+    chtype prev = 0;
+    int i;
+
+    putc( PDC_REC_RUN, PDC_record_fp);
+    _record_varint( lineno);
+    _record_varint( x);
+    _record_varint( len);
+    for( i = 0; i < len; i++)
+    {
+        chtype ch = srcp[i];
+
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+        if( (ch & A_CHARTEXT) > MAX_UNICODE)
+        {
+            cchar_t root = (ch & A_CHARTEXT), added;
+
+            while( (root = PDC_expand_combined_characters( root, &added)) > MAX_UNICODE)
+                ;
+            ch = (ch & ~A_CHARTEXT) | root;
+        }
+#endif
+        _record_varint( (uint64_t)( ch ^ prev));
+        if( ch & A_DIRECT_COLOR)
+            _record_varint( rgb ? rgb[i] : 0);
+        prev = ch;
+    }
+}
+
+void PDC_record_frame_end( const int cursor_y, const int cursor_x,
+                           const int visibility)
+{
+    putc( PDC_REC_FRAME_END, PDC_record_fp);
+    _record_time( );
+    _record_varint( cursor_y);
+    _record_varint( cursor_x);
+    _record_varint( visibility);
+}
+
+void PDC_record_input( const int key)
+{
+    if( key == KEY_MOUSE)
+    {
+        int i;
+
+        putc( PDC_REC_MOUSE, PDC_record_fp);
+        _record_time( );
+        _record_varint( ZIGZAG( SP->mouse_status.x));
+        _record_varint( ZIGZAG( SP->mouse_status.y));
+        _record_varint( SP->mouse_status.changes);
+        for( i = 0; i < 5; i++)
+            _record_varint( (unsigned short)SP->mouse_status.button[i]);
+    }
+    else
+    {
+        putc( PDC_REC_KEY, PDC_record_fp);
+        _record_time( );
+        _record_varint( key);
+        _record_varint( SP->key_modifiers);
+    }
+}
+
+/* The header after the magic gives the chtype size and A_CHARTEXT,  so
+that the replay can check that its build lays out chtypes the same way. */
+
+int PDC_record_start( const char *filename)
+{
+    assert( SP);
+    if( !SP || !filename)
+        return( ERR);
+    PDC_record_stop( );
+    PDC_record_fp = fopen( filename, "wb");
+    if( !PDC_record_fp)
+        return( ERR);
+    setvbuf( PDC_record_fp, NULL, _IOFBF, 65536);
+    fwrite( PDC_RECORD_MAGIC, 8, 1, PDC_record_fp);
+    _record_varint( sizeof( chtype));
+    _record_varint( (uint64_t)A_CHARTEXT);
+    _record_prev_usec = _bintrace_usec( );
+    PDC_record_size( SP->lines, SP->cols);
+    PDC_record_color_pairs( );
+    if( SP->alive)
+        curscr->_clear = TRUE;      /* so the first frame is complete */
+    return( OK);
+}
+
+void PDC_record_stop( void)
+{
+    if( PDC_record_fp)
+        fclose( PDC_record_fp);
+    PDC_record_fp = NULL;
+}
+
+/* Startup timing (see PDC_STARTUP_TIMES above).  PDC_startup_clock()
+returns zero if timing is off,  and PDC_startup_time() then does nothing,
+so callers just do
+
+   const uint64_t t0 = PDC_startup_clock( );
+   (...work...)
+   PDC_startup_time( "phase name", t0);
+
+   PDC_startup_time() returns the time after writing,  so phases can be
+chained without counting the time spent writing the report.  The file is
+opened and closed for each line,  since lazily-set-up things may report
+long after newterm() returns. */
+
+static const char *_startup_times_filename( void)
+{
+    static const char *filename = NULL;
+    static bool checked = FALSE;
+
+    if( !checked)
+    {
+        filename = getenv( "PDC_STARTUP_TIMES");
+        checked = TRUE;
+    }
+    return( filename);
+}
+
+uint64_t PDC_startup_clock( void)
+{
+    return( _startup_times_filename( ) ? _bintrace_usec( ) : 0);
+}
+
+uint64_t PDC_startup_time( const char *phase, const uint64_t since)
+{
+    const char *filename = _startup_times_filename( );
+    FILE *ofile;
+
+    if( !filename || !since)
+        return( 0);
+    ofile = fopen( filename, "a");
+    if( ofile)
+    {
+        fprintf( ofile, "%-30s %9.3f ms\n", phase,
+                          (double)( _bintrace_usec( ) - since) / 1000.);
+        fclose( ofile);
+    }
+    return( _bintrace_usec( ));
+}
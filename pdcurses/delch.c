@@ -55,6 +55,7 @@ int wdelch(WINDOW *win)
     temp1 = &win->_y[y][x];
 
     memmove(temp1, temp1 + 1, (maxx - x) * sizeof(chtype));
+    PDC_copy_rgb( win, temp1, win, temp1 + 1, maxx - x);
 
     /* wrs (4/10/93) account for window background */
 
@@ -25,6 +25,7 @@ getch
 
     unsigned long PDC_get_key_modifiers(void);
     int PDC_return_key_modifiers(bool flag);
+    int PDC_get_input_fd(void);
 
 ### Description
 
@@ -68,13 +69,35 @@ getch
    return modifier keys pressed alone as keystrokes (KEY_ALT_L, etc.).
    These may not work on all platforms.
 
+   PDC_get_input_fd() returns a file descriptor that becomes readable
+   when there may be input, so that PDCursesMod's input can be watched
+   by poll(), select(), epoll, libuv and the like alongside other
+   descriptors. Don't read from it yourself. When it's readable, call
+   wgetch() in nodelay mode until it returns ERR, and only then go back
+   to waiting on the descriptor; input may have been read into internal
+   buffers, and won't make the descriptor readable again. For the same
+   reason, also drain input that way after every refresh() or napms()
+   (or anything else that updates the screen) before waiting: the X11
+   library may have read input while talking to the server, and then
+   the descriptor isn't readable even though input is waiting. It can
+   also become readable without a key resulting. On the VT and
+   framebuffer ports the descriptor is the terminal; on X11, and on SDL2
+   and OpenGL when SDL is using its X11 driver, it's the connection to
+   the X server. That connection doesn't see the cursor and text blink
+   timers, so if something on screen blinks, call wgetch() or napms()
+   every so often anyway. With SDL's other drivers (Wayland, KMSDRM,
+   ...), it's a pipe that a timer makes readable every 20 ms, since
+   those give no descriptor of their own. On other platforms, or before
+   initscr(), it returns -1.
+
    NOTE: getch() and ungetch() are implemented as macros, to avoid
    conflict with many DOS compiler's runtime libraries.
 
 ### Return Value
 
    These functions return ERR or the value of the character, meta
-   character or function key token.
+   character or function key token. PDC_get_input_fd() returns a file
+   descriptor or -1.
 
 ### Portability
                              X/Open  ncurses  NetBSD
@@ -90,10 +113,12 @@ getch
     mvwget_wch                  Y       Y       Y
     unget_wch                   Y       Y       Y
     PDC_get_key_modifiers       -       -       -
+    PDC_get_input_fd            -       -       -
 
 **man-end****************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 
        /* By default,  the PDC_function_key[] array contains 0       */
        /* (i.e., there's no key that's supposed to be returned for   */
@@ -408,7 +433,9 @@ static int _mouse_key(void)
 
 /* ftime() is consided obsolete.  But it's all we have for
 millisecond precision on older compilers/systems.  We'll
-use clock_gettime() or gettimeofday() when available. */
+use clock_gettime() or gettimeofday() when available.  A monotonic
+clock is preferred when there is one,  so that timeouts aren't
+thrown off if someone sets the system clock.  */
 
 #if defined( _POSIX_C_SOURCE) && (_POSIX_C_SOURCE >= 199309L)
    #define CLOCK_GETTIME_AVAILABLE    1
@@ -418,7 +445,20 @@ use clock_gettime() or gettimeofday() when available. */
    #define GETTIMEOFDAY_AVAILABLE    1
 #endif
 
-#if defined( GETTIMEOFDAY_AVAILABLE)
+#ifdef CLOCK_GETTIME_AVAILABLE
+#include <time.h>
+#endif
+
+#if defined( CLOCK_GETTIME_AVAILABLE) && defined( CLOCK_MONOTONIC)
+
+long PDC_millisecs( void)
+{
+    struct timespec t;
+
+    clock_gettime( CLOCK_MONOTONIC, &t);
+    return( (long)t.tv_sec * 1000L + (long)( t.tv_nsec / 1000000));
+}
+#elif defined( GETTIMEOFDAY_AVAILABLE)
 #include <sys/time.h>
 
 long PDC_millisecs( void)
@@ -429,7 +469,6 @@ long PDC_millisecs( void)
     return( t.tv_sec * 1000 + t.tv_usec / 1000);
 }
 #elif defined( CLOCK_GETTIME_AVAILABLE)
-#include <time.h>
 
 long PDC_millisecs( void)
 {
@@ -450,10 +489,31 @@ long PDC_millisecs( void)
 }
 #endif
 
+/* _fast_check_key() only needs to know if the clock has ticked since
+it last looked,  not what time it is.  Linux has a 'coarse' clock for
+just that :  it returns the time as of the last timer tick (every one
+to four milliseconds,  depending on the kernel),  and reading it is
+just a few loads from the vDSO page -- no syscall,  not even a read of
+the CPU's time stamp counter.  Elsewhere,  we use PDC_millisecs(). */
+
+#if defined( CLOCK_GETTIME_AVAILABLE) && defined( CLOCK_MONOTONIC_COARSE)
+static long _coarse_millisecs( void)
+{
+    struct timespec t;
+
+    clock_gettime( CLOCK_MONOTONIC_COARSE, &t);
+    return( (long)t.tv_sec * 1000L + (long)( t.tv_nsec / 1000000));
+}
+#else
+   #define _coarse_millisecs PDC_millisecs
+#endif
+
 /* On many systems,  checking for a key hit is quite slow.  If
 PDC_check_key( ) returns FALSE,  we can safely stop checking for
-a key hit for a millisecond.  This ensures we won't call it more
-than 1000 times per second.
+a key hit until the (coarse) clock ticks.  This ensures we won't call
+it more than 1000 times per second.  (Platforms that can tell cheaply
+that no input has arrived -- see PDC_watch_input( ) in vt/pdckbd.c --
+make the PDC_check_key( ) call itself nearly free.)
 
 On DOS,  it appears that checking the time is so slow that we're
 better off (by a small margin) not using this scheme.  */
@@ -464,7 +524,7 @@ static bool _fast_check_key( void)
     return( PDC_check_key( ));
 #else
     static long prev_millisecond;
-    const long curr_ms = PDC_millisecs( );
+    const long curr_ms = _coarse_millisecs( );
     bool rval;
 
     if( prev_millisecond == curr_ms)
@@ -482,11 +542,89 @@ bool PDC_is_function_key( const int key)
    return( key >= KEY_MIN && key < KEY_MAX);
 }
 
+/* With PDC_MOUSE_COALESCE in the mouse mask,  a run of motion reports
+with the same button state comes back as one KEY_MOUSE at the newest
+position,  and a run of wheel ticks in one direction as one KEY_MOUSE
+(with the tick count in SP->mouse_ticks,  and in the z member of the
+MEVENT from nc_getmouse()).  Only events already queued are merged;  we
+never wait for more.  We can't tell that a run has ended until we've
+read the event after it,  so that one is held in SP until the next
+call.  Events are merged before _mouse_key() filters them. */
+
+static bool _is_mergeable( const MOUSE_STATUS *ms)
+{
+    int i;
+
+    if( ms->changes == PDC_MOUSE_MOVED)
+        return( TRUE);
+    if( ms->changes & WHEEL_EVENTS)
+        return( !(ms->changes & ~WHEEL_EVENTS));
+    if( !(ms->changes & PDC_MOUSE_MOVED))
+        return( FALSE);
+    for( i = 0; i < 3; i++)          /* buttons changed only by moving */
+        if( (ms->changes & (1 << i)) &&
+                (ms->button[i] & BUTTON_ACTION_MASK) != BUTTON_MOVED)
+            return( FALSE);
+    return( !(ms->changes & ~(PDC_MOUSE_MOVED | 7)));
+}
+
+static bool _same_mouse_state( const MOUSE_STATUS *a, const MOUSE_STATUS *b)
+{
+    return( a->changes == b->changes
+            && !memcmp( a->button, b->button, sizeof( a->button)));
+}
+
+static int _get_key( void)
+{
+    int key;
+
+    if( SP->key_held)
+    {
+        SP->key_held = FALSE;
+        key = SP->held_key;
+        SP->key_modifiers = SP->held_key_modifiers;
+        SP->mouse_status = SP->held_mouse_status;
+    }
+    else
+        key = PDC_get_key( );
+    SP->mouse_ticks = 1;
+    if( key == KEY_MOUSE && (SP->_trap_mbe & PDC_MOUSE_COALESCE)
+                && _is_mergeable( &SP->mouse_status))
+        while( PDC_check_key( ))
+        {
+            const MOUSE_STATUS merged = SP->mouse_status;
+            const unsigned long modifiers = SP->key_modifiers;
+            const int next_key = PDC_get_key( );
+
+            if( next_key == KEY_MOUSE
+                        && _same_mouse_state( &merged, &SP->mouse_status))
+            {
+                PDC_TRACE( TRACE_IEVENT, PDC_EV_GETCH, next_key, SP->key_modifiers, 0);
+                if( merged.changes & WHEEL_EVENTS)
+                    SP->mouse_ticks++;
+                continue;         /* keep the newer position */
+            }
+            if( next_key != -1)
+            {
+                SP->key_held = TRUE;
+                SP->held_key = next_key;
+                SP->held_key_modifiers = SP->key_modifiers;
+                SP->held_mouse_status = SP->mouse_status;
+            }
+            SP->mouse_status = merged;
+            SP->key_modifiers = modifiers;
+            if( next_key != -1)
+                break;
+        }
+    return( key);
+}
+
 #define WAIT_FOREVER    -1
 
 static int _raw_wgetch_no_surrogate_pairs( WINDOW *win)
 {
     int key = ERR, remaining_millisecs;
+    long deadline = 0;
 
     PDC_LOG(("_raw_wgetch_no_surrogate_pairs() - called\n"));
 
@@ -531,37 +669,44 @@ static int _raw_wgetch_no_surrogate_pairs( WINDOW *win)
     SP->c_pindex = 0;
     SP->c_gindex = 0;
 
+    if( remaining_millisecs != WAIT_FOREVER)
+        deadline = PDC_millisecs( ) + remaining_millisecs;
+
     /* to get here, no keys are buffered. go and get one. */
 
     for (;;)            /* loop for any buffering */
     {
         /* is there a keystroke ready? */
 
-        while( !_fast_check_key())
+        while( !SP->key_held && !_fast_check_key())
         {
-            /* if not, handle timeout() and halfdelay() */
-            int nap_time = 50;
+            /* if not, handle timeout() and halfdelay(),  then block
+               until the platform sees input or the time is up */
+            int wait_ms = WAIT_FOREVER;
 
             if (remaining_millisecs != WAIT_FOREVER)
             {
-                if (!remaining_millisecs)
+                wait_ms = (int)( deadline - PDC_millisecs( ));
+                if( wait_ms <= 0)
                     return ERR;
-                if( nap_time > remaining_millisecs)
-                    nap_time = remaining_millisecs;
-                remaining_millisecs -= nap_time;
             }
-            napms( nap_time);
+            PDC_wait_for_input( wait_ms);
+            if( PDC_check_key( ))
+                break;
         }
 
         /* if there is, fetch it */
 
-        key = PDC_get_key();
+        key = _get_key( );
+        PDC_TRACE( TRACE_IEVENT, PDC_EV_GETCH, key, SP->key_modifiers, 0);
 
         /* loop back if we did not get a key yet */
 
         if (key == -1)
             continue;
 
+        PDC_RECORD( PDC_record_input( key));
+
         /* filter mouse events; translate mouse clicks in the slk
            area to function keys (especially copy + pase) */
 
@@ -708,6 +853,7 @@ int flushinp(void)
     SP->c_gindex = 1;       /* set indices to kill buffer */
     SP->c_pindex = 0;
     SP->c_ungind = 0;       /* clear SP->c_ungch array */
+    SP->key_held = FALSE;
 
     return OK;
 }
@@ -18,6 +18,7 @@ initscr
     SCREEN *newterm(const char *type, FILE *outfd, FILE *infd);
     SCREEN *set_term(SCREEN *new);
     void delscreen(SCREEN *sp);
+    int use_screen(SCREEN *sp, NCURSES_SCREEN_CB func, void *data);
 
     int resize_term(int nlines, int ncols);
     bool is_termresized(void);
@@ -42,17 +43,33 @@ initscr
    isendwin() returns TRUE if endwin() has been called without a
    subsequent refresh, unless SP is NULL.
 
-   In some implementations of curses, newterm() allows the use of
-   multiple terminals. Here, it's just an alternative interface for
-   initscr(). It always returns SP, or NULL.
+   newterm() is an alternative interface for initscr(), writing to
+   outfd and reading from infd (stdout and stdin if NULL). It returns
+   the new SCREEN, which becomes SP, or NULL. In the VT port, it may be
+   called again to drive several terminals from one program, each with
+   its own windows, colors, modes and output buffer. Elsewhere, there
+   is only one screen, and newterm() fails while it is active.
+
+   set_term() makes new the current screen: SP, stdscr, curscr, LINES,
+   COLS, COLORS, COLOR_PAIRS, TABSIZE and Mouse_status switch to the
+   values belonging to it. It returns the previously current screen.
+   Soft label keys, panels and the signal handlers (SIGWINCH, SIGINT)
+   are shared by all screens; the handlers act on the current one.
 
    delscreen() frees the memory allocated by newterm() or initscr(),
    since it's not freed by endwin(). This function is usually not
-   needed. In PDCurses, the parameter must be the value of SP, and
-   delscreen() sets SP to NULL.
-
-   set_term() does nothing meaningful in PDCurses, but is included for
-   compatibility with other curses implementations.
+   needed. If sp is the current screen, SP is set to NULL; otherwise,
+   the current screen is left unchanged.
+
+   use_screen() makes sp the current screen, calls func(sp, data), and
+   then switches back to the screen that was current, all while holding
+   the screen lock; it returns whatever func returns. In a library built with PDC_THREADS,
+   use it from worker threads for anything that changes SP itself --
+   init_pair(), curs_set() and the like -- or that touches more than one
+   window. Without PDC_THREADS, it just calls func. See also
+   use_window(). Since the lock is already held in func,
+   PDC_wait_for_refresh() called from there won't wait; it returns at
+   once.
 
    resize_term() is effectively two functions: When called with nonzero
    values for nlines and ncols, it attempts to resize the screen to the
@@ -81,7 +98,8 @@ initscr
 ### Return Value
 
    All functions return NULL on error, except endwin(), which always
-   returns OK, and resize_term(), which returns either OK or ERR.
+   returns OK; resize_term(), which returns either OK or ERR; and
+   use_screen(), which returns the value returned by func.
 
 ### Portability
                              X/Open  ncurses  NetBSD
@@ -91,6 +109,7 @@ initscr
     newterm                     Y       Y       Y
     set_term                    Y       Y       Y
     delscreen                   Y       Y       Y
+    use_screen                  -       Y       -
     resize_term                 -       Y       Y
     set_tabsize                 -       Y       Y
     curses_version              -       Y       -
@@ -145,6 +164,39 @@ int TABSIZE = 8;
 
 MOUSE_STATUS Mouse_status;
 
+extern enum PDC_port PDC_port_val;      /* defined in each port */
+
+/* Several SCREENs may exist (see newterm() and set_term()).  The global
+variables describe the current one;  the others keep their values in
+their SCREEN until they're made current again. */
+
+static int _n_screens = 0;     /* so the last delscreen() can end the */
+                               /* trace and the recording            */
+
+static void _save_screen_globals( SCREEN *sp)
+{
+    sp->saved_stdscr = stdscr;
+    sp->saved_curscr = curscr;
+    sp->saved_lines = LINES;
+    sp->saved_cols = COLS;
+    sp->saved_colors = COLORS;
+    sp->saved_color_pairs = COLOR_PAIRS;
+    sp->saved_tabsize = TABSIZE;
+    sp->saved_mouse_status = Mouse_status;
+}
+
+static void _restore_screen_globals( const SCREEN *sp)
+{
+    stdscr = sp->saved_stdscr;
+    curscr = sp->saved_curscr;
+    LINES = sp->saved_lines;
+    COLS = sp->saved_cols;
+    COLORS = sp->saved_colors;
+    COLOR_PAIRS = sp->saved_color_pairs;
+    TABSIZE = sp->saved_tabsize;
+    Mouse_status = sp->saved_mouse_status;
+}
+
 /* When the screen is initialized or resized,  we need to figure out
 on which lines the ripped-off lines will go.  If initializing,  we
 have to create the window for each ripped-off line and call its
@@ -183,16 +235,37 @@ static int _update_ripped_off_lines( SCREEN *sp)
 SCREEN *newterm(const char *type, FILE *outfd, FILE *infd)
 {
     int lines_ripped_off_on_top;
+    const char *bintrace_flags = getenv( "PDC_BINTRACE");
+    const uint64_t t0 = PDC_startup_clock( );
+    uint64_t t = t0;
 
     PDC_LOG(("newterm() - called\n"));
     INTENTIONALLY_UNUSED_PARAMETER( type);
 
-    if (SP && SP->alive)
+    if (SP && SP->alive && PDC_port_val != PDC_PORT_VT)
         return NULL;
-    SP = (SCREEN *)calloc(1, sizeof(SCREEN));
+    if (SP)
+    {
+        SCREEN *new_sp = (SCREEN *)calloc(1, sizeof(SCREEN));
+
+        assert( new_sp);
+        if (!new_sp)
+            return NULL;
+        _save_screen_globals( SP);
+        SP = new_sp;
+        COLORS = 0;
+        COLOR_PAIRS = 1;
+        TABSIZE = 8;
+    }
+    else
+        SP = (SCREEN *)calloc(1, sizeof(SCREEN));
     assert( SP);
     if (!SP)
         return NULL;
+    _n_screens++;
+
+    if( bintrace_flags && !PDC_bintrace_flags)
+        PDC_bintrace_start( (unsigned)strtoul( bintrace_flags, NULL, 0), 0);
 
     /* output_fd, input_fd should be initialized before PDC_src_open */
     SP->output_fd = outfd ? outfd : stdout;
@@ -203,6 +276,7 @@ SCREEN *newterm(const char *type, FILE *outfd, FILE *infd)
         fprintf(stderr, "initscr(): Unable to create SP\n");
         exit(8);
     }
+    t = PDC_startup_time( "PDC_scr_open()", t);
 
     SP->autocr = TRUE;       /* cr -> lf by default */
     SP->raw_out = FALSE;     /* tty I/O modes */
@@ -232,6 +306,7 @@ SCREEN *newterm(const char *type, FILE *outfd, FILE *infd)
 
     if( PDC_init_atrtab())   /* set up default colors */
         return NULL;
+    t = PDC_startup_time( "color pair table", t);
 
     if (LINES < 2 || COLS < 2)
     {
@@ -256,9 +331,11 @@ SCREEN *newterm(const char *type, FILE *outfd, FILE *infd)
 
     wattrset(SP->lastscr, (chtype)(-1));
     werase(SP->lastscr);
+    t = PDC_startup_time( "curscr and SP->lastscr", t);
 
     PDC_slk_initialize();
     LINES -= SP->slklines;
+    t = PDC_startup_time( "soft labels", t);
 
     /* We have to sort out ripped off lines here, and reduce the height
        of stdscr by the number of lines ripped off */
@@ -286,7 +363,10 @@ SCREEN *newterm(const char *type, FILE *outfd, FILE *infd)
     }
     else
         curscr->_clear = TRUE;
+    t = PDC_startup_time( "ripped-off lines and stdscr", t);
 
+    if( getenv( "PDC_RECORD") && !PDC_record_fp)
+        PDC_record_start( getenv( "PDC_RECORD"));
 
     MOUSE_X_POS = MOUSE_Y_POS = -1;
     BUTTON_STATUS(1) = BUTTON_RELEASED;
@@ -311,6 +391,8 @@ SCREEN *newterm(const char *type, FILE *outfd, FILE *infd)
         return NULL;
     SP->c_ungind = 0;
     SP->c_ungmax = NUNGETCH;
+    PDC_startup_time( "modes and input buffers", t);
+    PDC_startup_time( "newterm() total", t0);
 
     return SP;
 }
@@ -341,6 +423,11 @@ int endwin(void)
     def_prog_mode();
     PDC_scr_close();
 
+    if( getenv( "PDC_BINTRACE"))
+        PDC_bintrace_dump( "trace.bin");
+    if( PDC_record_fp)
+        fflush( PDC_record_fp);
+
     assert( SP);
     SP->alive = FALSE;
 
@@ -358,11 +445,21 @@ bool isendwin(void)
 
 SCREEN *set_term(SCREEN *new_scr)
 {
-    PDC_LOG(("set_term() - called\n"));
+    SCREEN *old_scr = SP;
 
-    /* We only support one screen */
+    PDC_LOG(("set_term() - called\n"));
 
-    return (new_scr == SP) ? SP : NULL;
+    assert( new_scr);
+    if (!new_scr)
+        return NULL;
+    if (new_scr != SP)
+    {
+        if (SP)
+            _save_screen_globals( SP);
+        SP = new_scr;
+        _restore_screen_globals( SP);
+    }
+    return old_scr;
 }
 
 void delscreen(SCREEN *sp)
@@ -371,13 +468,27 @@ void delscreen(SCREEN *sp)
 
     PDC_LOG(("delscreen() - called\n"));
 
-    assert( SP && sp == SP);
-    if (!SP || sp != SP)
+    assert( sp);
+    if (!sp)
         return;
+    if (sp != SP)        /* delete it as the current screen,  then */
+    {                    /* switch back to the one that was current */
+        SCREEN *curr_sp = set_term( sp);
+
+        delscreen( sp);
+        if (curr_sp)
+            set_term( curr_sp);
+        return;
+    }
 
     traceoff( );
     free(SP->c_ungch);
     free(SP->c_buffer);
+    free(SP->blink_rows);
+    free(SP->direct_rgb);
+    free(SP->direct_cells);
+    free(SP->printw_buf);
+    free(SP->saved_modes);
 
     PDC_slk_free();     /* free the soft label keys, if needed */
 
@@ -404,13 +515,39 @@ void delscreen(SCREEN *sp)
 
     free(SP);
     SP = (SCREEN *)NULL;
+    if (!--_n_screens)
+    {
+        PDC_record_stop( );
+        PDC_bintrace_free();
+    }
 }
 
-int resize_term(int nlines, int ncols)
+int use_screen( SCREEN *sp, NCURSES_SCREEN_CB func, void *data)
+{
+    SCREEN *curr_sp;
+    int rval;
+
+    PDC_LOG(("use_screen() - called\n"));
+
+    assert( sp);
+    assert( func);
+    if( !sp || !func)
+        return ERR;
+    PDC_LOCK_SCREEN( );
+    curr_sp = set_term( sp);
+    rval = func( sp, data);
+    if( curr_sp)
+        set_term( curr_sp);
+    PDC_UNLOCK_SCREEN( );
+    return( rval);
+}
+
+static int _resize_term( int nlines, int ncols)
 {
     PANEL *panel_ptr = NULL;
 
     PDC_LOG(("resize_term() - called: nlines %d\n", nlines));
+    PDC_TRACE( TRACE_UPDATE, PDC_EV_RESIZE, nlines, ncols, 0);
 
     if( PDC_resize_screen(nlines, ncols) == ERR)
         return ERR;
@@ -423,6 +560,7 @@ int resize_term(int nlines, int ncols)
     SP->lines = PDC_get_rows();
     LINES = SP->lines - SP->linesrippedoff - SP->slklines;
     SP->cols = COLS = PDC_get_columns();
+    PDC_RECORD( PDC_record_size( SP->lines, SP->cols));
 
     if (SP->cursrow >= SP->lines)
         SP->cursrow = SP->lines - 1;
@@ -463,6 +601,16 @@ int resize_term(int nlines, int ncols)
     return OK;
 }
 
+int resize_term(int nlines, int ncols)
+{
+    int rval;
+
+    PDC_LOCK_SCREEN( );
+    rval = _resize_term( nlines, ncols);
+    PDC_UNLOCK_SCREEN( );
+    return( rval);
+}
+
 bool is_termresized(void)
 {
     PDC_LOG(("is_termresized() - called\n"));
@@ -477,8 +625,6 @@ const char *curses_version(void)
 
 void PDC_get_version(PDC_VERSION *ver)
 {
-    extern enum PDC_port PDC_port_val;
-
     assert( ver);
     if (!ver)
         return;
@@ -498,6 +644,9 @@ void PDC_get_version(PDC_VERSION *ver)
 #endif
 #ifdef PDC_RGB
         | PDC_VFLAG_RGB
+#endif
+#ifdef PDC_THREADS
+        | PDC_VFLAG_THREADS
 #endif
         ;
 
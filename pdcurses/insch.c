@@ -156,9 +156,15 @@ int winsch(WINDOW *win, chtype ch)
         temp = &win->_y[y][x];
 
         memmove(temp + 1, temp, (maxx - x - 1) * sizeof(chtype));
+        PDC_copy_rgb( win, temp + 1, win, temp, maxx - x - 1);
 
         PDC_mark_cells_as_changed( win, y, x, maxx - 1);
 
+        if( ch & A_DIRECT_COLOR)
+        {
+            ch &= ~A_COLOR;
+            PDC_set_cell_rgb( win, temp);
+        }
         *temp = ch;
     }
 
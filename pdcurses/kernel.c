@@ -93,59 +93,80 @@ kernel
 #include <string.h>
 
 
-static struct cttyset
+/* The modes saved by def_prog_mode(),  def_shell_mode() and savetty()
+belong to the SCREEN they were saved from,  and are allocated with it. */
+
+struct _pdc_saved_modes
 {
     bool been_set;
     SCREEN saved;
-} ctty[3];
+};
 
-enum { PDC_SH_TTY, PDC_PR_TTY, PDC_SAVE_TTY };
+enum { PDC_SH_TTY, PDC_PR_TTY, PDC_SAVE_TTY, PDC_N_SAVED_MODES };
 
 static void _save_mode(int i)
 {
-    ctty[i].been_set = TRUE;
+    if (!SP->saved_modes)
+    {
+        SP->saved_modes = (struct _pdc_saved_modes *)calloc(
+                      PDC_N_SAVED_MODES, sizeof(struct _pdc_saved_modes));
+        assert( SP->saved_modes);
+        if (!SP->saved_modes)
+            return;
+    }
+
+    SP->saved_modes[i].been_set = TRUE;
 
-    memcpy(&(ctty[i].saved), SP, sizeof(SCREEN));
+    memcpy(&(SP->saved_modes[i].saved), SP, sizeof(SCREEN));
 
     PDC_save_screen_mode(i);
 }
 
 static int _restore_mode(int i)
 {
-    if (ctty[i].been_set == TRUE)
+    struct _pdc_saved_modes *ctty = SP->saved_modes;
+
+    if (ctty && ctty[i].been_set == TRUE)
     {
-        WINDOW **window_list = SP->window_list;
-        const int n_windows = SP->n_windows;
-        struct _pdc_pair *pairs = SP->pairs;
-        const int pairs_allocated = SP->pairs_allocated;
-        hash_idx_t *pair_hash_tbl = SP->pair_hash_tbl;
-        const int pair_hash_tbl_size = SP->pair_hash_tbl_size;
-        const int pair_hash_tbl_used = SP->pair_hash_tbl_used;
-
-        memcpy(SP, &(ctty[i].saved), sizeof(SCREEN));
-        SP->window_list = window_list;
-        SP->n_windows = n_windows;
-        SP->pairs = pairs;
-        SP->pairs_allocated = pairs_allocated;
-        SP->pair_hash_tbl = pair_hash_tbl;
-        SP->pair_hash_tbl_size = pair_hash_tbl_size;
-        SP->pair_hash_tbl_used = pair_hash_tbl_used;
-
-        if (ctty[i].saved.raw_out)
+        const SCREEN *saved = &(ctty[i].saved);
+
+                /* Only the modes and flags come from the snapshot.  */
+                /* Everything else -- windows,  buffers,  colors,    */
+                /* pending input -- belongs to the live SCREEN;  the */
+                /* snapshot's pointers to it may since have been     */
+                /* reallocated or freed.                             */
+        SP->autocr = saved->autocr;
+        SP->cbreak = saved->cbreak;
+        SP->echo = saved->echo;
+        SP->raw_inp = saved->raw_inp;
+        SP->raw_out = saved->raw_out;
+        SP->audible = saved->audible;
+        SP->cursrow = saved->cursrow;
+        SP->curscol = saved->curscol;
+        SP->visibility = saved->visibility;
+        SP->_trap_mbe = saved->_trap_mbe;
+        SP->mouse_wait = saved->mouse_wait;
+        SP->delaytenths = saved->delaytenths;
+        SP->_preserve = saved->_preserve;
+        SP->_restore = saved->_restore;
+        SP->return_key_modifiers = saved->return_key_modifiers;
+        SP->line_color = saved->line_color;
+
+        if (saved->raw_out)
             raw();
 
         PDC_restore_screen_mode(i);
 
-        if ((LINES != ctty[i].saved.lines) ||
-            (COLS != ctty[i].saved.cols))
-            resize_term(ctty[i].saved.lines, ctty[i].saved.cols);
+        if ((LINES != saved->lines) ||
+            (COLS != saved->cols))
+            resize_term(saved->lines, saved->cols);
 
-        PDC_curs_set(ctty[i].saved.visibility);
+        PDC_curs_set(saved->visibility);
 
-        PDC_gotoyx(ctty[i].saved.cursrow, ctty[i].saved.curscol);
+        PDC_gotoyx(saved->cursrow, saved->curscol);
     }
 
-    return ctty[i].been_set ? OK : ERR;
+    return (ctty && ctty[i].been_set) ? OK : ERR;
 }
 
 int def_prog_mode(void)
@@ -275,7 +296,10 @@ int napms(int ms)
     }
 
     if( ms > 0)
+    {
+        PDC_TRACE( TRACE_CALLS, PDC_EV_NAPMS, ms, 0, 0);
         PDC_napms(ms);
+    }
 
     return OK;
 }
@@ -118,6 +118,18 @@ mouse
    has_mouse() reports whether the mouse is available at all on the
    current platform.
 
+   PDCursesMod also accepts PDC_MOUSE_COALESCE in the mask given to
+   mouse_set(), mouse_on() or mousemask(). When it's set, getch()
+   merges mouse events that have piled up faster than the program reads
+   them: consecutive movement reports with the same buttons held come
+   back as one KEY_MOUSE at the newest position, and consecutive wheel
+   ticks in the same direction as one KEY_MOUSE, with nc_getmouse()
+   giving the number of ticks in the z member of the MEVENT. Only
+   events already waiting are merged, so nothing is delayed. Presses,
+   releases and clicks are never merged. This keeps dragging and wheel
+   scrolling responsive when each event takes the program a while to
+   handle. PDC_MOUSE_COALESCE isn't included in ALL_MOUSE_EVENTS.
+
 ### Portability
                              X/Open  ncurses  NetBSD
     mouse_set                   -       -       -
@@ -337,6 +349,10 @@ int nc_getmouse(MEVENT *event)
     event->x = Mouse_status.x;
     event->y = Mouse_status.y;
     event->z = 0;
+    if( (SP->_trap_mbe & PDC_MOUSE_COALESCE) && (Mouse_status.changes &
+                (PDC_MOUSE_WHEEL_UP | PDC_MOUSE_WHEEL_DOWN
+                 | PDC_MOUSE_WHEEL_LEFT | PDC_MOUSE_WHEEL_RIGHT)))
+        event->z = SP->mouse_ticks;
 
     for (i = 0; i < 3; i++)
     {
@@ -402,6 +418,7 @@ int ungetmouse(MEVENT *event)
     SP->mouse_status.y = event->y;
 
     SP->mouse_status.changes = 0;
+    SP->mouse_ticks = 1;
     bstate = event->bstate;
 
     for (i = 0; i < 3; i++)
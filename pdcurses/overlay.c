@@ -47,6 +47,8 @@ overlay
 
 **man-end****************************************************************/
 
+#include <string.h>
+
 /* Thanks to Andreas Otte <venn@@uni-paderborn.de> for the
    corrected overlay()/overwrite() behavior. */
 
@@ -79,24 +81,52 @@ static int _copy_win(const WINDOW *src_w, WINDOW *dst_w, int src_tr,
 
         fc = _NO_CHANGE;
 
-        for (col = 0; col < xdiff; col++)
+        if (_overlay)
         {
-            if ((*w1ptr) != (*w2ptr) &&
-                !((*w1ptr & A_CHARTEXT) == ' ' && _overlay))
+            for (col = 0; col < xdiff; col++)
             {
-                *w2ptr = *w1ptr;
+                if (((*w1ptr) != (*w2ptr) || (*w1ptr & A_DIRECT_COLOR))
+                                && (*w1ptr & A_CHARTEXT) != ' ')
+                {
+                    *w2ptr = *w1ptr;
+                    if (*w1ptr & A_DIRECT_COLOR)
+                        PDC_copy_rgb( dst_w, w2ptr, src_w, w1ptr, 1);
+
+                    if (fc == _NO_CHANGE)
+                        fc = col + dst_tc;
 
-                if (fc == _NO_CHANGE)
-                    fc = col + dst_tc;
+                    lc = col + dst_tc;
+                }
 
-                lc = col + dst_tc;
+                w1ptr++;
+                w2ptr++;
             }
+        }
+        else if (xdiff > 0 && PDC_rgb_cell( src_w, w1ptr, FALSE))
+        {
+            /* direct colors may differ where the cells don't */
 
-            w1ptr++;
-            w2ptr++;
+            memcpy( w2ptr, w1ptr, xdiff * sizeof( chtype));
+            PDC_copy_rgb( dst_w, w2ptr, src_w, w1ptr, xdiff);
+            fc = dst_tc;
+            lc = dst_tc + xdiff - 1;
+        }
+        else
+        {
+            col = PDC_first_changed_cell( w1ptr, w2ptr, xdiff);
+            if (col < xdiff)
+            {
+                const int last = PDC_last_changed_cell( w1ptr, w2ptr, xdiff);
+
+                memcpy( w2ptr + col, w1ptr + col,
+                                  (last - col + 1) * sizeof( chtype));
+                fc = col + dst_tc;
+                lc = last + dst_tc;
+            }
         }
 
-        PDC_mark_cells_as_changed( dst_w, y1 + line, fc, lc);
+        if (fc != _NO_CHANGE)
+            PDC_mark_cells_as_changed( dst_w, y1 + line, fc, lc);
     }
 
     return OK;
@@ -145,6 +145,7 @@ WINDOW *subpad(WINDOW *orig, int nlines, int ncols, int begy, int begx)
     /* initialize window variables */
 
     win->_attrs = orig->_attrs;
+    win->_direct_rgb = orig->_direct_rgb;
     win->_leaveit = orig->_leaveit;
     win->_scroll = orig->_scroll;
     win->_nodelay = orig->_nodelay;
@@ -210,12 +211,17 @@ int pnoutrefresh(WINDOW *w, int py, int px, int sy1, int sx1, int sy2, int sx2)
 
     num_cols = min((sx2 - sx1 + 1), (w->_maxx - px));
 
+    PDC_LOCK_SCREEN( );
+
     while (sline <= sy2)
     {
         if (pline < w->_maxy)
         {
             memcpy(curscr->_y[sline] + sx1, w->_y[pline] + px,
                    num_cols * sizeof(chtype));
+            PDC_copy_rgb( curscr, curscr->_y[sline] + sx1, w,
+                   w->_y[pline] + px, num_cols);
+            PDC_note_blink_cells( sline, w->_y[pline] + px, num_cols);
 
             PDC_mark_cells_as_changed( curscr, sline, sx1, sx2);
             PDC_set_changed_cells_range( w, pline, _NO_CHANGE, _NO_CHANGE);
@@ -248,6 +254,8 @@ int pnoutrefresh(WINDOW *w, int py, int px, int sy1, int sx1, int sy2, int sx2)
     w->_smincol = sx1;
     w->_smaxrow = sy2;
     w->_smaxcol = sx2;
+    PDC_SIGNAL_SCREEN( );
+    PDC_UNLOCK_SCREEN( );
     return OK;
 }
 
@@ -18,6 +18,10 @@ printw
     int vwprintw(WINDOW *win, const char *fmt, va_list varglist);
     int vw_printw(WINDOW *win, const char *fmt, va_list varglist);
 
+    int PDC_wprintn(WINDOW *win, const char *str, const int len);
+    int PDC_mvwprintn(WINDOW *win, const int y, const int x,
+                      const char *str, const int len);
+
 ### Description
 
    The printw() functions add a formatted string to the window at the
@@ -28,6 +32,12 @@ printw
    The duplication between vwprintw() and vw_printw() is for historic
    reasons. In PDCurses, they're the same.
 
+   PDC_wprintn() adds up to len bytes of str (stopping early at a
+   terminating zero),  with no formatting.  It's meant for callers that
+   already have the text and its length,  and would otherwise use
+   wprintw(win, "%.*s", len, str).  PDC_mvwprintn() moves the cursor
+   first.
+
 ### Return Value
 
    All functions return the number of characters printed, or ERR on
@@ -41,6 +51,8 @@ printw
     mvwprintw                   Y       Y       Y
     vwprintw                    Y       Y       Y
     vw_printw                   Y       Y       Y
+    PDC_wprintn                 -       -       -
+    PDC_mvwprintn               -       -       -
 
 **man-end****************************************************************/
 
@@ -70,35 +82,65 @@ trailing zero). */
    #define va_copy( dest, src) dest = src
 #endif
 
+/* Output is formatted into a buffer kept in SP,  which only grows;
+so once it's big enough,  there's no allocation and just one call to
+vsnprintf() per vwprintw().  waddnstr() then copies printable ASCII
+straight into the window (see addstr.c).  In threaded builds,  the
+screen lock keeps two threads from using the buffer at once. */
+
 int vwprintw(WINDOW *win, const char *fmt, va_list varglist)
 {
-    char printbuf[513];
     int len, rval;
 #ifdef vsnprint_func
-    char *buf = printbuf;
     va_list varglist_copy;
-    size_t buffsize = sizeof( printbuf) - 1;
 
     PDC_LOG(("vwprintw() - called\n"));
+    assert( SP);
+    if( !SP)
+        return ERR;
+    PDC_LOCK_SCREEN( );
+    if( !SP->printw_buf)
+    {
+        SP->printw_buf = (char *)malloc( 513);
+        if( !SP->printw_buf)
+        {
+            PDC_UNLOCK_SCREEN( );
+            return ERR;
+        }
+        SP->printw_buf_size = 512;
+    }
     va_copy( varglist_copy, varglist);
-    len = vsnprint_func( buf, buffsize, fmt, varglist_copy);
-    while( len < 0 || len > (int)buffsize)
+    len = vsnprint_func( SP->printw_buf, SP->printw_buf_size + 1, fmt,
+                         varglist_copy);
+    va_end( varglist_copy);
+    while( len < 0 || len > (int)SP->printw_buf_size)
     {
-        if( -1 == len)       /* Microsoft,  glibc 2.0 & earlier */
-            buffsize <<= 1;
-        else                 /* glibc 2.0.6 & later (C99 behavior) */
-            buffsize = len + 1;
-        if( buf != printbuf)
-            free( buf);
-        buf = (char *)malloc( buffsize + 1);
+        size_t new_size = SP->printw_buf_size;
+        char *new_buf;
+
+        if( len < 0)          /* Microsoft,  glibc 2.0 & earlier */
+            new_size <<= 1;
+        else                  /* glibc 2.0.6 & later (C99 behavior) */
+            new_size = len + 1;
+        new_buf = (char *)realloc( SP->printw_buf, new_size + 1);
+        if( !new_buf)
+        {
+            PDC_UNLOCK_SCREEN( );
+            return ERR;
+        }
+        SP->printw_buf = new_buf;
+        SP->printw_buf_size = new_size;
         va_copy( varglist_copy, varglist);
-        len = vsnprint_func( buf, buffsize, fmt, varglist_copy);
+        len = vsnprint_func( SP->printw_buf, SP->printw_buf_size + 1, fmt,
+                             varglist_copy);
+        va_end( varglist_copy);
     }
-    buf[len] = '\0';
-    rval = (waddstr(win, buf) == ERR) ? ERR : len;
-    if( buf != printbuf)
-        free( buf);
+    SP->printw_buf[len] = '\0';
+    rval = (waddnstr(win, SP->printw_buf, len) == ERR) ? ERR : len;
+    PDC_UNLOCK_SCREEN( );
 #else       /* no _vsnprintf() or vsnprintf() : buffer may overflow */
+    char printbuf[513];
+
     PDC_LOG(("vwprintw() - called\n"));
 
     len = vsprintf(printbuf, fmt, varglist);
@@ -176,3 +218,29 @@ int vw_printw(WINDOW *win, const char *fmt, va_list varglist)
 
     return vwprintw(win, fmt, varglist);
 }
+
+int PDC_wprintn(WINDOW *win, const char *str, const int len)
+{
+    int n = 0;
+
+    PDC_LOG(("PDC_wprintn() - called\n"));
+
+    if (!str || len < 0)
+        return ERR;
+
+    while (n < len && str[n])
+        n++;
+
+    return (waddnstr(win, str, n) == ERR) ? ERR : n;
+}
+
+int PDC_mvwprintn(WINDOW *win, const int y, const int x,
+                  const char *str, const int len)
+{
+    PDC_LOG(("PDC_mvwprintn() - called\n"));
+
+    if (wmove(win, y, x) == ERR)
+        return ERR;
+
+    return PDC_wprintn(win, str, len);
+}
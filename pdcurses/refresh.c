@@ -17,6 +17,8 @@ refresh
     int redrawwin(WINDOW *win);
     int wredrawln(WINDOW *win, int beg_line, int num_lines);
 
+    bool PDC_wait_for_refresh(int timeout_ms);
+
 ### Description
 
    wrefresh() copies the named window to the physical terminal screen,
@@ -41,9 +43,22 @@ refresh
    is the same as touchline(). In some other curses implementations,
    there's a subtle distinction, but it has no meaning in PDCurses.
 
+   In a library built with PDC_THREADS, wnoutrefresh() and doupdate()
+   each run while holding the screen lock, so that worker threads can
+   hand their windows over to curscr (see use_window()) while a single
+   thread owns doupdate() and the platform. That thread can call
+   PDC_wait_for_refresh(), which returns TRUE at once if curscr has
+   changes for doupdate() to send. Otherwise it waits up to timeout_ms
+   milliseconds (forever, if timeout_ms is negative) for a call to
+   wnoutrefresh() or pnoutrefresh(), and then reports whether there is
+   anything to send; it may return FALSE early. In unthreaded builds it
+   never waits, and it doesn't wait if the calling thread already holds
+   the screen lock (from within a use_screen() callback, for example).
+
 ### Return Value
 
-   All functions return OK on success and ERR on error.
+   All functions return OK on success and ERR on error, except for
+   PDC_wait_for_refresh(), which returns TRUE or FALSE.
 
 ### Portability
                              X/Open  ncurses  NetBSD
@@ -53,11 +68,271 @@ refresh
     doupdate                    Y       Y       Y
     redrawwin                   Y       Y       Y
     wredrawln                   Y       Y       Y
+    PDC_wait_for_refresh        -       -       -
 
 **man-end****************************************************************/
 
+#include <stdlib.h>
 #include <string.h>
 
+/* Changed-span scanning.  wnoutrefresh(), doupdate() and _copy_win() (in
+overlay.c) spend much of their time comparing lines of chtypes.  The
+following return the index of the first differing cell (or 'len' if none
+differ),  the last differing cell (or -1),  and the first matching cell
+(or 'len'),  which marks the end of a run of changed cells.
+
+With GCC or clang on x86 (SSE2,  or AVX2 if the CPU has it) or on 64-bit
+ARM (NEON),  several cells are compared at a time;  the kernels are picked
+at runtime on first use.  Elsewhere,  or if PDC_NO_SIMD is defined,  plain
+loops are used. */
+
+static int _first_diff_scalar( const chtype *a, const chtype *b, int len)
+{
+    int i = 0;
+
+    while( i < len && a[i] == b[i])
+        i++;
+    return( i);
+}
+
+static int _last_diff_scalar( const chtype *a, const chtype *b, int len)
+{
+    while( len > 0 && a[len - 1] == b[len - 1])
+        len--;
+    return( len - 1);
+}
+
+static int _first_match_scalar( const chtype *a, const chtype *b, int len)
+{
+    int i = 0;
+
+    while( i < len && a[i] != b[i])
+        i++;
+    return( i);
+}
+
+#if !defined( PDC_NO_SIMD) && (defined( __GNUC__) || defined( __clang__))
+   #if defined( __x86_64__) || (defined( __i386__) && defined( __SSE2__))
+      #define PDC_SIMD_X86
+      #include <immintrin.h>
+   #elif defined( __aarch64__) && defined( __ARM_NEON)
+      #define PDC_SIMD_NEON
+      #include <arm_neon.h>
+   #endif
+#endif
+
+#if defined( PDC_SIMD_X86) || defined( PDC_SIMD_NEON)
+
+/* Each _eq_mask_xxx() compares one vector's worth of cells,  returning
+a bitmask with bit n set if a[n] == b[n].  _SPAN_KERNELS then builds the
+three scanning functions around it,  falling back to the scalar loops for
+any leftover cells at the end. */
+
+#define _SPAN_KERNELS( SUFFIX, ATTR, N_CELLS, EQ_MASK)                    \
+ATTR static int _first_diff_##SUFFIX( const chtype *a, const chtype *b,   \
+                                                           int len)       \
+{                                                                         \
+    const unsigned all = (1u << (N_CELLS)) - 1;                           \
+    int i = 0;                                                            \
+                                                                          \
+    while( i + (N_CELLS) <= len)                                          \
+    {                                                                     \
+        const unsigned mask = EQ_MASK( a + i, b + i);                     \
+                                                                          \
+        if( mask != all)                                                  \
+            return( i + __builtin_ctz( ~mask));                           \
+        i += (N_CELLS);                                                   \
+    }                                                                     \
+    return( i + _first_diff_scalar( a + i, b + i, len - i));              \
+}                                                                         \
+                                                                          \
+ATTR static int _last_diff_##SUFFIX( const chtype *a, const chtype *b,    \
+                                                           int len)       \
+{                                                                         \
+    const unsigned all = (1u << (N_CELLS)) - 1;                           \
+                                                                          \
+    while( len >= (N_CELLS))                                              \
+    {                                                                     \
+        const unsigned mask = EQ_MASK( a + len - (N_CELLS),               \
+                                       b + len - (N_CELLS));              \
+                                                                          \
+        if( mask != all)                                                  \
+            return( len - (N_CELLS) + 31                                  \
+                                - __builtin_clz( ~mask & all));           \
+        len -= (N_CELLS);                                                 \
+    }                                                                     \
+    return( _last_diff_scalar( a, b, len));                               \
+}                                                                         \
+                                                                          \
+ATTR static int _first_match_##SUFFIX( const chtype *a, const chtype *b,  \
+                                                           int len)       \
+{                                                                         \
+    int i = 0;                                                            \
+                                                                          \
+    while( i + (N_CELLS) <= len)                                          \
+    {                                                                     \
+        const unsigned mask = EQ_MASK( a + i, b + i);                     \
+                                                                          \
+        if( mask)                                                         \
+            return( i + __builtin_ctz( mask));                            \
+        i += (N_CELLS);                                                   \
+    }                                                                     \
+    return( i + _first_match_scalar( a + i, b + i, len - i));             \
+}
+
+#define _NO_ATTR
+#endif
+
+#ifdef PDC_SIMD_X86
+
+static inline unsigned _eq_mask_sse2( const chtype *a, const chtype *b)
+{
+    __m128i eq = _mm_cmpeq_epi32( _mm_loadu_si128( (const __m128i *)a),
+                                  _mm_loadu_si128( (const __m128i *)b));
+
+#ifdef CHTYPE_32
+    return( (unsigned)_mm_movemask_ps( _mm_castsi128_ps( eq)));
+#else          /* both 32-bit halves of a 64-bit cell must match */
+    eq = _mm_and_si128( eq, _mm_shuffle_epi32( eq, _MM_SHUFFLE( 2, 3, 0, 1)));
+    return( (unsigned)_mm_movemask_pd( _mm_castsi128_pd( eq)));
+#endif
+}
+
+#define _AVX2_ATTR __attribute__(( target( "avx2")))
+
+_AVX2_ATTR static inline unsigned _eq_mask_avx2( const chtype *a,
+                                                 const chtype *b)
+{
+    const __m256i va = _mm256_loadu_si256( (const __m256i *)a);
+    const __m256i vb = _mm256_loadu_si256( (const __m256i *)b);
+
+#ifdef CHTYPE_32
+    return( (unsigned)_mm256_movemask_ps(
+                  _mm256_castsi256_ps( _mm256_cmpeq_epi32( va, vb))));
+#else
+    return( (unsigned)_mm256_movemask_pd(
+                  _mm256_castsi256_pd( _mm256_cmpeq_epi64( va, vb))));
+#endif
+}
+
+_SPAN_KERNELS( sse2, _NO_ATTR, 16 / (int)sizeof( chtype), _eq_mask_sse2)
+_SPAN_KERNELS( avx2, _AVX2_ATTR, 32 / (int)sizeof( chtype), _eq_mask_avx2)
+#endif      /* #ifdef PDC_SIMD_X86 */
+
+#ifdef PDC_SIMD_NEON
+
+static inline unsigned _eq_mask_neon( const chtype *a, const chtype *b)
+{
+#ifdef CHTYPE_32
+    const uint32x4_t eq = vceqq_u32( vld1q_u32( a), vld1q_u32( b));
+
+    return( (vgetq_lane_u32( eq, 0) & 1) | (vgetq_lane_u32( eq, 1) & 2)
+          | (vgetq_lane_u32( eq, 2) & 4) | (vgetq_lane_u32( eq, 3) & 8));
+#else
+    const uint64x2_t eq = vceqq_u64( vld1q_u64( a), vld1q_u64( b));
+
+    return( (unsigned)(vgetq_lane_u64( eq, 0) & 1)
+          | (unsigned)(vgetq_lane_u64( eq, 1) & 2));
+#endif
+}
+
+_SPAN_KERNELS( neon, _NO_ATTR, 16 / (int)sizeof( chtype), _eq_mask_neon)
+#endif      /* #ifdef PDC_SIMD_NEON */
+
+typedef int (*_span_fn)( const chtype *, const chtype *, int);
+
+static _span_fn _first_diff_fn, _last_diff_fn, _first_match_fn;
+
+static void _select_span_kernels( void)
+{
+    _first_diff_fn = _first_diff_scalar;
+    _last_diff_fn = _last_diff_scalar;
+    _first_match_fn = _first_match_scalar;
+#ifdef PDC_SIMD_X86
+    _first_diff_fn = _first_diff_sse2;
+    _last_diff_fn = _last_diff_sse2;
+    _first_match_fn = _first_match_sse2;
+    __builtin_cpu_init( );
+    if( __builtin_cpu_supports( "avx2"))
+    {
+        _first_diff_fn = _first_diff_avx2;
+        _last_diff_fn = _last_diff_avx2;
+        _first_match_fn = _first_match_avx2;
+    }
+#endif
+#ifdef PDC_SIMD_NEON
+    _first_diff_fn = _first_diff_neon;
+    _last_diff_fn = _last_diff_neon;
+    _first_match_fn = _first_match_neon;
+#endif
+}
+
+int PDC_first_changed_cell( const chtype *a, const chtype *b, const int len)
+{
+    if( !_first_diff_fn)
+        _select_span_kernels( );
+    return( _first_diff_fn( a, b, len));
+}
+
+int PDC_last_changed_cell( const chtype *a, const chtype *b, const int len)
+{
+    if( !_last_diff_fn)
+        _select_span_kernels( );
+    return( _last_diff_fn( a, b, len));
+}
+
+int PDC_first_unchanged_cell( const chtype *a, const chtype *b, const int len)
+{
+    if( !_first_match_fn)
+        _select_span_kernels( );
+    return( _first_match_fn( a, b, len));
+}
+
+/* Where a line has an RGB plane (see PDC_wset_rgb()),  cells with
+A_DIRECT_COLOR can match while their colors don't.  The following do the
+above scans from 'start' with the planes ('ra',  'rb') taken into
+account,  or hand off to the above if there are no planes. */
+
+#define _CELL_DIFFERS( a, b, ra, rb, i)  ((a)[i] != (b)[i] || \
+          (((a)[i] & A_DIRECT_COLOR) && (ra)[i] != (rb)[i]))
+
+static int _first_changed( const chtype *a, const chtype *b,
+                           const uint64_t *ra, const uint64_t *rb,
+                           const int start, const int len)
+{
+    int i = start;
+
+    if( !ra)
+        return( PDC_first_changed_cell( a + start, b + start, len));
+    while( i < start + len && !_CELL_DIFFERS( a, b, ra, rb, i))
+        i++;
+    return( i - start);
+}
+
+static int _last_changed( const chtype *a, const chtype *b,
+                          const uint64_t *ra, const uint64_t *rb,
+                          const int start, int len)
+{
+    if( !ra)
+        return( PDC_last_changed_cell( a + start, b + start, len));
+    while( len > 0 && !_CELL_DIFFERS( a, b, ra, rb, start + len - 1))
+        len--;
+    return( len - 1);
+}
+
+static int _first_unchanged( const chtype *a, const chtype *b,
+                             const uint64_t *ra, const uint64_t *rb,
+                             const int start, const int len)
+{
+    int i = start;
+
+    if( !ra)
+        return( PDC_first_unchanged_cell( a + start, b + start, len));
+    while( i < start + len && _CELL_DIFFERS( a, b, ra, rb, i))
+        i++;
+    return( i - start);
+}
+
 static void _normalize_cursor( WINDOW *win)
 {
     if( win->_cury < 0)
@@ -75,7 +350,7 @@ int PDC_pnoutrefresh_with_stored_params( WINDOW *pad);       /* pad.c */
 int wnoutrefresh(WINDOW *win)
 {
     int begy, begx;     /* window's place on screen   */
-    int i, j;
+    int i, j, n_copied;
 
     PDC_LOG(("wnoutrefresh() - called: win=%p\n", win));
 
@@ -87,6 +362,9 @@ int wnoutrefresh(WINDOW *win)
 
     begy = win->_begy;
     begx = win->_begx;
+    n_copied = 0;
+
+    PDC_LOCK_SCREEN( );
 
     for (i = 0, j = begy; i < win->_maxy && j < curscr->_maxy; i++, j++)
     {
@@ -94,6 +372,8 @@ int wnoutrefresh(WINDOW *win)
         {
             chtype *src = win->_y[i];
             chtype *dest = curscr->_y[j] + begx;
+            const uint64_t *src_rgb = PDC_rgb_cell( win, src, FALSE);
+            uint64_t *dest_rgb = NULL;
 
             int first = win->_firstch[i]; /* first changed */
             int last = win->_lastch[i];   /* last changed */
@@ -103,14 +383,21 @@ int wnoutrefresh(WINDOW *win)
             if( first < -begx)       /* ...nor the left edge */
                 first = -begx;
 
+            if( src_rgb)
+                dest_rgb = PDC_rgb_cell( curscr, curscr->_y[j], TRUE);
+            if( dest_rgb)
+                dest_rgb += begx;
+            else
+                src_rgb = NULL;
+
             /* ignore areas on the outside that are marked as changed,
                but really aren't */
 
-            while (first <= last && src[first] == dest[first])
-                first++;
-
-            while (last >= first && src[last] == dest[last])
-                last--;
+            first += _first_changed( src, dest, src_rgb, dest_rgb,
+                                     first, last - first + 1);
+            if (first <= last)
+                last = first + _last_changed( src, dest, src_rgb, dest_rgb,
+                                              first, last - first + 1);
 
             /* if any have really changed... */
 
@@ -118,6 +405,11 @@ int wnoutrefresh(WINDOW *win)
             {
                 memcpy(dest + first, src + first,
                        (last - first + 1) * sizeof(chtype));
+                if( src_rgb)
+                    memcpy( dest_rgb + first, src_rgb + first,
+                            (last - first + 1) * sizeof( uint64_t));
+                PDC_note_blink_cells( j, src + first, last - first + 1);
+                n_copied++;
 
                 first += begx;
                 last += begx;
@@ -133,6 +425,8 @@ int wnoutrefresh(WINDOW *win)
         PDC_set_changed_cells_range( win, i, _NO_CHANGE, _NO_CHANGE);
     }
 
+    PDC_TRACE( TRACE_UPDATE, PDC_EV_WNOUTREFRESH, begy, begx, n_copied);
+
     if (win->_clear)
         win->_clear = FALSE;
 
@@ -143,13 +437,80 @@ int wnoutrefresh(WINDOW *win)
         _normalize_cursor( curscr);
     }
 
+    if( n_copied)
+        PDC_SIGNAL_SCREEN( );
+    PDC_UNLOCK_SCREEN( );
     return OK;
 }
 
-/* The following ensures that PDC_transform_line() is fed a maximum of
-MAX_PACKET_LEN at a time;  'dummy' characters in cells next to fullwidth
-characters are not sent;  and we break packets after combining characters
-and fullwidth characters,  avoiding some possible mis-alignment issues. */
+/* Cells with A_DIRECT_COLOR keep their colors in curscr's RGB plane,
+which platforms don't see.  So a run holding any is copied (with the cell
+after it,  which some platforms peek at),  and each direct cell's color
+field set to an index into the SP->direct_rgb ring,  where
+PDC_get_rgb_values() finds its colors.  Neighbouring cells with the same
+colors share an index.  The indices keep counting up from run to run,
+so a platform comparing a cell to the last one it drew never mistakes new
+colors for old. */
+
+static const chtype *_resolve_direct_colors( const int x, const int len,
+                                             const chtype *srcp)
+{
+    const uint64_t *rgb = PDC_rgb_cell( curscr, srcp, FALSE);
+    const int n = (x + len < COLS ? len + 1 : len);
+    const unsigned max_counter = ((unsigned)1 << PDC_COLOR_BITS) - 1;
+    chtype *cells;
+    int i;
+
+    if( !rgb || !(SP->termattrs & A_DIRECT_COLOR))
+        return( srcp);
+    for( i = 0; i < n && !(srcp[i] & A_DIRECT_COLOR); i++)
+        ;
+    if( i == n)
+        return( srcp);
+    if( !SP->direct_rgb || (unsigned)( 2 * n) > SP->direct_mask + 1)
+    {
+        unsigned size = 64;
+
+        while( size < (unsigned)( 2 * n))
+            size <<= 1;
+        free( SP->direct_rgb);
+        free( SP->direct_cells);
+        SP->direct_rgb = (uint64_t *)malloc( size * sizeof( uint64_t));
+        SP->direct_cells = (chtype *)malloc( size * sizeof( chtype));
+        SP->direct_mask = size - 1;
+        if( !SP->direct_rgb || !SP->direct_cells)
+        {
+            free( SP->direct_rgb);
+            free( SP->direct_cells);
+            SP->direct_rgb = NULL;
+            SP->direct_cells = NULL;
+            return( srcp);
+        }
+    }
+    cells = SP->direct_cells;
+    for( i = 0; i < n; i++)
+    {
+        cells[i] = srcp[i];
+        if( srcp[i] & A_DIRECT_COLOR)
+        {
+            if( !i || !(srcp[i - 1] & A_DIRECT_COLOR) || rgb[i] != rgb[i - 1])
+            {
+                SP->direct_counter = (SP->direct_counter + 1) & max_counter;
+                SP->direct_rgb[SP->direct_counter & SP->direct_mask] = rgb[i];
+            }
+            cells[i] = (srcp[i] & ~A_COLOR)
+                            | ((chtype)SP->direct_counter << PDC_COLOR_SHIFT);
+        }
+    }
+    return( cells);
+}
+
+/* The following feeds PDC_transform_line() a whole run of changed cells
+at a time,  however long;  platforms with fixed-size output buffers slice
+it up themselves.  In wide builds,  'dummy' characters in cells next to
+fullwidth characters are not sent,  and we break packets after combining
+characters and fullwidth characters,  avoiding some possible
+mis-alignment issues. */
 
 void PDC_transform_line_sliced( int lineno, int x, int len, const chtype *srcp)
 {
@@ -158,23 +519,27 @@ void PDC_transform_line_sliced( int lineno, int x, int len, const chtype *srcp)
     assert( x + len <= COLS);
     assert( lineno >= 0);
     assert( lineno < SP->lines);
+    PDC_RECORD( PDC_record_run( lineno, x, len, srcp));
+    if( curscr->_rgb)
+        srcp = _resolve_direct_colors( x, len, srcp);
     while( len)
     {
 #ifdef PDC_WIDE
         int i = 1;
         chtype ch;
 
-        while( i < MAX_PACKET_LEN - 1
-                     && (ch = (srcp[i - 1] & A_CHARTEXT)) < MAX_UNICODE
-                     && i < len)
+        while( (ch = (srcp[i - 1] & A_CHARTEXT)) < MAX_UNICODE && i < len)
            i++;
         if( i == 1 && ch == MAX_UNICODE)
             fprintf( stderr, "line %d, x=%d, len=%d\n", lineno, x, len);
         assert( i > 1 || ch != MAX_UNICODE);
+        PDC_TRACE( TRACE_CHARPUT, PDC_EV_TRANSFORM_LINE, lineno, x,
+                          i - ((ch == MAX_UNICODE) ? 1 : 0));
         PDC_transform_line( lineno, x,
                           i - ((ch == MAX_UNICODE) ? 1 : 0), srcp);
 #else
-        const int i = min( len, MAX_PACKET_LEN - 1);
+        const int i = len;
+        PDC_TRACE( TRACE_CHARPUT, PDC_EV_TRANSFORM_LINE, lineno, x, i);
         PDC_transform_line( lineno, x, i, srcp);
 #endif
         x += i;
@@ -183,9 +548,90 @@ void PDC_transform_line_sliced( int lineno, int x, int len, const chtype *srcp)
     }
 }
 
+/* Platforms that blink text themselves (X11,  SDL2,  OpenGL,  framebuffer)
+used to rescan all of curscr for A_BLINK cells on every blink.  Instead,
+wnoutrefresh() and pnoutrefresh() flag the rows into which they copy
+blinking cells,  and a full redraw flags every row,  since curscr may
+have been written to by other means.  PDC_redraw_blinking_text() then
+visits only flagged rows,  redraws their blinking spans,  and unflags
+rows found to have none.  It returns the number of rows still flagged;
+zero means the platform can stop its blink timer until text with
+A_BLINK is next sent.  If the row array can't be allocated,  every row
+is treated as flagged. */
+
+static bool _alloc_blink_rows( void)
+{
+    if( SP->blink_rows_alloced < curscr->_maxy)
+    {
+        char *new_rows = (char *)realloc( SP->blink_rows, curscr->_maxy);
+
+        if( !new_rows)
+            return FALSE;
+        memset( new_rows + SP->blink_rows_alloced, 1,
+                           curscr->_maxy - SP->blink_rows_alloced);
+        SP->n_blink_rows += curscr->_maxy - SP->blink_rows_alloced;
+        SP->blink_rows = new_rows;
+        SP->blink_rows_alloced = curscr->_maxy;
+    }
+    return TRUE;
+}
+
+void PDC_note_blink_cells( const int row, const chtype *cells, int n)
+{
+    if( !_alloc_blink_rows( ) || SP->blink_rows[row])
+        return;
+    while( n--)
+        if( *cells++ & A_BLINK)
+        {
+            SP->blink_rows[row] = 1;
+            SP->n_blink_rows++;
+            return;
+        }
+}
+
+void PDC_touch_blink_rows( void)
+{
+    if( _alloc_blink_rows( ))
+    {
+        memset( SP->blink_rows, 1, SP->blink_rows_alloced);
+        SP->n_blink_rows = SP->blink_rows_alloced;
+    }
+}
+
+int PDC_redraw_blinking_text( void)
+{
+    const bool have_rows = _alloc_blink_rows( );
+    int x1, x2, y;
+
+    SP->n_blink_rows = 0;
+    for( y = 0; y < SP->lines; y++)
+        if( !have_rows || SP->blink_rows[y])
+        {
+            const chtype *c = curscr->_y[y];
+            bool found = FALSE;
+
+            for( x1 = 0; x1 < SP->cols; x1++)
+                if( c[x1] & A_BLINK)
+                {
+                    x2 = x1 + 1;
+                    while( x2 < SP->cols && (c[x2] & A_BLINK))
+                        x2++;
+                    PDC_transform_line_sliced( y, x1, x2 - x1, c + x1);
+                    found = TRUE;
+                    x1 = x2;
+                }
+            if( found)
+                SP->n_blink_rows++;
+            else if( have_rows)
+                SP->blink_rows[y] = 0;
+        }
+    return( SP->n_blink_rows);
+}
+
 int doupdate(void)
 {
-    int y;
+    int y, n_lines = 0, n_runs = 0;
+    long n_cells = 0;
     bool clearall;
 
     PDC_LOG(("doupdate() - called\n"));
@@ -195,6 +641,7 @@ int doupdate(void)
     if (!SP || !curscr)
         return ERR;
 
+    PDC_LOCK_SCREEN( );
     if (isendwin())         /* coming back after endwin() called */
     {
         reset_prog_mode();
@@ -203,6 +650,11 @@ int doupdate(void)
     }
     else
         clearall = curscr->_clear;
+    if( clearall)
+        PDC_touch_blink_rows( );
+
+    PDC_TRACE( TRACE_UPDATE, PDC_EV_DOUPDATE_BEGIN, clearall, 0, 0);
+    PDC_RECORD( PDC_record_frame_begin( clearall));
 
     for (y = 0; y < SP->lines; y++)
     {
@@ -216,6 +668,13 @@ int doupdate(void)
 
             chtype *src = curscr->_y[y];
             chtype *dest = SP->lastscr->_y[y];
+            const uint64_t *src_rgb = PDC_rgb_cell( curscr, src, FALSE);
+            uint64_t *dest_rgb = NULL;
+
+            if( src_rgb)
+                dest_rgb = PDC_rgb_cell( SP->lastscr, dest, TRUE);
+            if( !dest_rgb)
+                src_rgb = NULL;
 
             if (clearall)
             {
@@ -239,49 +698,66 @@ int doupdate(void)
                 if (clearall)
                     len = last - first + 1;
                 else
-                    while (first + len <= last &&
-                           (src[first + len] != dest[first + len] ||
-                            (len && first + len < last &&
-                             src[first + len + 1] != dest[first + len + 1])
-                           )
-                          )
-                        len++;
+                {
+                    int end = first + _first_unchanged( src, dest, src_rgb,
+                                           dest_rgb, first, last - first + 1);
+
+                    while (end > first && end < last && (src_rgb ?
+                               _CELL_DIFFERS( src, dest, src_rgb, dest_rgb, end + 1)
+                               : src[end + 1] != dest[end + 1]))
+                        end += 2 + _first_unchanged( src, dest, src_rgb,
+                                           dest_rgb, end + 2, last - end - 1);
+                    len = end - first;
+                }
 
                 /* update the screen, and SP->lastscr */
 
                 if (len)
                 {
+                    n_runs++;
+                    n_cells += len;
                     PDC_transform_line_sliced(y, first, len, src + first);
                     memcpy(dest + first, src + first, len * sizeof(chtype));
+                    if( src_rgb)
+                        memcpy( dest_rgb + first, src_rgb + first,
+                                len * sizeof( uint64_t));
                     first += len;
                 }
 
                 /* skip over runs of unchanged cells */
 
-                while (first <= last && src[first] == dest[first])
-                    first++;
+                first += _first_changed( src, dest, src_rgb, dest_rgb,
+                                         first, last - first + 1);
             }
 
             PDC_set_changed_cells_range( curscr, y, _NO_CHANGE, _NO_CHANGE);
+            n_lines++;
         }
     }
 
     curscr->_clear = FALSE;
 
     if (SP->visibility)
+    {
+        PDC_TRACE( TRACE_MOVE, PDC_EV_GOTOYX, curscr->_cury, curscr->_curx, 0);
         PDC_gotoyx(curscr->_cury, curscr->_curx);
+    }
 
     SP->cursrow = curscr->_cury;
     SP->curscol = curscr->_curx;
 
     PDC_doupdate();
 
+    PDC_TRACE( TRACE_UPDATE, PDC_EV_DOUPDATE_END, n_lines, n_runs, n_cells);
+    PDC_RECORD( PDC_record_frame_end( SP->cursrow, SP->curscol, SP->visibility));
+    PDC_UNLOCK_SCREEN( );
     return OK;
 }
 
 int wrefresh(WINDOW *win)
 {
     bool save_clear;
+    int rval;
 
     PDC_LOG(("wrefresh() - called\n"));
 
@@ -291,6 +767,7 @@ int wrefresh(WINDOW *win)
 
     save_clear = win->_clear;
 
+    PDC_LOCK_SCREEN( );
     if (win == curscr)
         curscr->_clear = TRUE;
     else
@@ -299,7 +776,45 @@ int wrefresh(WINDOW *win)
     if (save_clear && win->_maxy == SP->lines && win->_maxx == SP->cols)
         curscr->_clear = TRUE;
 
-    return doupdate();
+    rval = doupdate();
+    PDC_UNLOCK_SCREEN( );
+    return( rval);
+}
+
+static bool _curscr_changed( void)
+{
+    int y;
+
+    if( curscr->_clear)
+        return( TRUE);
+    for( y = 0; y < curscr->_maxy; y++)
+        if( curscr->_firstch[y] != _NO_CHANGE)
+            return( TRUE);
+    return( FALSE);
+}
+
+bool PDC_wait_for_refresh( const int timeout_ms)
+{
+    bool rval;
+
+    PDC_LOG(("PDC_wait_for_refresh() - called: %d\n", timeout_ms));
+
+    assert( curscr);
+    if( !curscr)
+        return FALSE;
+    PDC_LOCK_SCREEN( );
+    rval = _curscr_changed( );
+#ifdef PDC_THREADS
+    if( !rval && timeout_ms)
+    {
+        PDC_wait_screen( timeout_ms);
+        rval = _curscr_changed( );
+    }
+#else
+    INTENTIONALLY_UNUSED_PARAMETER( timeout_ms);
+#endif
+    PDC_UNLOCK_SCREEN( );
+    return( rval);
 }
 
 int refresh(void)
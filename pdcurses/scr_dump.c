@@ -61,10 +61,24 @@ scr_dump
 #include <stdlib.h>
 #include <string.h>
 
-#define DUMPVER 2   /* Should be updated whenever the WINDOW struct is
-                       changed */
+#define DUMPVER 3   /* Should be updated whenever the WINDOW struct
+                       or the layout of the cell data is changed */
 
-static void _stuff_chtype_into_eight_bytes( char *buff, const chtype c)
+static void _put_le32( unsigned char *buff, const uint32_t x)
+{
+   buff[0] = (unsigned char)x;
+   buff[1] = (unsigned char)( x >> 8);
+   buff[2] = (unsigned char)( x >> 16);
+   buff[3] = (unsigned char)( x >> 24);
+}
+
+static uint32_t _get_le32( const unsigned char *buff)
+{
+   return( (uint32_t)buff[0] | ((uint32_t)buff[1] << 8)
+               | ((uint32_t)buff[2] << 16) | ((uint32_t)buff[3] << 24));
+}
+
+static void _stuff_chtype_into_eight_bytes( unsigned char *buff, const chtype c)
 {
    const chtype text = c & A_CHARTEXT;
    const chtype color_pair = PAIR_NUMBER( c);
@@ -72,19 +86,16 @@ static void _stuff_chtype_into_eight_bytes( char *buff, const chtype c)
    const uint32_t x = (uint32_t)text | ((uint32_t)attribs << 21);
    const uint32_t y = ((uint32_t)attribs >> 11) | ((uint32_t)color_pair << 1);
 
-   memcpy( buff, &x, 4);
-   memcpy( buff + 4, &y, 4);
-         /* Should reverse these eight bytes on big-Endian machines */
+   _put_le32( buff, x);
+   _put_le32( buff + 4, y);
 }
 
-static chtype _get_chtype_from_eight_bytes( const char *buff)
+static chtype _get_chtype_from_eight_bytes( const unsigned char *buff)
 {
-   uint32_t x, y;
+   const uint32_t x = _get_le32( buff);
+   const uint32_t y = _get_le32( buff + 4);
    chtype c, text, color_pair, attribs;
 
-         /* Should reverse these eight bytes on big-Endian machines */
-   memcpy( &x, buff, 4);
-   memcpy( &y, buff + 4, 4);
    text = (chtype)x & A_CHARTEXT;
    attribs = (chtype)( ((x >> 21) & 0xfff) | ((y & 1) << 11));
    color_pair = (chtype)(y >> 1) & 0xfffff;
@@ -109,15 +120,129 @@ with cross-compiler and cross-OS compatibility.  chtypes are expanded
 to the 64-bit form on writing and compacted back upon reading.  You
 will get scrambled colors and/or attributes if you make a file with
 one program that uses attributes or color pairs beyond the reach of
-the program reading the file.  Error checks for this may be added. */
+the program reading the file.  Error checks for this may be added.
+
+In DUMPVER 2,  the cells followed as a plain array of eight-byte values,
+written and read one cell at a time.  Since DUMPVER 3,  each line is
+written as a block :  a one-byte encoding,  the little-endian four-byte
+size of the data that follows,  then the data.  For LINE_RAW,  that's
+one eight-byte (little-endian) value per cell.  For LINE_RLE,  it's a
+series of runs,  each a little-endian two-byte count followed by the
+eight-byte value to be repeated.  putwin() uses RLE for a line only if
+that makes it smaller,  and each line takes one fwrite() (and two
+fread()s in getwin()).  getwin() still reads DUMPVER 2 files. */
 
 static const char *_format_nine_ints = "%d %d %d %d %d %d %d %d %d\n";
 static const char *_format_three_ints = "%d %d %d\n";
 
+#define LINE_RAW          0
+#define LINE_RLE          1
+#define LINE_HEADER_SIZE  5
+#define CELL_SIZE         8
+#define RLE_RUN_SIZE      (2 + CELL_SIZE)
+#define RLE_MAX_RUN       0xffff
+
+/* Encodes a line of 'ncols' cells,  header included,  into 'obuff'
+(which must have room for LINE_HEADER_SIZE + ncols * CELL_SIZE bytes).
+Returns the total number of bytes to be written. */
+
+static size_t _encode_line( unsigned char *obuff, const chtype *line,
+                                                  const int ncols)
+{
+    const size_t raw_size = (size_t)ncols * CELL_SIZE;
+    size_t rle_size = 0, data_size;
+    unsigned char *tptr = obuff + LINE_HEADER_SIZE;
+    int x, run;
+
+    for( x = 0; x < ncols && rle_size < raw_size; x += run)
+    {
+        run = 1;
+        while( x + run < ncols && run < RLE_MAX_RUN
+                     && line[x + run] == line[x])
+            run++;
+        rle_size += RLE_RUN_SIZE;
+    }
+
+    if( rle_size < raw_size)
+    {
+        for( x = 0; x < ncols; x += run)
+        {
+            run = 1;
+            while( x + run < ncols && run < RLE_MAX_RUN
+                         && line[x + run] == line[x])
+                run++;
+            tptr[0] = (unsigned char)run;
+            tptr[1] = (unsigned char)( run >> 8);
+            _stuff_chtype_into_eight_bytes( tptr + 2, line[x]);
+            tptr += RLE_RUN_SIZE;
+        }
+        obuff[0] = LINE_RLE;
+        data_size = rle_size;
+    }
+    else
+    {
+        for( x = 0; x < ncols; x++, tptr += CELL_SIZE)
+            _stuff_chtype_into_eight_bytes( tptr, line[x]);
+        obuff[0] = LINE_RAW;
+        data_size = raw_size;
+    }
+    _put_le32( obuff + 1, (uint32_t)data_size);
+    return( LINE_HEADER_SIZE + data_size);
+}
+
+/* Reads one line's worth of cells into 'line',  using 'buff' (which must
+have room for ncols * CELL_SIZE bytes) for the raw file data.  For
+DUMPVER 2 files,  there is no line header and the data is always raw. */
+
+static bool _read_line( FILE *filep, const int version, unsigned char *buff,
+                        chtype *line, const int ncols)
+{
+    const size_t raw_size = (size_t)ncols * CELL_SIZE;
+    int encoding = LINE_RAW;
+    size_t data_size = raw_size;
+    int x;
+
+    if( version > 2)
+    {
+        if( !fread( buff, LINE_HEADER_SIZE, 1, filep))
+            return( FALSE);
+        encoding = buff[0];
+        data_size = (size_t)_get_le32( buff + 1);
+        if( encoding == LINE_RAW ? data_size != raw_size :
+                (encoding != LINE_RLE || data_size > raw_size
+                                      || data_size % RLE_RUN_SIZE))
+            return( FALSE);
+    }
+    if( data_size && !fread( buff, data_size, 1, filep))
+        return( FALSE);
+
+    if( encoding == LINE_RAW)
+        for( x = 0; x < ncols; x++, buff += CELL_SIZE)
+            line[x] = _get_chtype_from_eight_bytes( buff);
+    else
+    {
+        const unsigned char *endptr = buff + data_size;
+
+        for( x = 0; buff < endptr; buff += RLE_RUN_SIZE)
+        {
+            int run = (int)buff[0] | ((int)buff[1] << 8);
+            const chtype c = _get_chtype_from_eight_bytes( buff + 2);
+
+            if( run > ncols - x)
+                return( FALSE);
+            while( run--)
+                line[x++] = c;
+        }
+        if( x != ncols)
+            return( FALSE);
+    }
+    return( TRUE);
+}
+
 int putwin(WINDOW *win, FILE *filep)
 {
-    char buff[16];
-    int y, x;
+    unsigned char *buff;
+    int y, rval = OK;
 
     PDC_LOG(("putwin() - called\n"));
 
@@ -141,19 +266,24 @@ int putwin(WINDOW *win, FILE *filep)
          win->_delayms, win->_parx, win->_pary))
         return( ERR);
 
+    buff = (unsigned char *)malloc( LINE_HEADER_SIZE
+                     + (size_t)max( win->_maxx, 2) * CELL_SIZE);
+    if( !buff)
+        return( ERR);
     _stuff_chtype_into_eight_bytes( buff, win->_attrs);
     _stuff_chtype_into_eight_bytes( buff + 8, win->_bkgd);
     if( !fwrite(buff, 16, 1, filep))
-        return ERR;
+        rval = ERR;
 
-    for( y = 0; y < win->_maxy && win->_y[y]; y++)
-        for( x = 0; x < win->_maxx; x++)
-        {
-            _stuff_chtype_into_eight_bytes( buff, win->_y[y][x]);
-            if( !fwrite(buff, 8, 1, filep))
-                return ERR;
-         }
-    return OK;
+    for( y = 0; rval == OK && y < win->_maxy && win->_y[y]; y++)
+    {
+        const size_t n_bytes = _encode_line( buff, win->_y[y], win->_maxx);
+
+        if( !fwrite( buff, n_bytes, 1, filep))
+            rval = ERR;
+    }
+    free( buff);
+    return( rval);
 }
 
 void PDC_add_window_to_list( WINDOW *win);
@@ -166,6 +296,7 @@ WINDOW *getwin(FILE *filep)
 {
     WINDOW *win, temp_win;
     char buff[80];
+    unsigned char *line_buff;
     int nlines, y;
     int _clear, _leaveit, _scroll, _nodelay, _immed, _sync, _use_keypad;
     int version, window_size;
@@ -183,7 +314,7 @@ WINDOW *getwin(FILE *filep)
          || 9 != sscanf( buff, _format_nine_ints, &version, &window_size,
                   &temp_win._cury, &temp_win._curx, &temp_win._maxy, &temp_win._maxx,
                   &temp_win._begy, &temp_win._begx, &temp_win._flags)
-               || version != DUMPVER)
+               || version < 2 || version > DUMPVER)
         failure = TRUE;
     else if( !fgets( buff, sizeof( buff), filep)
          || 9 != sscanf( buff, _format_nine_ints, &_clear, &_leaveit,
@@ -210,12 +341,14 @@ WINDOW *getwin(FILE *filep)
         int *saved_lastch = win->_lastch;
 
         memcpy( win, &temp_win, sizeof( WINDOW));
+        win->_maxy_alloc = win->_maxy;
+        win->_maxx_alloc = win->_maxx;
         win->_y = saved_y;
         win->_firstch = saved_firstch;
         win->_lastch  = saved_lastch;
     }
-    win->_attrs = _get_chtype_from_eight_bytes( buff);
-    win->_bkgd = _get_chtype_from_eight_bytes( buff + 8);
+    win->_attrs = _get_chtype_from_eight_bytes( (unsigned char *)buff);
+    win->_bkgd = _get_chtype_from_eight_bytes( (unsigned char *)buff + 8);
     win->_clear      = (bool)_clear;
     win->_leaveit    = (bool)_leaveit;
     win->_scroll     = (bool)_scroll;
@@ -234,19 +367,14 @@ WINDOW *getwin(FILE *filep)
 
     /* read them */
 
+    line_buff = (unsigned char *)malloc( LINE_HEADER_SIZE
+                     + (size_t)win->_maxx * CELL_SIZE);
+    if( !line_buff)
+        failure = TRUE;
     for( y = 0; y < nlines && !failure; y++)
-    {
-        const int ncols = win->_maxx;
-        int x;
-
-        for( x = 0; x < ncols && !failure; x++)
-        {
-            if (!fread( buff, 8, 1, filep))
-                failure = TRUE;
-            else
-                win->_y[y][x] = _get_chtype_from_eight_bytes( buff);
-        }
-    }
+        if( !_read_line( filep, version, line_buff, win->_y[y], win->_maxx))
+            failure = TRUE;
+    free( line_buff);
 
     if( failure)
     {
@@ -40,10 +40,15 @@ scroll
 
 **man-end****************************************************************/
 
+/* Lines are moved one at a time through _y[]:  they needn't be
+contiguous,  or _maxx apart.  A subwindow's lines are its parent's,  and
+a window shrunk in place by resize_window() keeps its allocated width. */
+
 int PDC_wscrl(WINDOW *win, const int top, const int bottom, int n)
 {
-    int start, end, n_lines;
+    int start, end, n_lines, y;
     chtype blank, *tptr, *endptr;
+    size_t line_size;
 
     /* Check if window scrolls. Valid for window AND pad */
 
@@ -52,6 +57,7 @@ int PDC_wscrl(WINDOW *win, const int top, const int bottom, int n)
         return ERR;
 
     blank = win->_bkgd;
+    line_size = win->_maxx * sizeof( chtype);
     start = top;
     end = bottom + 1;
     n_lines = end - start;
@@ -60,25 +66,34 @@ int PDC_wscrl(WINDOW *win, const int top, const int bottom, int n)
     {
         if( n > n_lines)
             n = n_lines;
-        memmove( win->_y[start], win->_y[start + n],
-                     (n_lines - n) * win->_maxx * sizeof( chtype));
-        tptr = win->_y[end - n];
+        for( y = start; y < end - n; y++)
+        {
+            memcpy( win->_y[y], win->_y[y + n], line_size);
+            PDC_copy_rgb( win, win->_y[y], win, win->_y[y + n], win->_maxx);
+        }
+        y = end - n;
     }
     else                  /* scroll down */
     {
         n = -n;
         if( n > n_lines)
             n = n_lines;
-        memmove( win->_y[start + n], win->_y[start],
-                     (n_lines - n) * win->_maxx * sizeof( chtype));
-        tptr = win->_y[top];
+        for( y = end - 1; y >= start + n; y--)
+        {
+            memcpy( win->_y[y], win->_y[y - n], line_size);
+            PDC_copy_rgb( win, win->_y[y], win, win->_y[y - n], win->_maxx);
+        }
+        y = start;
     }
 
         /* make blank lines */
 
-    endptr = tptr + n * win->_maxx;
-    while( tptr < endptr)
-        *tptr++ = blank;
+    for( ; n; n--, y++)
+    {
+        endptr = win->_y[y] + win->_maxx;
+        for( tptr = win->_y[y]; tptr < endptr; tptr++)
+            *tptr = blank;
+    }
 
     touchline(win, start, n_lines);
     return OK;
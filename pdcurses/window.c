@@ -1,6 +1,16 @@
 /* PDCursesMod */
 
 #include <stdlib.h>
+#include <string.h>
+#if defined( PDC_THREADS) && defined( _WIN32)
+   #define WIN32_LEAN_AND_MEAN
+   #include <windows.h>
+   #undef MOUSE_MOVED
+#elif defined( PDC_THREADS)
+   #include <pthread.h>
+   #include <sys/time.h>
+   #include <errno.h>
+#endif
 #include <curspriv.h>
 #include <assert.h>
 
@@ -31,6 +41,8 @@ window
     WINDOW *resize_window(WINDOW *win, int nlines, int ncols);
     int wresize(WINDOW *win, int nlines, int ncols);
 
+    int use_window(WINDOW *win, NCURSES_WINDOW_CB func, void *data);
+
 ### Description
 
    newwin() creates a new window with the given number of lines, nlines
@@ -86,13 +98,28 @@ window
    parent's windows have been touched.
 
    resize_window() allows the user to resize an existing window. It
-   returns the pointer to the new window, or NULL on failure.
+   returns the pointer to the new window, or NULL on failure. A window
+   keeps the largest size it has been allocated, so shrinking it, and
+   growing it back within that size, reuses its memory; this is what
+   keeps resize_term() (which resizes stdscr and curscr) from
+   reallocating on every step of a window being dragged to a new size.
 
    wresize() is an ncurses-compatible wrapper for resize_window(). Note
    that, unlike ncurses, it will NOT process any subwindows of the
    window. (However, you still can call it _on_ subwindows.) It returns
    OK or ERR.
 
+   use_window() calls func(win, data) while holding the lock for win,
+   and returns whatever func returns. In a library built with
+   PDC_THREADS, this lets several threads draw into their own windows
+   at the same time; a window and its subwindows share one lock, since
+   they share memory. Call wnoutrefresh() from within func to hand the
+   changes over to curscr; that step briefly takes the screen lock (see
+   use_screen()), and another thread can then call doupdate(). Don't
+   call use_window() for another window from within func, and don't call
+   use_window() from within a use_screen() callback. Without
+   PDC_THREADS, use_window() just calls func.
+
 ### Return Value
 
    newwin(), subwin(), derwin() and dupwin() return a pointer to the new
@@ -127,6 +154,7 @@ window
     wsyncdown                   Y       Y       Y
     wresize                     -       Y       Y
     resize_window               -       -       -
+    use_window                  -       Y       -
 
 **man-end****************************************************************/
 
@@ -142,6 +170,25 @@ window
    PDC_sync() handles wrefresh() and wsyncup() calls when a window is
    changed.
 
+   PDC_rgb_cell() returns the place in the RGB plane (see PDC_wset_rgb())
+   for a cell of a window,  allocating the plane if 'create' is set;  it
+   returns NULL if the plane doesn't exist or couldn't be allocated.  The
+   plane belongs to the window that owns the lines,  so subwindows share
+   it.  PDC_copy_rgb() copies n cells' worth of plane from one window to
+   another (or within a window) alongside a copy of the cells themselves.
+   PDC_set_cell_rgb() stores the window's current direct colors for a
+   cell,  and returns TRUE if that changed them.
+
+   With PDC_THREADS,  PDC_lock_window() and PDC_unlock_window() take
+   and release the (recursive) lock for a window tree;  PDC_lock_screen()
+   and PDC_unlock_screen() do the same for SP, curscr and the window
+   list.  PDC_wait_screen() must be called with the screen lock held
+   exactly once,  and waits up to 'ms' milliseconds (forever if ms < 0)
+   for another thread to call PDC_signal_screen();  if the lock is held
+   more than once,  it returns at once,  as if it had timed out.  Use the PDC_LOCK_SCREEN(),
+   PDC_UNLOCK_SCREEN() and PDC_SIGNAL_SCREEN() macros,  which vanish in
+   unthreaded builds.
+
 **library-internals-end**************************************************/
 
 WINDOW *PDC_makenew(int nlines, int ncols, int begy, int begx)
@@ -180,6 +227,8 @@ WINDOW *PDC_makenew(int nlines, int ncols, int begy, int begx)
 
     win->_maxy = nlines;  /* real max screen size */
     win->_maxx = ncols;   /* real max screen size */
+    win->_maxy_alloc = nlines;
+    win->_maxx_alloc = ncols;
     win->_begy = begy;
     win->_begx = begx;
     win->_bkgd = ' ';     /* wrs 4/10/93 -- initialize background to blank */
@@ -206,8 +255,8 @@ WINDOW *PDC_makelines(WINDOW *win)
     assert( win->_maxy > 0);
     assert( win->_maxx > 0);
 
-    nlines = win->_maxy;
-    ncols = win->_maxx;
+    nlines = win->_maxy_alloc;
+    ncols = win->_maxx_alloc;
 
     win->_y[0] = (chtype *)malloc(ncols * nlines * sizeof(chtype));
     assert( win->_y[0]);
@@ -224,6 +273,49 @@ WINDOW *PDC_makelines(WINDOW *win)
     return win;
 }
 
+static WINDOW *_lines_owner( const WINDOW *win)
+{
+    while( (win->_flags & (_SUBWIN | _SUBPAD)) && win->_parent)
+        win = win->_parent;
+    return( (WINDOW *)win);
+}
+
+uint64_t *PDC_rgb_cell( const WINDOW *subwin, const chtype *cell,
+                        const bool create)
+{
+    WINDOW *win = _lines_owner( subwin);
+    size_t n_cells;
+    ptrdiff_t offset;
+
+    n_cells = (size_t)win->_maxy_alloc * (size_t)win->_maxx_alloc;
+    offset = cell - win->_y[0];
+    if( offset < 0 || (size_t)offset >= n_cells)
+        return( NULL);
+    if( !win->_rgb && create)
+        win->_rgb = (uint64_t *)calloc( n_cells, sizeof( uint64_t));
+    return( win->_rgb ? win->_rgb + offset : NULL);
+}
+
+void PDC_copy_rgb( WINDOW *dest, const chtype *dcell, const WINDOW *src,
+                   const chtype *scell, const int n)
+{
+    const uint64_t *from = PDC_rgb_cell( src, scell, FALSE);
+    uint64_t *to;
+
+    if( from && n > 0 && (to = PDC_rgb_cell( dest, dcell, TRUE)) != NULL)
+        memmove( to, from, n * sizeof( uint64_t));
+}
+
+bool PDC_set_cell_rgb( WINDOW *win, const chtype *cell)
+{
+    uint64_t *rgb = PDC_rgb_cell( win, cell, TRUE);
+
+    if( !rgb || *rgb == win->_direct_rgb)
+        return( FALSE);
+    *rgb = win->_direct_rgb;
+    return( TRUE);
+}
+
 void PDC_sync(WINDOW *win)
 {
     PDC_LOG(("PDC_sync() - called:\n"));
@@ -234,6 +326,170 @@ void PDC_sync(WINDOW *win)
         wsyncup(win);
 }
 
+#ifdef PDC_THREADS
+
+/* Rather than adding a mutex to each WINDOW (and having to worry about
+its lifetime),  windows hash into a fixed table of locks.  The hash is on
+the top-level ancestor,  since subwindows share their parent's memory.
+Two unrelated windows may occasionally share a lock;  that costs a little
+parallelism,  but never correctness. */
+
+#define N_WINDOW_LOCKS 64
+
+#ifdef _WIN32
+static CRITICAL_SECTION _window_locks[N_WINDOW_LOCKS], _screen_lock;
+static CONDITION_VARIABLE _screen_cond;
+static INIT_ONCE _locks_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK _init_locks( PINIT_ONCE once, PVOID param, PVOID *context)
+{
+    int i;
+
+    INTENTIONALLY_UNUSED_PARAMETER( once);
+    INTENTIONALLY_UNUSED_PARAMETER( param);
+    INTENTIONALLY_UNUSED_PARAMETER( context);
+    for( i = 0; i < N_WINDOW_LOCKS; i++)
+        InitializeCriticalSection( _window_locks + i);
+    InitializeCriticalSection( &_screen_lock);
+    InitializeConditionVariable( &_screen_cond);
+    return( TRUE);
+}
+
+#define INIT_LOCKS()    InitOnceExecuteOnce( &_locks_once, _init_locks, NULL, NULL)
+#define LOCK( m)        EnterCriticalSection( m)
+#define UNLOCK( m)      LeaveCriticalSection( m)
+#else
+static pthread_mutex_t _window_locks[N_WINDOW_LOCKS], _screen_lock;
+static pthread_cond_t _screen_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t _locks_once = PTHREAD_ONCE_INIT;
+
+static void _init_locks( void)
+{
+    pthread_mutexattr_t attr;
+    int i;
+
+    pthread_mutexattr_init( &attr);
+    pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE);
+    for( i = 0; i < N_WINDOW_LOCKS; i++)
+        pthread_mutex_init( _window_locks + i, &attr);
+    pthread_mutex_init( &_screen_lock, &attr);
+    pthread_mutexattr_destroy( &attr);
+}
+
+#define INIT_LOCKS()    pthread_once( &_locks_once, _init_locks)
+#define LOCK( m)        pthread_mutex_lock( m)
+#define UNLOCK( m)      pthread_mutex_unlock( m)
+#endif
+
+static int _window_lock_idx( const WINDOW *win)
+{
+    uintptr_t hash;
+
+    while( win->_parent)
+        win = win->_parent;
+    hash = (uintptr_t)win;
+    hash ^= hash >> 7;
+    hash ^= hash >> 13;
+    return( (int)( hash % N_WINDOW_LOCKS));
+}
+
+void PDC_lock_window( const WINDOW *win)
+{
+    INIT_LOCKS( );
+    LOCK( _window_locks + _window_lock_idx( win));
+}
+
+void PDC_unlock_window( const WINDOW *win)
+{
+    UNLOCK( _window_locks + _window_lock_idx( win));
+}
+
+/* How many times the owning thread has taken the screen lock;  only
+touched with the lock held.  A condition variable wait releases the lock
+just once,  so waiting with it held more than once would deadlock. */
+
+static int _screen_lock_depth = 0;
+
+void PDC_lock_screen( void)
+{
+    INIT_LOCKS( );
+    LOCK( &_screen_lock);
+    _screen_lock_depth++;
+}
+
+void PDC_unlock_screen( void)
+{
+    _screen_lock_depth--;
+    UNLOCK( &_screen_lock);
+}
+
+void PDC_signal_screen( void)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable( &_screen_cond);
+#else
+    pthread_cond_broadcast( &_screen_cond);
+#endif
+}
+
+/* Returns 0 if signalled,  nonzero on timeout.  Spurious wakeups count
+as being signalled;  callers re-check whatever they were waiting for. */
+
+int PDC_wait_screen( const int ms)
+{
+    int rval;
+#ifndef _WIN32
+    struct timeval now;
+    struct timespec until;
+#endif
+
+    if( _screen_lock_depth != 1)
+        return( -1);
+    _screen_lock_depth = 0;        /* other threads may take it now */
+#ifdef _WIN32
+    rval = !SleepConditionVariableCS( &_screen_cond, &_screen_lock,
+                             (ms < 0 ? INFINITE : (DWORD)ms));
+#else
+    if( ms < 0)
+        rval = pthread_cond_wait( &_screen_cond, &_screen_lock);
+    else
+    {
+        gettimeofday( &now, NULL);
+        until.tv_sec = now.tv_sec + ms / 1000;
+        until.tv_nsec = (now.tv_usec + (ms % 1000) * 1000L) * 1000L;
+        if( until.tv_nsec >= 1000000000L)
+        {
+            until.tv_sec++;
+            until.tv_nsec -= 1000000000L;
+        }
+        rval = (ETIMEDOUT == pthread_cond_timedwait( &_screen_cond,
+                                              &_screen_lock, &until));
+    }
+#endif
+    _screen_lock_depth = 1;
+    return( rval);
+}
+#endif      /* #ifdef PDC_THREADS */
+
+int use_window( WINDOW *win, NCURSES_WINDOW_CB func, void *data)
+{
+    int rval;
+
+    PDC_LOG(("use_window() - called\n"));
+
+    assert( win && func);
+    if( !win || !func)
+        return ERR;
+#ifdef PDC_THREADS
+    PDC_lock_window( win);
+#endif
+    rval = func( win, data);
+#ifdef PDC_THREADS
+    PDC_unlock_window( win);
+#endif
+    return( rval);
+}
+
 /* See the OpenBSD and FreeBSD reallocarray() extension.  This is similar,  but
 exists for all platforms,  and always frees the pointer and returns NULL for a
 zero-byte allocation.  realloc() does this on most platforms, but not FreeBSD,
@@ -268,10 +524,12 @@ static void _resize_window_list( SCREEN *scr_ptr)
 
 void PDC_add_window_to_list( WINDOW *win)
 {
+   PDC_LOCK_SCREEN( );
    SP->n_windows++;
    _resize_window_list( SP);
    assert( SP->window_list);
    SP->window_list[SP->n_windows - 1] = win;
+   PDC_UNLOCK_SCREEN( );
 }
 
 WINDOW *newwin(int nlines, int ncols, int begy, int begx)
@@ -327,12 +585,16 @@ int delwin(WINDOW *win)
     if (!win)
         return ERR;
 
+    PDC_LOCK_SCREEN( );
             /* make sure win has no subwindows */
     for( i = 0; i < SP->n_windows; i++)
     {
         assert( SP->window_list[i]->_parent != win);
         if( SP->window_list[i]->_parent == win)
+        {
+            PDC_UNLOCK_SCREEN( );
             return( ERR);
+        }
     }
 
     if( win->_firstch && win->_y && win->_y[0])
@@ -342,17 +604,23 @@ int delwin(WINDOW *win)
             i++;
         assert( i < SP->n_windows);
         if( i == SP->n_windows)
+        {
+            PDC_UNLOCK_SCREEN( );
             return( ERR);
+        }
         SP->n_windows--;        /* remove win from window list */
         SP->window_list[i] = SP->window_list[SP->n_windows];
         _resize_window_list( SP);
     }
+    PDC_UNLOCK_SCREEN( );
 
     /* subwindows use parents' lines */
 
     if (!(win->_flags & (_SUBWIN|_SUBPAD)))
         if (win->_y[0])
            free(win->_y[0]);
+    if( win->_rgb)
+        free( win->_rgb);
 
     if( win->_firstch)
         free(win->_firstch);
@@ -422,6 +690,7 @@ WINDOW *subwin(WINDOW *orig, int nlines, int ncols, int begy, int begx)
     /* initialize window variables */
 
     win->_attrs = orig->_attrs;
+    win->_direct_rgb = orig->_direct_rgb;
     win->_bkgd = orig->_bkgd;
     win->_leaveit = orig->_leaveit;
     win->_scroll = orig->_scroll;
@@ -504,6 +773,7 @@ WINDOW *dupwin(WINDOW *win)
              ptr < new_win->_y[i] + ncols; ptr++, ptr1++)
             *ptr = *ptr1;
 
+        PDC_copy_rgb( new_win, new_win->_y[i], win, win->_y[i], ncols);
         PDC_mark_line_as_changed( new_win, i);
     }
 
@@ -515,6 +785,7 @@ WINDOW *dupwin(WINDOW *win)
     new_win->_begx = win->_begx;
     new_win->_flags = win->_flags;
     new_win->_attrs = win->_attrs;
+    new_win->_direct_rgb = win->_direct_rgb;
     new_win->_clear = win->_clear;
     new_win->_leaveit = win->_leaveit;
     new_win->_scroll = win->_scroll;
@@ -544,6 +815,34 @@ WINDOW *wgetparent(const WINDOW *win)
     return win->_parent;
 }
 
+/* Resize a window within the lines it already has.  Cells in the overlap
+keep their place;  cells newly brought into view (which may hold stale
+content from when the window was last that large) are blanked. */
+
+static WINDOW *_resize_in_place(WINDOW *win, int nlines, int ncols,
+                                int begy, int begx)
+{
+    const int old_maxy = win->_maxy, old_maxx = win->_maxx;
+    int i, j;
+
+    for (i = 0; i < nlines; i++)
+        for (j = (i < old_maxy ? old_maxx : 0); j < ncols; j++)
+            win->_y[i][j] = win->_bkgd;
+
+    win->_maxy = nlines;
+    win->_maxx = ncols;
+    win->_begy = begy;
+    win->_begx = begx;
+    win->_curx = min(win->_curx, ncols - 1);
+    win->_cury = min(win->_cury, nlines - 1);
+    win->_tmarg = (win->_tmarg > nlines - 1) ? 0 : win->_tmarg;
+    win->_bmarg = (win->_bmarg == old_maxy - 1) ?
+                  nlines - 1 : min(win->_bmarg, nlines - 1);
+    touchwin(win);
+
+    return win;
+}
+
 WINDOW *resize_window(WINDOW *win, int nlines, int ncols)
 {
     WINDOW *new_win;
@@ -583,9 +882,17 @@ WINDOW *resize_window(WINDOW *win, int nlines, int ncols)
             new_begx = win->_begx;
         }
 
-        new_win = PDC_makenew(nlines, ncols, new_begy, new_begx);
+        if (!nlines || !ncols)
+            return (WINDOW *)NULL;
+        if (nlines <= win->_maxy_alloc && ncols <= win->_maxx_alloc)
+            return _resize_in_place(win, nlines, ncols, new_begy, new_begx);
+
+        new_win = PDC_makenew(max(nlines, win->_maxy_alloc),
+                    max(ncols, win->_maxx_alloc), new_begy, new_begx);
         if (!new_win)
             return (WINDOW *)NULL;
+        new_win->_maxy = nlines;
+        new_win->_maxx = ncols;
     }
     save_curx = min(win->_curx, (new_win->_maxx - 1));
     save_cury = min(win->_cury, (new_win->_maxy - 1));
@@ -604,10 +911,13 @@ WINDOW *resize_window(WINDOW *win, int nlines, int ncols)
 
         if (win->_y[0])
             free(win->_y[0]);
+        if( win->_rgb)
+            free( win->_rgb);
     }
 
     new_win->_flags = win->_flags;
     new_win->_attrs = win->_attrs;
+    new_win->_direct_rgb = win->_direct_rgb;
     new_win->_clear = win->_clear;
     new_win->_leaveit = win->_leaveit;
     new_win->_scroll = win->_scroll;
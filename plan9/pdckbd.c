@@ -19,6 +19,20 @@ int PDC_get_key(void)
 }
 
 
+int PDC_get_input_fd(void)
+{
+	PDC_LOG(("PDC_get_input_fd() - called\n"));
+	return -1;
+}
+
+
+void PDC_wait_for_input(int ms)
+{
+	PDC_LOG(("PDC_wait_for_input() - called\n"));
+	PDC_napms((ms < 0 || ms > 50) ? 50 : ms);
+}
+
+
 void PDC_flushinp(void)
 {
 	PDC_LOG(("PDC_flushinp() - called\n"));
@@ -0,0 +1 @@
+#include "../common/pdcclip.c"
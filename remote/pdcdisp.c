@@ -0,0 +1,488 @@
+/* PDCursesMod */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define USE_UNICODE_ACS_CHARS 1
+
+#define PDC_RMT_PORT
+#include "curspriv.h"
+#include "pdcremote.h"
+#include "../common/acs_defs.h"
+#include "../common/pdccolor.h"
+
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+   int PDC_expand_combined_characters( const cchar_t c, cchar_t *added);  /* addch.c */
+#endif
+
+int PDC_wc_to_utf8( char *dest, const int32_t code);      /* util.c */
+
+/* Each doupdate( ) becomes one PDC_RMT_FRAME message.  The ops for it
+are gathered here by PDC_transform_line( ) and PDC_gotoyx( ),  then sent
+by PDC_doupdate( ).  See pdcremote.h and README.md for the format. */
+
+static unsigned char *_frame = NULL;
+static size_t _frame_len, _frame_alloced;
+
+static int _sent_lines = -1, _sent_cols = -1;
+static int _sent_row = -1, _sent_col = -1, _sent_vis = -1;
+static int _cursor_row, _cursor_col;
+
+/* The viewer's attribute table,  as we've defined it.  It's direct-
+mapped:  an attribute always goes in the slot its hash selects,  evicting
+whatever was there.  Collisions just cost a redefinition. */
+
+static struct
+{
+   unsigned long flags, fg, bg;
+   bool in_use;
+} _attrs[PDC_RMT_N_ATTRS];
+
+/* What the viewer has on screen,  plus a hash of each row,  so that a
+row matching one already there (as when scrolling) can be sent as a
+PDC_RMT_OP_COPYROW instead of its text. */
+
+static chtype *_shadow = NULL;
+static uint32_t *_row_hash = NULL;
+static char *_hash_stale = NULL;
+static int _shadow_lines, _shadow_cols;
+static int _last_row_tried = -1, _copied_row = -1;
+
+static bool _frame_reserve( const size_t n_bytes)
+{
+   if( _frame_len + n_bytes > _frame_alloced)
+      {
+      size_t new_size = (_frame_alloced ? _frame_alloced * 2 : 4096);
+      unsigned char *new_frame;
+
+      while( new_size < _frame_len + n_bytes)
+         new_size *= 2;
+      new_frame = (unsigned char *)realloc( _frame, new_size);
+      if( !new_frame)
+         return( FALSE);
+      _frame = new_frame;
+      _frame_alloced = new_size;
+      }
+   return( TRUE);
+}
+
+static void _put_byte( const int byte)
+{
+   if( _frame_reserve( 1))
+      _frame[_frame_len++] = (unsigned char)byte;
+}
+
+static void _put_varint( unsigned long ival)
+{
+   while( ival >= 0x80)
+      {
+      _put_byte( (int)( ival & 0x7f) | 0x80);
+      ival >>= 7;
+      }
+   _put_byte( (int)ival);
+}
+
+static void _put_bytes( const char *bytes, const size_t n_bytes)
+{
+   if( _frame_reserve( n_bytes))
+      {
+      memcpy( _frame + _frame_len, bytes, n_bytes);
+      _frame_len += n_bytes;
+      }
+}
+
+/* Ops describe the screen at a given size;  announce it if it has
+changed since the last frame,  before anything else goes out. */
+
+static void _start_op( void)
+{
+   if( SP->lines != _sent_lines || SP->cols != _sent_cols)
+      {
+      _put_byte( PDC_RMT_OP_SIZE);
+      _put_varint( (unsigned long)SP->lines);
+      _put_varint( (unsigned long)SP->cols);
+      _sent_lines = SP->lines;
+      _sent_cols = SP->cols;
+      _sent_row = -1;        /* viewer must be told the cursor again */
+      }
+}
+
+static int _write_all( const unsigned char *buff, size_t n_bytes)
+{
+   while( n_bytes)
+      {
+      const ssize_t written = write( PDC_rmt_out_fd, buff, n_bytes);
+
+      if( written < 0)
+         {
+         if( errno == EINTR)
+            continue;
+         return( -1);
+         }
+      buff += written;
+      n_bytes -= (size_t)written;
+      }
+   return( 0);
+}
+
+int PDC_rmt_send( const int type, const unsigned char *payload,
+                                  const size_t len)
+{
+   unsigned char header[12];
+   size_t i = 1, ilen = len;
+
+   if( PDC_rmt_out_fd < 0)
+      return( -1);
+   header[0] = (unsigned char)type;
+   while( ilen >= 0x80)
+      {
+      header[i++] = (unsigned char)( (ilen & 0x7f) | 0x80);
+      ilen >>= 7;
+      }
+   header[i++] = (unsigned char)ilen;
+   if( _write_all( header, i) || (len && _write_all( payload, len)))
+      return( -1);
+   return( 0);
+}
+
+/* Find (or define) the viewer's attribute slot for a cell's attributes
+and colors.  Colors are sent as RGB,  so the viewer needn't know about
+color pairs or the palette.  As in the VT port,  reverse video is left
+to the viewer's own A_REVERSE. */
+
+static chtype _cached_attrs;
+static int _cached_idx = -1;
+
+static int _attr_index( const chtype ch)
+{
+   const chtype attrs = (ch & ~A_CHARTEXT);
+   unsigned long flags = 0, fg, bg;
+   PACKED_RGB fg_rgb, bg_rgb;
+   int idx;
+
+   if( _cached_idx >= 0 && attrs == _cached_attrs)
+      return( _cached_idx);
+   PDC_get_rgb_values( attrs & ~A_REVERSE, &fg_rgb, &bg_rgb);
+   fg = (fg_rgb == (PACKED_RGB)-1 ? 0 : (unsigned long)fg_rgb + 1);
+   bg = (bg_rgb == (PACKED_RGB)-1 ? 0 : (unsigned long)bg_rgb + 1);
+   if( attrs & SP->termattrs & A_BOLD)
+      flags |= PDC_RMT_BOLD;
+   if( attrs & A_UNDERLINE)
+      flags |= PDC_RMT_UNDERLINE;
+   if( attrs & A_ITALIC)
+      flags |= PDC_RMT_ITALIC;
+   if( attrs & A_REVERSE)
+      flags |= PDC_RMT_REVERSE;
+   if( attrs & A_STRIKEOUT)
+      flags |= PDC_RMT_STRIKEOUT;
+   if( attrs & SP->termattrs & A_BLINK)
+      flags |= PDC_RMT_BLINK;
+   if( attrs & A_LEFT)
+      flags |= PDC_RMT_LEFT;
+   if( attrs & A_RIGHT)
+      flags |= PDC_RMT_RIGHT;
+   if( attrs & A_TOP)
+      flags |= PDC_RMT_TOP;
+   idx = (int)(((flags * 0x9e3779b1ul) ^ (fg * 0x85ebca6bul)
+                            ^ (bg * 0xc2b2ae35ul)) % PDC_RMT_N_ATTRS);
+   if( !_attrs[idx].in_use || _attrs[idx].flags != flags
+               || _attrs[idx].fg != fg || _attrs[idx].bg != bg)
+      {
+      _attrs[idx].in_use = TRUE;
+      _attrs[idx].flags = flags;
+      _attrs[idx].fg = fg;
+      _attrs[idx].bg = bg;
+      _put_byte( PDC_RMT_OP_ATTR);
+      _put_varint( (unsigned long)idx);
+      _put_varint( flags);
+      _put_varint( fg);
+      _put_varint( bg);
+      }
+   _cached_attrs = attrs;
+   _cached_idx = idx;
+   return( idx);
+}
+
+static int _cell_char( const chtype ch)
+{
+   int rval = (int)( ch & A_CHARTEXT);
+
+   if( rval == MAX_UNICODE)      /* right half of a fullwidth character */
+      return( 0);
+   if( _is_altcharset( ch))
+      rval = (int)acs_map[rval & 0x7f];
+   if( rval < (int)' ' || (rval >= 0x7f && rval <= 0x9f))
+      rval = ' ';
+   return( rval);
+}
+
+static void _put_char( const int ch)
+{
+   char utf8[8];
+
+   _put_bytes( utf8, (size_t)PDC_wc_to_utf8( utf8, (int32_t)ch));
+}
+
+static void _put_text_op( const int n_cells, const int how, const int attr_idx)
+{
+   _put_byte( PDC_RMT_OP_TEXT);
+   _put_varint( ((unsigned long)n_cells << 2) | (unsigned long)how);
+   _put_varint( (unsigned long)attr_idx);
+}
+
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+static void _put_cluster( const chtype ch, const int attr_idx)
+{
+   char text[200];
+   int n_bytes;
+   cchar_t root = (ch & A_CHARTEXT), newchar;
+
+   while( (root = PDC_expand_combined_characters( root,
+                              &newchar)) > MAX_UNICODE)
+       ;
+   n_bytes = PDC_wc_to_utf8( text, (int32_t)root);
+   root = (ch & A_CHARTEXT);
+   while( (root = PDC_expand_combined_characters( root,
+                              &newchar)) > MAX_UNICODE
+                              && n_bytes < (int)sizeof( text) - 8)
+       n_bytes += PDC_wc_to_utf8( text + n_bytes, (int32_t)newchar);
+   n_bytes += PDC_wc_to_utf8( text + n_bytes, (int32_t)newchar);
+   _put_text_op( 1, PDC_RMT_TEXT_CLUSTER, attr_idx);
+   _put_varint( (unsigned long)n_bytes);
+   _put_bytes( text, (size_t)n_bytes);
+}
+#endif
+
+/* Runs of four or more identical characters (blank lines,  box
+edges) go out as a single repeated character. */
+
+#define MIN_REPEAT 4
+
+static void _put_cells( const chtype *srcp, const int len, const int attr_idx)
+{
+   int i = 0, start = 0;
+
+   while( i < len)
+      {
+      const int ch = _cell_char( srcp[i]);
+      int n = 1;
+
+      while( i + n < len && _cell_char( srcp[i + n]) == ch)
+         n++;
+      if( n >= MIN_REPEAT)
+         {
+         if( i > start)
+            {
+            _put_text_op( i - start, 0, attr_idx);
+            while( start < i)
+               _put_char( _cell_char( srcp[start++]));
+            }
+         _put_text_op( n, PDC_RMT_TEXT_REPEAT, attr_idx);
+         _put_char( ch);
+         start = i + n;
+         }
+      i += n;
+      }
+   if( len > start)
+      {
+      _put_text_op( len - start, 0, attr_idx);
+      while( start < len)
+         _put_char( _cell_char( srcp[start++]));
+      }
+}
+
+static uint32_t _hash_cells( const chtype *cells, int n)
+{
+   uint32_t rval = 2166136261u;      /* FNV-1a */
+
+   while( n--)
+      {
+      rval = (rval ^ (uint32_t)( *cells ^ (*cells >> 16 >> 16))) * 16777619u;
+      cells++;
+      }
+   return( rval);
+}
+
+static void _check_shadow( void)
+{
+   if( SP->lines != _shadow_lines || SP->cols != _shadow_cols)
+      {
+      const size_t n_cells = (size_t)SP->lines * (size_t)SP->cols;
+
+      free( _shadow);
+      free( _row_hash);
+      free( _hash_stale);
+      _shadow = (chtype *)calloc( n_cells, sizeof( chtype));
+      _row_hash = (uint32_t *)calloc( SP->lines, sizeof( uint32_t));
+      _hash_stale = (char *)malloc( SP->lines);
+      if( !_shadow || !_row_hash || !_hash_stale)
+         {
+         free( _shadow);
+         free( _row_hash);
+         free( _hash_stale);
+         _shadow = NULL;
+         _row_hash = NULL;
+         _hash_stale = NULL;
+         _shadow_lines = _shadow_cols = 0;
+         return;
+         }
+      memset( _hash_stale, 1, SP->lines);
+      _shadow_lines = SP->lines;
+      _shadow_cols = SP->cols;
+      }
+}
+
+/* If the new content of this row is already on the viewer's screen
+in another row,  have the viewer copy it.  Not done for a full redraw,
+since the viewer's screen may then be out of date,  nor for rows with
+direct colors,  whose cells in curscr don't say what the colors are. */
+
+static bool _try_copy_row( const int lineno)
+{
+   const chtype *row = curscr->_y[lineno];
+   chtype *dest = _shadow + lineno * _shadow_cols;
+   const size_t row_bytes = _shadow_cols * sizeof( chtype);
+   uint32_t hash;
+   int i;
+
+   if( curscr->_clear || !memcmp( dest, row, row_bytes))
+      return( FALSE);
+   for( i = 0; i < _shadow_cols; i++)
+      if( row[i] & A_DIRECT_COLOR)
+         return( FALSE);
+   hash = _hash_cells( row, _shadow_cols);
+   for( i = 0; i < _shadow_lines; i++)
+      if( i != lineno)
+         {
+         const chtype *src = _shadow + i * _shadow_cols;
+
+         if( _hash_stale[i])
+            {
+            _row_hash[i] = _hash_cells( src, _shadow_cols);
+            _hash_stale[i] = 0;
+            }
+         if( _row_hash[i] == hash && !memcmp( src, row, row_bytes))
+            {
+            _put_byte( PDC_RMT_OP_COPYROW);
+            _put_varint( (unsigned long)i);
+            _put_varint( (unsigned long)lineno);
+            memcpy( dest, src, row_bytes);
+            _row_hash[lineno] = hash;
+            _hash_stale[lineno] = 0;
+            return( TRUE);
+            }
+         }
+   return( FALSE);
+}
+
+void PDC_gotoyx(int y, int x)
+{
+    _cursor_row = y;
+    _cursor_col = x;
+}
+
+void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
+{
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+            /* The core doesn't send the placeholder to the right of a
+               fullwidth character.  We do,  so the viewer knows that cell
+               is covered.  (srcp points into a row of curscr,  or into
+               refresh.c's copy of one with direct colors resolved,  which
+               includes the next cell.) */
+    if( x + len < SP->cols && (srcp[len] & A_CHARTEXT) == MAX_UNICODE)
+        len++;
+#endif
+    _start_op( );
+    _check_shadow( );
+    if( _shadow && lineno < _shadow_lines && x + len <= _shadow_cols)
+    {
+        if( lineno == _copied_row)
+            return;
+        if( lineno != _last_row_tried)
+        {
+            _last_row_tried = lineno;
+            if( _try_copy_row( lineno))
+            {
+                _copied_row = lineno;
+                return;
+            }
+        }
+        memcpy( _shadow + lineno * _shadow_cols + x, srcp, len * sizeof( chtype));
+        _hash_stale[lineno] = 1;
+    }
+    _cached_idx = -1;     /* colors of a pair may have changed since */
+    _put_byte( PDC_RMT_OP_MOVE);
+    _put_varint( (unsigned long)lineno);
+    _put_varint( (unsigned long)x);
+    while( len)
+    {
+        const chtype attrs = (*srcp & ~A_CHARTEXT);
+        const int attr_idx = _attr_index( *srcp);
+        int count = 0;
+
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+        if( (*srcp & A_CHARTEXT) > MAX_UNICODE)
+        {
+            _put_cluster( *srcp, attr_idx);
+            srcp++;
+            len--;
+            continue;
+        }
+#endif
+        while( count < len && (srcp[count] & ~A_CHARTEXT) == attrs
+                   && (srcp[count] & A_CHARTEXT) <= MAX_UNICODE)
+            count++;
+        _put_cells( srcp, count, attr_idx);
+        srcp += count;
+        len -= count;
+    }
+}
+
+void PDC_doupdate(void)
+{
+    const int vis = (SP->visibility ? 1 : 0);
+
+    if( vis != _sent_vis || (vis && (_cursor_row != _sent_row
+                                  || _cursor_col != _sent_col)))
+    {
+        _start_op( );
+        _put_byte( PDC_RMT_OP_CURSOR);
+        _put_varint( (unsigned long)_cursor_row);
+        _put_varint( (unsigned long)_cursor_col);
+        _put_varint( (unsigned long)SP->visibility);
+        _sent_vis = vis;
+        _sent_row = _cursor_row;
+        _sent_col = _cursor_col;
+    }
+    if( _frame_len)
+    {
+        PDC_rmt_send( PDC_RMT_FRAME, _frame, _frame_len);
+        _frame_len = 0;
+    }
+    _last_row_tried = _copied_row = -1;
+}
+
+/* Called from PDC_scr_free( ):  forget everything we've told the viewer,
+so a later initscr( ) starts from scratch. */
+
+void PDC_rmt_free_display( void)
+{
+    free( _frame);
+    free( _shadow);
+    free( _row_hash);
+    free( _hash_stale);
+    _frame = NULL;
+    _shadow = NULL;
+    _row_hash = NULL;
+    _hash_stale = NULL;
+    _frame_len = _frame_alloced = 0;
+    _shadow_lines = _shadow_cols = 0;
+    _sent_lines = _sent_cols = -1;
+    _sent_row = _sent_col = _sent_vis = -1;
+    _cached_idx = -1;
+    memset( _attrs, 0, sizeof( _attrs));
+}
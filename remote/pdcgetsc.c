@@ -0,0 +1,25 @@
+/* PDCursesMod */
+
+#define PDC_RMT_PORT
+#include <curspriv.h>
+#include "pdcremote.h"
+
+int PDC_get_cursor_mode(void)
+{
+    PDC_LOG(("PDC_get_cursor_mode() - called\n"));
+
+    return SP->visibility;
+}
+
+
+int PDC_get_columns(void)
+{
+    PDC_LOG(("PDC_get_columns() - called\n"));
+    return( PDC_rmt_cols);
+}
+
+int PDC_get_rows(void)
+{
+    PDC_LOG(("PDC_get_rows() - called\n"));
+    return( PDC_rmt_lines);
+}
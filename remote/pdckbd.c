@@ -0,0 +1,243 @@
+/* PDCursesMod */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/time.h>
+
+#define PDC_RMT_PORT
+#include "curspriv.h"
+#include "pdcremote.h"
+
+/* Input comes from the viewer as PDC_RMT_KEY,  PDC_RMT_MOUSE and
+PDC_RMT_SIZE messages.  Bytes are gathered here until at least one whole
+message has arrived;  PDC_get_key( ) then takes one message off the
+front.  The viewer has already done the click/double-click work,  so a
+mouse message is passed along as-is. */
+
+static unsigned char *_in_buff = NULL;
+static size_t _in_len, _in_alloced;
+
+void PDC_rmt_free_input( void)
+{
+   free( _in_buff);
+   _in_buff = NULL;
+   _in_len = _in_alloced = 0;
+}
+
+static int _get_varint( const unsigned char **bytes, const unsigned char *end,
+                                unsigned long *ival)
+{
+   int shift = 0;
+
+   *ival = 0;
+   while( *bytes < end && shift < 63)
+      {
+      const int byte = *(*bytes)++;
+
+      *ival |= (unsigned long)( byte & 0x7f) << shift;
+      if( !(byte & 0x80))
+         return( 0);
+      shift += 7;
+      }
+   return( -1);
+}
+
+/* Returns the total size of the message at the front of the buffer,
+or 0 if it hasn't all arrived yet. */
+
+static size_t _message_size( size_t *header_size)
+{
+   const unsigned char *tptr = _in_buff + 1;
+   unsigned long len;
+
+   if( _in_len < 2 || _get_varint( &tptr, _in_buff + _in_len, &len))
+      return( 0);
+   if( len > PDC_RMT_MAX_PAYLOAD)     /* garbage;  throw it all out */
+      {
+      _in_len = 0;
+      return( 0);
+      }
+   *header_size = (size_t)( tptr - _in_buff);
+   if( *header_size + len > _in_len)
+      return( 0);
+   return( *header_size + (size_t)len);
+}
+
+bool PDC_rmt_have_message( void)
+{
+   size_t header_size;
+
+   return( _message_size( &header_size) > 0);
+}
+
+/* The viewer went away.  As with a hangup on a terminal,  there's no
+one left to talk to,  so we shut down. */
+
+static void _hang_up( void)
+{
+   if( PDC_rmt_out_fd >= 0 && PDC_rmt_out_fd != PDC_rmt_in_fd)
+      close( PDC_rmt_out_fd);
+   PDC_rmt_out_fd = -1;
+   PDC_scr_close( );
+   PDC_scr_free( );
+   exit( 0);
+}
+
+/* Read whatever the viewer has sent,  waiting up to wait_ms for it
+(forever if wait_ms < 0).  Returns the number of bytes read. */
+
+int PDC_rmt_read_input( const int wait_ms)
+{
+   struct timeval timeout;
+   fd_set rdset;
+   ssize_t n_read;
+
+   if( PDC_rmt_in_fd < 0)
+      return( 0);
+   FD_ZERO( &rdset);
+   FD_SET( PDC_rmt_in_fd, &rdset);
+   timeout.tv_sec = wait_ms / 1000;
+   timeout.tv_usec = (wait_ms % 1000) * 1000;
+   if( select( PDC_rmt_in_fd + 1, &rdset, NULL, NULL,
+                        (wait_ms >= 0 ? &timeout : NULL)) <= 0)
+      return( 0);
+   if( _in_alloced - _in_len < 256)
+      {
+      const size_t new_size = (_in_alloced ? _in_alloced * 2 : 1024);
+      unsigned char *new_buff = (unsigned char *)realloc( _in_buff, new_size);
+
+      if( !new_buff)
+         return( 0);
+      _in_buff = new_buff;
+      _in_alloced = new_size;
+      }
+   n_read = read( PDC_rmt_in_fd, _in_buff + _in_len, _in_alloced - _in_len);
+   if( n_read < 0 && (errno == EINTR || errno == EAGAIN))
+      return( 0);
+   if( n_read <= 0)
+      _hang_up( );
+   _in_len += (size_t)n_read;
+   return( (int)n_read);
+}
+
+bool PDC_check_key( void)
+{
+   if( !PDC_rmt_have_message( ))
+      PDC_rmt_read_input( 0);
+   return( PDC_rmt_have_message( ));
+}
+
+void PDC_wait_for_input( int ms)
+{
+   extern bool PDC_resize_occurred;
+
+   if( !PDC_resize_occurred && !PDC_rmt_have_message( ))
+      PDC_rmt_read_input( ms);
+}
+
+int PDC_get_input_fd( void)
+{
+   return( PDC_rmt_in_fd);
+}
+
+void PDC_flushinp( void)
+{
+   while( PDC_check_key( ))
+      PDC_get_key( );
+}
+
+static int _key_from_message( const int type, const unsigned char *tptr,
+                              const unsigned char *end)
+{
+   unsigned long args[8];
+   int n_args = 0, i, rval = -1;
+
+   while( n_args < 8 && !_get_varint( &tptr, end, args + n_args))
+      n_args++;
+   switch( type)
+      {
+      case PDC_RMT_KEY:
+         if( n_args >= 3)
+            {
+            SP->key_modifiers = (unsigned long)args[2];
+            if( args[0] == PDC_RMT_KEY_FUNC)
+               rval = (int)args[1] + KEY_OFFSET;
+            else
+               rval = (int)args[1];
+            }
+         break;
+      case PDC_RMT_MOUSE:
+         if( n_args >= 3)
+            {
+            memset( &SP->mouse_status, 0, sizeof( MOUSE_STATUS));
+            SP->mouse_status.x = (int)args[0];
+            SP->mouse_status.y = (int)args[1];
+            SP->mouse_status.changes = (int)args[2];
+            for( i = 3; i < n_args; i++)
+               SP->mouse_status.button[i - 3] = (short)args[i];
+            rval = KEY_MOUSE;
+            }
+         break;
+      case PDC_RMT_SIZE:
+         if( n_args >= 2 && args[0] > 1 && args[1] > 1
+                && ((int)args[0] != PDC_rmt_lines || (int)args[1] != PDC_rmt_cols))
+            {
+            PDC_rmt_lines = (int)args[0];
+            PDC_rmt_cols = (int)args[1];
+            SP->resized = TRUE;
+            rval = KEY_RESIZE;
+            }
+         break;
+      default:          /* unknown messages are ignored */
+         break;
+      }
+   return( rval);
+}
+
+int PDC_get_key( void)
+{
+   extern bool PDC_resize_occurred;
+   size_t header_size, msg_size;
+   int rval;
+
+   if( PDC_resize_occurred)
+      {
+      PDC_resize_occurred = FALSE;
+      return( KEY_RESIZE);
+      }
+   msg_size = _message_size( &header_size);
+   if( !msg_size)
+      return( -1);
+   rval = _key_from_message( _in_buff[0], _in_buff + header_size,
+                             _in_buff + msg_size);
+   _in_len -= msg_size;
+   memmove( _in_buff, _in_buff + msg_size, _in_len);
+   return( rval);
+}
+
+int PDC_modifiers_set( void)
+{
+   return( OK);
+}
+
+bool PDC_has_mouse( void)
+{
+   return TRUE;
+}
+
+/* The viewer always reports everything;  events the application
+didn't ask for are filtered out by the core,  as for the other ports. */
+
+int PDC_mouse_set( void)
+{
+   return( OK);
+}
+
+void PDC_set_keyboard_binary( bool on)
+{
+   INTENTIONALLY_UNUSED_PARAMETER( on);
+   return;
+}
@@ -0,0 +1,72 @@
+/* PDCursesMod */
+
+/* Wire protocol for the remote port,  shared by the library (pdc*.c) and
+the reference viewer (pdcview.c).  See README.md for the full layout.
+
+   Every message is one type byte,  the payload length as a varint,  then
+the payload.  Varints are unsigned LEB128 (seven bits per byte,  least
+significant first,  high bit set on all but the last byte).  Nothing in
+the protocol depends on the chtype size,  the KEY_OFFSET or the mmask_t
+layout of either end,  so a narrow library may talk to a wide viewer. */
+
+#define PDC_RMT_VERSION       1
+
+      /* library -> viewer */
+#define PDC_RMT_HELLO        'H'      /* varint version */
+#define PDC_RMT_FRAME        'F'      /* sequence of PDC_RMT_OP_xxx */
+#define PDC_RMT_BEEP         'B'      /* (empty) */
+#define PDC_RMT_TITLE        'T'      /* UTF-8 text */
+
+      /* viewer -> library */
+#define PDC_RMT_SIZE         'R'      /* varint lines, cols */
+#define PDC_RMT_KEY          'K'      /* varint kind, code, modifiers */
+#define PDC_RMT_MOUSE        'M'      /* varint x, y, changes, button[5] */
+
+      /* PDC_RMT_KEY kinds */
+#define PDC_RMT_KEY_CHAR      0       /* code is a Unicode code point */
+#define PDC_RMT_KEY_FUNC      1       /* code is key - KEY_OFFSET */
+
+      /* Ops within a frame.  The viewer applies them in order,  so each
+         one sees the screen as left by the ops before it. */
+#define PDC_RMT_OP_SIZE       1       /* varint lines, cols */
+#define PDC_RMT_OP_ATTR       2       /* varint idx, flags, fg, bg */
+#define PDC_RMT_OP_MOVE       3       /* varint row, col */
+#define PDC_RMT_OP_TEXT       4       /* varint (n << 2 | how), attr idx;  text */
+#define PDC_RMT_OP_COPYROW    5       /* varint src_row, dest_row */
+#define PDC_RMT_OP_CURSOR     6       /* varint row, col, visibility */
+
+      /* PDC_RMT_OP_TEXT draws n cells at the position set by the last
+         PDC_RMT_OP_MOVE,  and advances it.  With 'how' zero,  n UTF-8
+         characters follow;  with PDC_RMT_TEXT_REPEAT,  one character to be
+         repeated n times;  with PDC_RMT_TEXT_CLUSTER (and n == 1),  a
+         varint byte count,  then a base character and its combining marks.
+         A NUL character is the right half of the fullwidth character
+         before it,  and isn't drawn. */
+#define PDC_RMT_TEXT_REPEAT   1
+#define PDC_RMT_TEXT_CLUSTER  2
+
+      /* Attribute table size.  fg and bg are 0 for 'default color',  else
+         1 + (red | green << 8 | blue << 16). */
+#define PDC_RMT_N_ATTRS    1024
+
+#define PDC_RMT_BOLD       0x001
+#define PDC_RMT_UNDERLINE  0x002
+#define PDC_RMT_ITALIC     0x004
+#define PDC_RMT_REVERSE    0x008
+#define PDC_RMT_STRIKEOUT  0x010
+#define PDC_RMT_BLINK      0x020
+#define PDC_RMT_LEFT       0x040
+#define PDC_RMT_RIGHT      0x080
+#define PDC_RMT_TOP        0x100
+
+#define PDC_RMT_MAX_PAYLOAD  (1 << 24)  /* sanity limit on the receiving end */
+
+#ifdef PDC_RMT_PORT
+extern int PDC_rmt_out_fd, PDC_rmt_in_fd;            /* pdcscrn.c */
+extern int PDC_rmt_lines, PDC_rmt_cols;              /* pdcscrn.c */
+
+int PDC_rmt_send( const int type, const unsigned char *payload,
+                                  const size_t len); /* pdcdisp.c */
+int PDC_rmt_read_input( const int wait_ms);          /* pdckbd.c */
+bool PDC_rmt_have_message( void);                    /* pdckbd.c */
+#endif
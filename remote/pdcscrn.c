@@ -0,0 +1,267 @@
+/* PDCursesMod */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <assert.h>
+#define PDC_RMT_PORT
+#include "curspriv.h"
+#include "pdcremote.h"
+#include "../common/pdccolor.h"
+#include "../common/pdccolor.c"
+
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+int PDC_expand_combined_characters( const cchar_t c, cchar_t *added);
+#endif
+
+void PDC_rmt_free_display( void);         /* pdcdisp.c */
+void PDC_rmt_free_input( void);           /* pdckbd.c */
+
+/* The 'screen' is whatever viewer is at the other end of PDC_rmt_out_fd
+and PDC_rmt_in_fd.  By default,  that's the SCREEN's own output and
+input streams (stdout/stdin,  unless newterm( ) said otherwise),  so a
+viewer can simply run the program with its stdio on a pipe or socket.
+If the PDC_REMOTE environment variable is set,  we connect to it instead:
+either a Unix domain socket path,  or 'host:port' for TCP.  */
+
+int PDC_rmt_out_fd = -1, PDC_rmt_in_fd = -1;
+int PDC_rmt_lines = -1, PDC_rmt_cols = -1;
+static int _socket_fd = -1;            /* if we opened it ourselves */
+
+bool PDC_resize_occurred = FALSE;
+
+void PDC_reset_prog_mode( void)
+{
+}
+
+void PDC_reset_shell_mode( void)
+{
+}
+
+/* We can't resize the viewer,  but we can draw at whatever size the
+program asks for;  the viewer shows what it can of it. */
+
+int PDC_resize_screen(int nlines, int ncols)
+{
+   if( nlines > 1 && ncols > 1)
+      {
+      PDC_rmt_lines = nlines;
+      PDC_rmt_cols = ncols;
+      }
+   return( 0);
+}
+
+void PDC_restore_screen_mode(int i)
+{
+    INTENTIONALLY_UNUSED_PARAMETER( i);
+}
+
+void PDC_save_screen_mode(int i)
+{
+    INTENTIONALLY_UNUSED_PARAMETER( i);
+}
+
+void PDC_scr_close( void)
+{
+   PDC_doupdate( );
+}
+
+void PDC_scr_free( void)
+{
+    PDC_free_palette( );
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+    PDC_expand_combined_characters( 0, NULL);
+#endif
+    PDC_rmt_free_display( );
+    PDC_rmt_free_input( );
+    if( _socket_fd >= 0)
+    {
+        close( _socket_fd);
+        _socket_fd = -1;
+    }
+    PDC_rmt_out_fd = PDC_rmt_in_fd = -1;
+}
+
+static int _connect_to( const char *addr)
+{
+   int fd = -1;
+
+   if( strchr( addr, '/'))
+      {
+      struct sockaddr_un sun;
+
+      if( strlen( addr) >= sizeof( sun.sun_path))
+         return( -1);
+      memset( &sun, 0, sizeof( sun));
+      sun.sun_family = AF_UNIX;
+      strcpy( sun.sun_path, addr);
+      fd = socket( AF_UNIX, SOCK_STREAM, 0);
+      if( fd >= 0 && connect( fd, (struct sockaddr *)&sun, sizeof( sun)))
+         {
+         close( fd);
+         fd = -1;
+         }
+      }
+   else
+      {
+      const char *colon = strrchr( addr, ':');
+      struct addrinfo hints, *res, *rptr;
+      char host[256];
+
+      if( !colon || colon - addr >= (int)sizeof( host))
+         return( -1);
+      memcpy( host, addr, colon - addr);
+      host[colon - addr] = '\0';
+      memset( &hints, 0, sizeof( hints));
+      hints.ai_family = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+      if( getaddrinfo( (*host ? host : NULL), colon + 1, &hints, &res))
+         return( -1);
+      for( rptr = res; rptr && fd < 0; rptr = rptr->ai_next)
+         {
+         fd = socket( rptr->ai_family, rptr->ai_socktype, rptr->ai_protocol);
+         if( fd >= 0 && connect( fd, rptr->ai_addr, rptr->ai_addrlen))
+            {
+            close( fd);
+            fd = -1;
+            }
+         }
+      freeaddrinfo( res);
+      }
+   return( fd);
+}
+
+#define MAX_LINES 1000
+#define MAX_COLUMNS 1000
+
+/* How long we wait for the viewer to tell us its size */
+#define SIZE_TIMEOUT_MS 2000
+
+int PDC_scr_open(void)
+{
+    const char *remote = getenv( "PDC_REMOTE");
+    unsigned char hello[1];
+    long t0;
+
+    PDC_LOG(("PDC_scr_open called\n"));
+    assert( SP);
+    if( !SP)
+        return ERR;
+    if( remote)
+    {
+        _socket_fd = _connect_to( remote);
+        if( _socket_fd < 0)
+        {
+            fprintf( stderr, "Couldn't connect to '%s'\n", remote);
+            return ERR;
+        }
+        PDC_rmt_out_fd = PDC_rmt_in_fd = _socket_fd;
+    }
+    else
+    {
+        fflush( SP->output_fd);
+        PDC_rmt_out_fd = fileno( SP->output_fd);
+        PDC_rmt_in_fd = fileno( SP->input_fd);
+    }
+    hello[0] = PDC_RMT_VERSION;
+    if( PDC_rmt_send( PDC_RMT_HELLO, hello, 1))
+        return ERR;
+
+            /* the viewer's first message is its size */
+    t0 = PDC_millisecs( );
+    while( !PDC_rmt_have_message( ))
+    {
+        const long remaining = SIZE_TIMEOUT_MS - (PDC_millisecs( ) - t0);
+
+        if( remaining <= 0)
+            break;
+        PDC_rmt_read_input( (int)remaining);
+    }
+    if( PDC_rmt_have_message( ))
+        PDC_get_key( );
+    if( PDC_rmt_lines < 2 || PDC_rmt_cols < 2)
+    {
+        const char *env = getenv( "PDC_LINES");
+
+        PDC_rmt_lines = (env ? atoi( env) : 24);
+        env = getenv( "PDC_COLS");
+        PDC_rmt_cols = (env ? atoi( env) : 80);
+    }
+
+    COLORS = 256 + (256 * 256 * 256);
+    if( PDC_init_palette( ))
+        return ERR;
+
+    SP->mouse_wait = PDC_CLICK_PERIOD;
+    SP->visibility = 0;                /* no cursor,  by default */
+    SP->curscol = SP->cursrow = 0;
+    SP->audible = TRUE;
+    SP->mono = FALSE;
+    SP->orig_attr = TRUE;
+    SP->orig_fore = SP->orig_back = -1;
+    SP->termattrs = A_BOLD | A_UNDERLINE | A_ITALIC | A_REVERSE
+                  | A_STRIKEOUT | A_LEFT | A_RIGHT | A_TOP | A_DIRECT_COLOR;
+    SP->resized = FALSE;
+
+    SP->lines = PDC_get_rows();
+    SP->cols = PDC_get_columns();
+
+    if (SP->lines < 2 || SP->lines > MAX_LINES
+       || SP->cols < 2 || SP->cols > MAX_COLUMNS)
+    {
+        fprintf(stderr, "LINES value must be >= 2 and <= %d: got %d\n",
+                MAX_LINES, SP->lines);
+        fprintf(stderr, "COLS value must be >= 2 and <= %d: got %d\n",
+                MAX_COLUMNS, SP->cols);
+
+        return ERR;
+    }
+
+    PDC_LOG(("PDC_scr_open exit\n"));
+    return( 0);
+}
+
+void PDC_set_resize_limits( const int new_min_lines,
+                            const int new_max_lines,
+                            const int new_min_cols,
+                            const int new_max_cols)
+{
+   INTENTIONALLY_UNUSED_PARAMETER( new_min_lines);
+   INTENTIONALLY_UNUSED_PARAMETER( new_max_lines);
+   INTENTIONALLY_UNUSED_PARAMETER( new_min_cols);
+   INTENTIONALLY_UNUSED_PARAMETER( new_max_cols);
+   return;
+}
+
+
+bool PDC_can_change_color(void)
+{
+    return TRUE;
+}
+
+int PDC_color_content( int color, int *red, int *green, int *blue)
+{
+    const PACKED_RGB col = PDC_get_palette_entry( color);
+
+    *red = DIVROUND( Get_RValue(col) * 1000, 255);
+    *green = DIVROUND( Get_GValue(col) * 1000, 255);
+    *blue = DIVROUND( Get_BValue(col) * 1000, 255);
+
+    return OK;
+}
+
+int PDC_init_color( int color, int red, int green, int blue)
+{
+    const PACKED_RGB new_rgb = PACK_RGB(DIVROUND(red * 255, 1000),
+                                 DIVROUND(green * 255, 1000),
+                                 DIVROUND(blue * 255, 1000));
+
+    if( !PDC_set_palette_entry( color, new_rgb))
+        curscr->_clear = TRUE;
+    return OK;
+}
@@ -0,0 +1,25 @@
+/* PDCursesMod */
+
+#include <unistd.h>
+
+#define PDC_RMT_PORT
+#include "curspriv.h"
+#include "pdcremote.h"
+
+void PDC_beep(void)
+{
+    PDC_rmt_send( PDC_RMT_BEEP, NULL, 0);
+}
+
+void PDC_napms(int ms)
+{
+    usleep(1000 * ms);
+}
+
+
+const char *PDC_sysname(void)
+{
+   return( "Remote");
+}
+
+enum PDC_port PDC_port_val = PDC_PORT_REMOTE;
@@ -0,0 +1,704 @@
+/* PDCursesMod */
+
+/* Reference viewer for the remote port.  It decodes the frames sent by a
+program built with the remote port,  draws them with (some other port of)
+curses,  and sends back keystrokes,  mouse events and size changes.  It
+has its own decoder,  written only from pdcremote.h and README.md,  so it
+doubles as a check on the protocol description.  Run it as
+
+pdcview program [args...]    (runs 'program' with stdin/stdout on a socket)
+pdcview -l /path/to/socket   (waits for one program to connect to a Unix
+pdcview -l [host]:port        domain socket or TCP port;  start the program
+                              with PDC_REMOTE set to the same address)
+
+The Makefile builds it against the VT port.  Everything but the remote
+program's own exit is passed along,  so (for example) Ctrl-C goes to the
+program,  not to pdcview.  */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include <curses.h>
+#include "pdcremote.h"
+
+#define MAX_CELL_TEXT  24      /* UTF-8 bytes;  long clusters are cut short */
+
+typedef struct
+{
+   char text[MAX_CELL_TEXT];   /* empty for right half of a fullwidth char */
+   unsigned long flags, fg, bg;
+} CELL;
+
+typedef struct
+{
+   unsigned long flags, fg, bg;
+} RMT_ATTR;
+
+static int sock = -1;
+static CELL *cells = NULL;
+static int n_lines, n_cols;
+static RMT_ATTR attrs[PDC_RMT_N_ATTRS];
+static int draw_row, draw_col;
+static int cursor_row, cursor_col, cursor_vis = -1, shown_vis = -1;
+
+static int write_all( const unsigned char *buff, size_t n_bytes)
+{
+   while( n_bytes)
+      {
+      const ssize_t written = write( sock, buff, n_bytes);
+
+      if( written < 0)
+         {
+         if( errno == EINTR)
+            continue;
+         return( -1);
+         }
+      buff += written;
+      n_bytes -= (size_t)written;
+      }
+   return( 0);
+}
+
+static size_t put_varint( unsigned char *buff, unsigned long ival)
+{
+   size_t rval = 0;
+
+   while( ival >= 0x80)
+      {
+      buff[rval++] = (unsigned char)( (ival & 0x7f) | 0x80);
+      ival >>= 7;
+      }
+   buff[rval++] = (unsigned char)ival;
+   return( rval);
+}
+
+/* Sends a message whose payload is just a list of varints. */
+
+static void send_message( const int type, const unsigned long *args,
+                          const int n_args)
+{
+   unsigned char buff[200];
+   size_t len = 2;
+   int i;
+
+   buff[0] = (unsigned char)type;
+   for( i = 0; i < n_args; i++)
+      len += put_varint( buff + len, args[i]);
+   buff[1] = (unsigned char)( len - 2);     /* always < 128 */
+   write_all( buff, len);
+}
+
+static void send_size( void)
+{
+   unsigned long args[2];
+
+   args[0] = (unsigned long)LINES;
+   args[1] = (unsigned long)COLS;
+   send_message( PDC_RMT_SIZE, args, 2);
+}
+
+static int get_varint( const unsigned char **bytes, const unsigned char *end,
+                       unsigned long *ival)
+{
+   int shift = 0;
+
+   *ival = 0;
+   while( *bytes < end && shift < 63)
+      {
+      const int byte = *(*bytes)++;
+
+      *ival |= (unsigned long)( byte & 0x7f) << shift;
+      if( !(byte & 0x80))
+         return( 0);
+      shift += 7;
+      }
+   return( -1);
+}
+
+static int get_varints( const unsigned char **bytes, const unsigned char *end,
+                       unsigned long *ivals, int n)
+{
+   while( n--)
+      if( get_varint( bytes, end, ivals++))
+         return( -1);
+   return( 0);
+}
+
+static int utf8_len( const int lead_byte)
+{
+   if( lead_byte < 0xc0)
+      return( 1);
+   else if( lead_byte < 0xe0)
+      return( 2);
+   else if( lead_byte < 0xf0)
+      return( 3);
+   else
+      return( 4);
+}
+
+static int decode_utf8( const char **text)
+{
+   const unsigned char *tptr = (const unsigned char *)*text;
+   const int len = utf8_len( *tptr);
+   int rval = *tptr++, i;
+
+   if( len > 1)
+      rval &= (0x7f >> len);
+   for( i = 1; i < len && (*tptr & 0xc0) == 0x80; i++)
+      rval = (rval << 6) | (*tptr++ & 0x3f);
+   *text = (const char *)tptr;
+   return( rval);
+}
+
+/* Maps an RGB color from the protocol (0 = default) to the nearest color
+this curses has.  With a direct-color port,  that's exact;  otherwise,  we
+find the nearest entry in the xterm 256-color cube/grays,  or failing
+that,  the basic eight (or sixteen) colors. */
+
+static int curses_color( const unsigned long fg_or_bg)
+{
+   static const int cube_levels[6] = { 0, 95, 135, 175, 215, 255 };
+   int r, g, b, i, best[3];
+
+   if( !fg_or_bg)
+      return( -1);
+   r = (int)( (fg_or_bg - 1) & 0xff);
+   g = (int)( ((fg_or_bg - 1) >> 8) & 0xff);
+   b = (int)( ((fg_or_bg - 1) >> 16) & 0xff);
+   if( COLORS >= 256 + 0x1000000)
+      return( 256 + (int)( fg_or_bg - 1));
+   if( COLORS >= 256)
+      {
+      const int rgb[3] = { r, g, b };
+      const int gray = (r + g + b) / 3;
+      const int gray_idx = (gray < 8 ? 0 : (gray > 238 ? 23 : (gray - 8) / 10));
+      const int gray_val = 8 + gray_idx * 10;
+      long cube_dist = 0, gray_dist = 0;
+
+      for( i = 0; i < 3; i++)
+         {
+         int j = 0;
+
+         while( j < 5 && rgb[i] > (cube_levels[j] + cube_levels[j + 1]) / 2)
+            j++;
+         best[i] = j;
+         cube_dist += (long)( rgb[i] - cube_levels[j]) * (rgb[i] - cube_levels[j]);
+         gray_dist += (long)( rgb[i] - gray_val) * (rgb[i] - gray_val);
+         }
+      if( gray_dist < cube_dist)
+         return( 232 + gray_idx);
+      return( 16 + best[0] * 36 + best[1] * 6 + best[2]);
+      }
+   i = (r >= 128 ? COLOR_RED : 0) | (g >= 128 ? COLOR_GREEN : 0)
+                                  | (b >= 128 ? COLOR_BLUE : 0);
+   if( COLORS >= 16 && (r >= 192 || g >= 192 || b >= 192))
+      i += 8;
+   return( i);
+}
+
+static attr_t curses_attr( const unsigned long flags)
+{
+   attr_t rval = 0;
+
+   if( flags & PDC_RMT_BOLD)
+      rval |= A_BOLD;
+   if( flags & PDC_RMT_UNDERLINE)
+      rval |= A_UNDERLINE;
+   if( flags & PDC_RMT_ITALIC)
+      rval |= A_ITALIC;
+   if( flags & PDC_RMT_REVERSE)
+      rval |= A_REVERSE;
+   if( flags & PDC_RMT_STRIKEOUT)
+      rval |= A_STRIKEOUT;
+   if( flags & PDC_RMT_BLINK)
+      rval |= A_BLINK;
+   if( flags & PDC_RMT_LEFT)
+      rval |= A_LEFT;
+   if( flags & PDC_RMT_RIGHT)
+      rval |= A_RIGHT;
+   if( flags & PDC_RMT_TOP)
+      rval |= A_TOP;
+   return( rval);
+}
+
+#ifndef PDC_WIDE
+/* Without wide characters,  we can at least show line-drawing
+characters as their ACS equivalents. */
+
+static chtype narrow_char( const int code_point)
+{
+   static const int box_chars[] = { 0x2500, 0x2502, 0x250c, 0x2510,
+                  0x2514, 0x2518, 0x251c, 0x2524, 0x252c, 0x2534, 0x253c,
+                  0x2592, 0x2588, 0x2591, 0x2022 };
+   const chtype acs_chars[] = { ACS_HLINE, ACS_VLINE, ACS_ULCORNER,
+                  ACS_URCORNER, ACS_LLCORNER, ACS_LRCORNER, ACS_LTEE,
+                  ACS_RTEE, ACS_TTEE, ACS_BTEE, ACS_PLUS, ACS_CKBOARD,
+                  ACS_BLOCK, ACS_BOARD, ACS_BULLET };
+   size_t i;
+
+   if( code_point < 256)
+      return( (chtype)code_point);
+   for( i = 0; i < sizeof( box_chars) / sizeof( box_chars[0]); i++)
+      if( box_chars[i] == code_point)
+         return( acs_chars[i]);
+   return( (chtype)'?');
+}
+#endif
+
+static void draw_cell( const int row, const int col)
+{
+   const CELL *cell = cells + row * n_cols + col;
+   const char *tptr = cell->text;
+   int pair;
+
+   if( row >= LINES || col >= COLS || !*tptr)
+      return;
+   pair = alloc_pair( curses_color( cell->fg), curses_color( cell->bg));
+   if( pair < 0)
+      pair = 0;
+   attr_set( curses_attr( cell->flags), 0, &pair);
+#ifdef PDC_WIDE
+   {
+      wchar_t wtext[MAX_CELL_TEXT + 1];
+      int n = 0;
+
+      while( *tptr)
+         wtext[n++] = (wchar_t)decode_utf8( &tptr);
+      mvaddnwstr( row, col, wtext, n);
+   }
+#else
+   mvaddch( row, col, narrow_char( decode_utf8( &tptr)));
+#endif
+}
+
+static void redraw_all( void)
+{
+   int i, j;
+
+   attr_set( A_NORMAL, 0, NULL);
+   erase( );
+   for( i = 0; i < n_lines; i++)
+      for( j = 0; j < n_cols; j++)
+         draw_cell( i, j);
+}
+
+static void set_size( const int new_lines, const int new_cols)
+{
+   const size_t n_cells = (size_t)new_lines * (size_t)new_cols;
+   size_t i;
+
+   free( cells);
+   cells = (CELL *)calloc( n_cells, sizeof( CELL));
+   if( !cells)
+      {
+      n_lines = n_cols = 0;
+      return;
+      }
+   for( i = 0; i < n_cells; i++)
+      cells[i].text[0] = ' ';
+   n_lines = new_lines;
+   n_cols = new_cols;
+   redraw_all( );
+}
+
+static void put_cell( const char *text, size_t n_bytes, const int attr_idx)
+{
+   if( draw_row < n_lines && draw_col < n_cols)
+      {
+      CELL *cell = cells + draw_row * n_cols + draw_col;
+
+      while( n_bytes >= MAX_CELL_TEXT)      /* cut at a character boundary */
+         {
+         n_bytes--;
+         while( n_bytes && (text[n_bytes] & 0xc0) == 0x80)
+            n_bytes--;
+         }
+      memcpy( cell->text, text, n_bytes);
+      cell->text[n_bytes] = '\0';
+      cell->flags = attrs[attr_idx].flags;
+      cell->fg = attrs[attr_idx].fg;
+      cell->bg = attrs[attr_idx].bg;
+      draw_cell( draw_row, draw_col);
+      }
+   draw_col++;
+}
+
+static int apply_text_op( const unsigned char **tptr, const unsigned char *end)
+{
+   unsigned long args[2], n_cells, n_bytes;
+   int how, attr_idx;
+
+   if( get_varints( tptr, end, args, 2) || args[1] >= PDC_RMT_N_ATTRS)
+      return( -1);
+   n_cells = args[0] >> 2;
+   how = (int)( args[0] & 3);
+   attr_idx = (int)args[1];
+   if( how == PDC_RMT_TEXT_CLUSTER)
+      {
+      if( get_varint( tptr, end, &n_bytes) || n_bytes > (size_t)( end - *tptr))
+         return( -1);
+      put_cell( (const char *)*tptr, (size_t)n_bytes, attr_idx);
+      *tptr += n_bytes;
+      return( 0);
+      }
+   while( n_cells && *tptr < end)
+      {
+      const size_t len = (size_t)utf8_len( **tptr);
+
+      if( len > (size_t)( end - *tptr))
+         return( -1);
+      if( how == PDC_RMT_TEXT_REPEAT)
+         {
+         while( n_cells--)
+            put_cell( (const char *)*tptr, len, attr_idx);
+         n_cells = 0;
+         }
+      else
+         {
+         put_cell( (const char *)*tptr, len, attr_idx);
+         n_cells--;
+         }
+      *tptr += len;
+      }
+   return( n_cells ? -1 : 0);
+}
+
+static void apply_frame( const unsigned char *tptr, const unsigned char *end)
+{
+   while( tptr < end)
+      {
+      const int op = *tptr++;
+      unsigned long args[4];
+
+      switch( op)
+         {
+         case PDC_RMT_OP_SIZE:
+            if( get_varints( &tptr, end, args, 2))
+               return;
+            set_size( (int)args[0], (int)args[1]);
+            break;
+         case PDC_RMT_OP_ATTR:
+            if( get_varints( &tptr, end, args, 4) || args[0] >= PDC_RMT_N_ATTRS)
+               return;
+            attrs[args[0]].flags = args[1];
+            attrs[args[0]].fg = args[2];
+            attrs[args[0]].bg = args[3];
+            break;
+         case PDC_RMT_OP_MOVE:
+            if( get_varints( &tptr, end, args, 2))
+               return;
+            draw_row = (int)args[0];
+            draw_col = (int)args[1];
+            break;
+         case PDC_RMT_OP_TEXT:
+            if( apply_text_op( &tptr, end))
+               return;
+            break;
+         case PDC_RMT_OP_COPYROW:
+            if( get_varints( &tptr, end, args, 2))
+               return;
+            if( args[0] < (unsigned long)n_lines && args[1] < (unsigned long)n_lines)
+               {
+               int i;
+
+               memcpy( cells + args[1] * n_cols, cells + args[0] * n_cols,
+                                 n_cols * sizeof( CELL));
+               move( (int)args[1], 0);
+               attr_set( A_NORMAL, 0, NULL);
+               clrtoeol( );
+               for( i = 0; i < n_cols; i++)
+                  draw_cell( (int)args[1], i);
+               }
+            break;
+         case PDC_RMT_OP_CURSOR:
+            if( get_varints( &tptr, end, args, 3))
+               return;
+            cursor_row = (int)args[0];
+            cursor_col = (int)args[1];
+            cursor_vis = (int)args[2];
+            break;
+         default:         /* can't know how long it is;  skip the rest */
+            return;
+         }
+      }
+}
+
+static void show_cursor( void)
+{
+   if( cursor_vis >= 0 && cursor_vis != shown_vis)
+      {
+      curs_set( cursor_vis);
+      shown_vis = cursor_vis;
+      }
+   if( cursor_vis > 0 && cursor_row < LINES && cursor_col < COLS)
+      move( cursor_row, cursor_col);
+}
+
+/* Handles all complete messages in the buffer;  returns the number of
+bytes used,  or (size_t)-1 if what's in it makes no sense. */
+
+static size_t handle_messages( const unsigned char *buff, const size_t len)
+{
+   size_t used = 0;
+
+   while( used < len)
+      {
+      const unsigned char *tptr = buff + used + 1;
+      unsigned long msg_len;
+
+      if( get_varint( &tptr, buff + len, &msg_len))
+         break;
+      if( msg_len > PDC_RMT_MAX_PAYLOAD)
+         return( (size_t)-1);          /* not talking to a remote program */
+      if( msg_len > (unsigned long)( buff + len - tptr))
+         break;
+      switch( buff[used])
+         {
+         case PDC_RMT_FRAME:
+            apply_frame( tptr, tptr + msg_len);
+            break;
+         case PDC_RMT_BEEP:
+            beep( );
+            break;
+         case PDC_RMT_TITLE:
+            {
+               char title[256];
+               const size_t n = (msg_len < sizeof( title) ? msg_len : sizeof( title) - 1);
+
+               memcpy( title, tptr, n);
+               title[n] = '\0';
+               PDC_set_title( title);
+            }
+            break;
+         default:          /* PDC_RMT_HELLO,  and anything newer */
+            break;
+         }
+      used = (size_t)( tptr - buff) + msg_len;
+      }
+   return( used);
+}
+
+static void send_input( void)
+{
+   int key;
+   unsigned long args[8];
+
+   while( (key = getch( )) != ERR)
+      if( key == KEY_RESIZE)
+         {
+         resize_term( 0, 0);
+         redraw_all( );
+         show_cursor( );
+         refresh( );
+         send_size( );
+         }
+      else if( key == KEY_MOUSE)
+         {
+         int i;
+
+         request_mouse_pos( );
+         args[0] = (unsigned long)Mouse_status.x;
+         args[1] = (unsigned long)Mouse_status.y;
+         args[2] = (unsigned long)Mouse_status.changes;
+         for( i = 0; i < 5; i++)
+            args[i + 3] = (unsigned long)(unsigned short)Mouse_status.button[i];
+         send_message( PDC_RMT_MOUSE, args, 8);
+         }
+      else
+         {
+         const bool is_func = (key >= KEY_OFFSET && key <= KEY_MAX);
+
+         args[0] = (is_func ? PDC_RMT_KEY_FUNC : PDC_RMT_KEY_CHAR);
+         args[1] = (unsigned long)( is_func ? key - KEY_OFFSET : key);
+         args[2] = PDC_get_key_modifiers( );
+         send_message( PDC_RMT_KEY, args, 3);
+         }
+}
+
+static int listen_on( const char *addr)
+{
+   int fd = -1, rval;
+
+   if( strchr( addr, '/'))
+      {
+      struct sockaddr_un sun;
+
+      if( strlen( addr) >= sizeof( sun.sun_path))
+         return( -1);
+      memset( &sun, 0, sizeof( sun));
+      sun.sun_family = AF_UNIX;
+      strcpy( sun.sun_path, addr);
+      unlink( addr);
+      fd = socket( AF_UNIX, SOCK_STREAM, 0);
+      if( fd >= 0 && (bind( fd, (struct sockaddr *)&sun, sizeof( sun))
+                             || listen( fd, 1)))
+         {
+         close( fd);
+         fd = -1;
+         }
+      }
+   else
+      {
+      const char *colon = strrchr( addr, ':');
+      struct addrinfo hints, *res, *rptr;
+      char host[256];
+      const int one = 1;
+
+      if( !colon || colon - addr >= (int)sizeof( host))
+         return( -1);
+      memcpy( host, addr, colon - addr);
+      host[colon - addr] = '\0';
+      memset( &hints, 0, sizeof( hints));
+      hints.ai_family = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+      hints.ai_flags = AI_PASSIVE;
+      if( getaddrinfo( (*host ? host : NULL), colon + 1, &hints, &res))
+         return( -1);
+      for( rptr = res; rptr && fd < 0; rptr = rptr->ai_next)
+         {
+         fd = socket( rptr->ai_family, rptr->ai_socktype, rptr->ai_protocol);
+         if( fd >= 0)
+            setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof( one));
+         if( fd >= 0 && (bind( fd, rptr->ai_addr, rptr->ai_addrlen)
+                             || listen( fd, 1)))
+            {
+            close( fd);
+            fd = -1;
+            }
+         }
+      freeaddrinfo( res);
+      }
+   if( fd < 0)
+      return( -1);
+   fprintf( stderr, "Waiting for a connection on %s\n", addr);
+   rval = accept( fd, NULL, NULL);
+   close( fd);
+   return( rval);
+}
+
+static pid_t run_program( char **argv)
+{
+   int fds[2];
+   pid_t pid;
+
+   if( socketpair( AF_UNIX, SOCK_STREAM, 0, fds))
+      return( -1);
+   pid = fork( );
+   if( !pid)
+      {
+      close( fds[0]);
+      dup2( fds[1], 0);
+      dup2( fds[1], 1);
+      close( fds[1]);
+      execvp( argv[0], argv);
+      fprintf( stderr, "Couldn't run '%s'\n", argv[0]);
+      exit( 127);
+      }
+   close( fds[1]);
+   sock = fds[0];
+   return( pid);
+}
+
+int main( const int argc, char **argv)
+{
+   pid_t pid = -1;
+   unsigned char *buff = NULL;
+   size_t buff_len = 0, buff_alloced = 0;
+   int rval = 0;
+
+   if( argc > 2 && !strcmp( argv[1], "-l"))
+      sock = listen_on( argv[2]);
+   else if( argc > 1 && argv[1][0] != '-')
+      pid = run_program( argv + 1);
+   else
+      {
+      fprintf( stderr, "Usage:  pdcview program [args...]\n"
+                       "        pdcview -l (socket path | [host]:port)\n");
+      return( -1);
+      }
+   if( sock < 0)
+      {
+      fprintf( stderr, "Couldn't connect\n");
+      return( -2);
+      }
+
+   initscr( );
+   raw( );
+   noecho( );
+   keypad( stdscr, TRUE);
+   nodelay( stdscr, TRUE);
+   start_color( );
+   use_default_colors( );
+   mouse_set( ALL_MOUSE_EVENTS | REPORT_MOUSE_POSITION);
+   curs_set( 0);
+   shown_vis = 0;
+   send_size( );
+
+   for( ;;)
+      {
+      const int input_fd = PDC_get_input_fd( );
+      struct timeval timeout;
+      fd_set rdset;
+      ssize_t n_read;
+
+      FD_ZERO( &rdset);
+      FD_SET( sock, &rdset);
+      if( input_fd >= 0)
+         FD_SET( input_fd, &rdset);
+      timeout.tv_sec = 0;        /* without an input fd,  poll the keyboard */
+      timeout.tv_usec = (input_fd >= 0 ? 100000 : 20000);
+      select( (sock > input_fd ? sock : input_fd) + 1, &rdset, NULL, NULL,
+                                 &timeout);
+      if( FD_ISSET( sock, &rdset))
+         {
+         size_t used;
+
+         if( buff_alloced - buff_len < 4096)
+            {
+            const size_t new_size = (buff_alloced ? buff_alloced * 2 : 65536);
+            unsigned char *new_buff = (unsigned char *)realloc( buff, new_size);
+
+            if( !new_buff)
+               break;
+            buff = new_buff;
+            buff_alloced = new_size;
+            }
+         n_read = read( sock, buff + buff_len, buff_alloced - buff_len);
+         if( n_read <= 0 && !(n_read < 0 && errno == EINTR))
+            break;            /* the program has exited */
+         if( n_read > 0)
+            buff_len += (size_t)n_read;
+         used = handle_messages( buff, buff_len);
+         if( used == (size_t)-1)
+            {
+            rval = -3;
+            break;
+            }
+         buff_len -= used;
+         memmove( buff, buff + used, buff_len);
+         show_cursor( );
+         refresh( );
+         }
+      send_input( );
+      }
+   endwin( );
+   free( buff);
+   free( cells);
+   close( sock);
+   if( pid > 0)
+      {
+      int status;
+
+      if( waitpid( pid, &status, 0) == pid && WIFEXITED( status))
+         rval = WEXITSTATUS( status);
+      }
+   return( rval);
+}
@@ -14,62 +14,232 @@
 # include "../common/acs_defs.h"
 # include "../common/pdccolor.h"
 
-#define MAXRECT 200     /* maximum number of rects to queue up before
-                           an update is forced; the number was chosen
-                           arbitrarily */
-
-static SDL_Rect uprect[MAXRECT];       /* table of rects to update */
 static chtype oldch = (chtype)(-1);    /* current attribute */
-static int rectcount = 0;              /* index into uprect */
 static int foregr = -2, backgr = -2; /* current foreground, background */
 static bool blinked_off = FALSE;
-/* do the real updates on a delay */
 
-void PDC_update_rects(void)
+/* Areas to be presented are kept as up to MAX_ROW_SPANS spans of pixel
+   columns per row of text. A new span absorbs any it overlaps or
+   touches; if a row runs out of spans, the new one is merged into the
+   nearest. On a delay, PDC_update_rects() joins identical spans in
+   consecutive rows into single rectangles and presents those, unless
+   they cover so much of the window that a full update is as cheap. So
+   a clock in one corner and a status line in another cost two small
+   rectangles, however many times they were drawn. */
+
+#define MAX_ROW_SPANS 4         /* column spans kept per row of text */
+#define FULL_UPDATE_PERCENT 60  /* present the whole window when at
+                                   least this much of it has changed */
+
+typedef struct
 {
-    int i;
+    int x1, x2;                 /* pixel columns x1 <= x < x2 */
+} ROW_SPAN;
+
+static ROW_SPAN *row_spans = NULL;     /* MAX_ROW_SPANS per row */
+static int *n_row_spans = NULL;        /* spans in use in each row */
+static SDL_Rect *uprect = NULL;        /* rects to present */
+static int span_rows = 0;              /* rows allocated */
+static int dirty_y1 = 0, dirty_y2 = -1;  /* rows with spans in use */
+static bool full_update = FALSE;       /* present the whole window */
+
+void PDC_free_update_region(void)
+{
+    free(row_spans);
+    free(n_row_spans);
+    free(uprect);
+    row_spans = NULL;
+    n_row_spans = NULL;
+    uprect = NULL;
+    span_rows = 0;
+    dirty_y1 = 0;
+    dirty_y2 = -1;
+    full_update = FALSE;
+}
 
-    if (rectcount)
+static void _clear_update_region(void)
+{
+    int y;
+
+    for (y = dirty_y1; y <= dirty_y2; y++)
+        n_row_spans[y] = 0;
+    dirty_y1 = 0;
+    dirty_y2 = -1;
+    full_update = FALSE;
+}
+
+static bool _alloc_row_spans(const int n_rows)
+{
+    if (n_rows > span_rows)
     {
-        /* if the maximum number of rects has been reached, we're
-           probably better off doing a full screen update */
+        const size_t n_spans = (size_t)n_rows * MAX_ROW_SPANS;
+        ROW_SPAN *new_spans = (ROW_SPAN *)realloc(row_spans,
+                                    n_spans * sizeof(ROW_SPAN));
+        int *new_counts;
+        SDL_Rect *new_rects;
+
+        if (!new_spans)
+            return FALSE;
+        row_spans = new_spans;
+        new_counts = (int *)realloc(n_row_spans, n_rows * sizeof(int));
+        if (!new_counts)
+            return FALSE;
+        n_row_spans = new_counts;
+        new_rects = (SDL_Rect *)realloc(uprect, n_spans * sizeof(SDL_Rect));
+        if (!new_rects)
+            return FALSE;
+        uprect = new_rects;
+        memset(n_row_spans + span_rows, 0,
+               (n_rows - span_rows) * sizeof(int));
+        span_rows = n_rows;
+    }
+    return TRUE;
+}
 
-        if (rectcount == MAXRECT)
-            SDL_UpdateWindowSurface(pdc_window);
+static void _add_span(const int y, int x1, int x2)
+{
+    ROW_SPAN *span = row_spans + y * MAX_ROW_SPANS;
+    int i = 0, n = n_row_spans[y];
+
+    while (i < n)
+        if (span[i].x1 <= x2 && x1 <= span[i].x2)
+        {
+            x1 = min(x1, span[i].x1);
+            x2 = max(x2, span[i].x2);
+            span[i] = span[--n];
+        }
         else
+            i++;
+
+    if (n == MAX_ROW_SPANS)
+    {
+        int best = 0, best_gap = 0;
+
+        for (i = 0; i < n; i++)
         {
-            int w = pdc_screen->w;
-            int h = pdc_screen->h;
+            const int gap = (span[i].x1 > x2 ? span[i].x1 - x2 :
+                                               x1 - span[i].x2);
 
-            for (i = 0; i < rectcount; i++)
+            if (!i || gap < best_gap)
             {
-                if (uprect[i].x > w ||
-                    uprect[i].y > h ||
-                    !uprect[i].w || !uprect[i].h)
-                {
-                    if (i + 1 < rectcount)
-                    {
-                        memmove(uprect + i, uprect + i + 1,
-                                (rectcount - i + 1) * sizeof(*uprect));
-                        --i;
-                    }
-                    rectcount--;
-                    continue;
-                }
-
-                if (uprect[i].x + uprect[i].w > w)
-                    uprect[i].w = min(w, w - uprect[i].x);
-
-                if (uprect[i].y + uprect[i].h > h)
-                    uprect[i].h = min(h, h - uprect[i].y);
+                best = i;
+                best_gap = gap;
             }
+        }
+        x1 = min(x1, span[best].x1);
+        x2 = max(x2, span[best].x2);
+        span[best] = span[--n];
+        n_row_spans[y] = n;
+        _add_span(y, x1, x2);   /* the merged span may now touch others */
+        return;
+    }
+
+    span[n].x1 = x1;
+    span[n].x2 = x2;
+    n_row_spans[y] = n + 1;
+}
+
+static void _add_update_rect(const SDL_Rect *rect)
+{
+    const int n_rows = (pdc_screen->h - pdc_yoffset) / pdc_fheight + 1;
+    int y, y1, y2;
+
+    if (full_update || rect->w <= 0 || rect->h <= 0)
+        return;
+
+    if (!_alloc_row_spans(n_rows))
+    {
+        full_update = TRUE;
+        return;
+    }
+
+    y1 = max(rect->y - pdc_yoffset, 0) / pdc_fheight;
+    y2 = (rect->y + rect->h - 1 - pdc_yoffset) / pdc_fheight;
+    if (y2 >= n_rows)
+        y2 = n_rows - 1;
+    if (y2 < y1)
+        return;
 
-            if (rectcount > 0)
-                SDL_UpdateWindowSurfaceRects(pdc_window, uprect, rectcount);
+    for (y = y1; y <= y2; y++)
+        _add_span(y, rect->x, rect->x + rect->w);
+
+    if (dirty_y1 > dirty_y2)
+    {
+        dirty_y1 = y1;
+        dirty_y2 = y2;
+    }
+    else
+    {
+        dirty_y1 = min(dirty_y1, y1);
+        dirty_y2 = max(dirty_y2, y2);
+    }
+}
+
+/* do the real updates on a delay */
+
+void PDC_update_rects(void)
+{
+    const int w = pdc_screen->w;
+    const int h = pdc_screen->h;
+    int open[MAX_ROW_SPANS], n_open = 0, n_rects = 0;
+    long area = 0;
+    int y, i, j;
+
+    if (dirty_y1 > dirty_y2 && !full_update)
+        return;
+
+    for (y = dirty_y1; y <= dirty_y2 && !full_update; y++)
+    {
+        const ROW_SPAN *span = row_spans + y * MAX_ROW_SPANS;
+        const int top = y * pdc_fheight + pdc_yoffset;
+        const int bottom = min(top + pdc_fheight, h);
+        int new_open[MAX_ROW_SPANS], n_new_open = 0;
+
+        if (top >= h)
+            break;
+
+        for (i = 0; i < n_row_spans[y]; i++)
+        {
+            const int x1 = max(span[i].x1, 0);
+            const int x2 = min(span[i].x2, w);
+
+            if (x1 >= x2)
+                continue;
+
+            area += (long)(x2 - x1) * (bottom - top);
+
+            /* extend a rectangle from the row above, if one matches */
+
+            for (j = 0; j < n_open; j++)
+                if (uprect[open[j]].x == x1 && uprect[open[j]].w == x2 - x1)
+                    break;
+
+            if (j < n_open)
+            {
+                uprect[open[j]].h = bottom - uprect[open[j]].y;
+                new_open[n_new_open++] = open[j];
+                open[j] = open[--n_open];
+            }
+            else
+            {
+                uprect[n_rects].x = x1;
+                uprect[n_rects].y = top;
+                uprect[n_rects].w = x2 - x1;
+                uprect[n_rects].h = bottom - top;
+                new_open[n_new_open++] = n_rects++;
+            }
         }
 
-        rectcount = 0;
+        memcpy(open, new_open, n_new_open * sizeof(int));
+        n_open = n_new_open;
     }
+
+    if (full_update || area * 100 >= (long)w * h * FULL_UPDATE_PERCENT)
+        SDL_UpdateWindowSurface(pdc_window);
+    else if (n_rects)
+        SDL_UpdateWindowSurfaceRects(pdc_window, uprect, n_rects);
+
+    _clear_update_region();
 }
 
 static SDL_Color *get_pdc_color( const int color_idx)
@@ -170,6 +340,106 @@ static void _set_attr(chtype ch)
 #define Sn_CHARS      0x10
 #define SCAN_LINE( n)      (Sn_CHARS | ((n - 1) << 8))
 
+/* Draw one of the shapes below into a cell of 'surf'.  A mask of zero
+   means a solid block. */
+
+static void _draw_acs_shape(SDL_Surface *surf, const int mask,
+                            const SDL_Rect dest, const Uint32 col)
+{
+    const int hmid = (pdc_fheight - pdc_fthick) >> 1;
+    const int wmid = (pdc_fwidth - pdc_fthick) >> 1;
+    SDL_Rect temp = dest;
+
+    if( !mask)
+        SDL_FillRect(surf, &temp, col);
+    if( mask & HORIZ)
+    {
+        temp.h = pdc_fthick;
+        if( mask & Sn_CHARS)    /* extract scan line for ACS_Sn characters */
+            temp.y += (mask >> 8) * hmid >> 2;
+        else
+            temp.y += hmid;
+        switch( mask & HORIZ)
+        {
+            case BIT_RT:
+                temp.x += wmid;
+                temp.w -= wmid;
+                break;
+            case BIT_LT:
+                temp.w = wmid + pdc_fthick;
+                break;
+            case HORIZ:
+                break;
+        }
+        SDL_FillRect(surf, &temp, col);
+    }
+    temp = dest;
+    if( mask & VERTIC)
+    {
+        temp.x += wmid;
+        temp.w = pdc_fthick;
+        switch( mask & VERTIC)
+        {
+            case BIT_DN:
+                temp.y += hmid;
+                temp.h -= hmid;
+                break;
+            case BIT_UP:
+                temp.h = hmid + pdc_fthick;
+                break;
+            case VERTIC:
+                break;
+        }
+        SDL_FillRect(surf, &temp, col);
+    }
+}
+
+/* Rather than building each line-drawing glyph out of rectangles every
+   time it's drawn, they're all drawn once, in opaque white on a
+   transparent background, into a strip one cell per shape. Drawing one
+   is then a single blit, with the strip's color modulation set to the
+   foreground color. The strip is rebuilt if the font size changes. */
+
+static SDL_Surface *_acs_glyphs = NULL;
+static int _acs_glyphs_w, _acs_glyphs_h, _acs_glyphs_thick;
+
+void PDC_free_acs_glyphs(void)
+{
+    if (_acs_glyphs)
+        SDL_FreeSurface(_acs_glyphs);
+    _acs_glyphs = NULL;
+}
+
+static void _make_acs_glyphs(const int *remap_tbl, const int n_glyphs)
+{
+    SDL_Rect cell;
+    Uint32 white;
+    int i;
+
+    _acs_glyphs = SDL_CreateRGBSurface(0, n_glyphs * pdc_fwidth,
+                        pdc_fheight, 32, 0x00ff0000, 0x0000ff00,
+                        0x000000ff, 0xff000000);
+    if (!_acs_glyphs)
+        return;
+
+    SDL_FillRect(_acs_glyphs, NULL, 0);
+    SDL_SetSurfaceBlendMode(_acs_glyphs, SDL_BLENDMODE_BLEND);
+    white = SDL_MapRGBA(_acs_glyphs->format, 255, 255, 255, 255);
+
+    cell.y = 0;
+    cell.w = pdc_fwidth;
+    cell.h = pdc_fheight;
+    for (i = 0; i < n_glyphs; i++)
+    {
+        cell.x = i * pdc_fwidth;
+        _draw_acs_shape(_acs_glyphs, remap_tbl[i * 2 + 1], cell, white);
+    }
+
+    _acs_glyphs_w = pdc_fwidth;
+    _acs_glyphs_h = pdc_fheight;
+    _acs_glyphs_thick = pdc_fthick;
+}
+
 static bool _grprint(chtype ch, const SDL_Rect dest)
 {
     int i = 0;
@@ -183,59 +453,34 @@ static bool _grprint(chtype ch, const SDL_Rect dest)
             ACS_PLUS, HORIZ | VERTIC,        ACS_BLOCK, 0,
             ACS_S1, HORIZ | SCAN_LINE( 1),     ACS_S3, HORIZ | SCAN_LINE( 3),
             ACS_S7, HORIZ | SCAN_LINE( 7),     ACS_S9, HORIZ | SCAN_LINE( 9),    0 };
+    const int n_glyphs = (int)(sizeof( remap_tbl) / sizeof( remap_tbl[0])) / 2;
 
     while( remap_tbl[i] && remap_tbl[i] != (int)ch)
         i += 2;
     if( remap_tbl[i] == (int)ch)
     {
-        const int hmid = (pdc_fheight - pdc_fthick) >> 1;
-        const int wmid = (pdc_fwidth - pdc_fthick) >> 1;
-        const int mask = remap_tbl[i + 1];
-        SDL_Rect temp = dest;
-        const Uint32 col = get_pdc_mapped( foregr);
-
-        if( ch == ACS_BLOCK)
-            SDL_FillRect(pdc_screen, &temp, col);
-        if( mask & HORIZ)
-        {
-            temp.h = pdc_fthick;
-            if( mask & Sn_CHARS)    /* extract scan line for ACS_Sn characters */
-                temp.y += (mask >> 8) * hmid >> 2;
-            else
-                temp.y += hmid;
-            switch( mask & HORIZ)
-            {
-                case BIT_RT:
-                    temp.x += wmid;
-                    temp.w -= wmid;
-                    break;
-                case BIT_LT:
-                    temp.w = wmid + pdc_fthick;
-                    break;
-                case HORIZ:
-                    break;
-            }
-            SDL_FillRect(pdc_screen, &temp, col);
-        }
-        temp = dest;
-        if( mask & VERTIC)
+        if (_acs_glyphs && (_acs_glyphs_w != pdc_fwidth ||
+                            _acs_glyphs_h != pdc_fheight ||
+                            _acs_glyphs_thick != pdc_fthick))
+            PDC_free_acs_glyphs();
+        if (!_acs_glyphs)
+            _make_acs_glyphs(remap_tbl, n_glyphs);
+
+        if (_acs_glyphs)
         {
-            temp.x += wmid;
-            temp.w = pdc_fthick;
-            switch( mask & VERTIC)
-            {
-                case BIT_DN:
-                    temp.y += hmid;
-                    temp.h -= hmid;
-                    break;
-                case BIT_UP:
-                    temp.h = hmid + pdc_fthick;
-                    break;
-                case VERTIC:
-                    break;
-            }
-            SDL_FillRect(pdc_screen, &temp, col);
+            const SDL_Color *c = get_pdc_color( foregr);
+            SDL_Rect src, temp = dest;
+
+            src.x = (i / 2) * pdc_fwidth;
+            src.y = 0;
+            src.w = pdc_fwidth;
+            src.h = pdc_fheight;
+            SDL_SetSurfaceColorMod(_acs_glyphs, c->r, c->g, c->b);
+            SDL_BlitSurface(_acs_glyphs, &src, pdc_screen, &temp);
         }
+        else
+            _draw_acs_shape(pdc_screen, remap_tbl[i + 1], dest,
+                            get_pdc_mapped( foregr));
         rval = TRUE;
     }
     else
@@ -360,50 +605,10 @@ void PDC_gotoyx(int row, int col)
 #endif
 
     if (oldrow != row || oldcol != col)
-    {
-        if (rectcount == MAXRECT)
-            PDC_update_rects();
-
-        uprect[rectcount++] = dest;
-    }
+        _add_update_rect(&dest);
     PDC_update_rects();
 }
 
-static bool _merge_rects( SDL_Rect *a, const SDL_Rect *b)
-{
-    if( a->x == b->x && a->w == b->w)
-    {
-        const int ay = a->y + a->h;
-        const int by = b->y + b->h;
-
-        if( ay >= b->y && by >= a->y)
-        {
-            const int y1 = min( a->y, b->y);
-            const int y2 = max( ay, by);
-
-            a->y = y1;
-            a->h = y2 - y1;
-            return TRUE;
-        }
-    }
-    if( a->y == b->y && a->h == b->h)
-    {
-        const int ax = a->x + a->w;
-        const int bx = b->x + b->w;
-
-        if( ax >= b->x && bx >= a->x)
-        {
-            const int x1 = min( a->x, b->x);
-            const int x2 = max( ax, bx);
-
-            a->x = x1;
-            a->w = x2 - x1;
-            return TRUE;
-        }
-    }
-    return FALSE;
-}
-
 void _new_packet(attr_t attr, int lineno, int x, int len, const chtype *srcp)
 {
     SDL_Rect src, dest;
@@ -415,9 +620,6 @@ void _new_packet(attr_t attr, int lineno, int x, int len, const chtype *srcp)
     short hcol = SP->line_color;
     bool blink = blinked_off && (attr & A_BLINK) && (sysattrs & A_BLINK);
 
-    if (rectcount == MAXRECT)
-        PDC_update_rects();
-
 #ifdef PDC_WIDE
     src.x = 0;
     src.y = 0;
@@ -429,15 +631,7 @@ void _new_packet(attr_t attr, int lineno, int x, int len, const chtype *srcp)
     dest.x = pdc_fwidth * x + pdc_xoffset;
     dest.h = pdc_fheight;
     dest.w = pdc_fwidth * len;
-    uprect[rectcount++] = dest;
-
-    /* we try merging the new rectangle with the previous one.  It's
-       possible the result can be merged with the one before that,
-       and so on.  */
-
-    while( rectcount >= 2 && _merge_rects( uprect + rectcount - 2,
-                                           uprect + rectcount - 1))
-       rectcount--;
+    _add_update_rect(&dest);
 
     _set_attr(attr);
 
@@ -578,6 +772,8 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
     _new_packet(old_attr, lineno, x, i, srcp);
 }
 
+static SDL_TimerID blinker_id = 0;
+
 static Uint32 _blink_timer(Uint32 interval, void *param)
 {
     SDL_Event event;
@@ -588,40 +784,35 @@ static Uint32 _blink_timer(Uint32 interval, void *param)
     return(interval);
 }
 
-void PDC_blink_text(void)
+static void _stop_blinker(void)
 {
-    static SDL_TimerID blinker_id = 0;
-    int i, j, k;
+    if (blinker_id)
+        SDL_RemoveTimer(blinker_id);
+    blinker_id = 0;
+    blinked_off = FALSE;
+}
 
+/* Only rows that refresh.c has flagged as holding blinking text are
+   redrawn. Once there are none, the timer is stopped, so an idle
+   screen gets no wakeups; PDC_doupdate() restarts it when blinking
+   text is next sent. */
+
+void PDC_blink_text(void)
+{
     oldch = (chtype)(-1);
 
     if (!(SP->termattrs & A_BLINK))
-    {
-        SDL_RemoveTimer(blinker_id);
-        blinker_id = 0;
-    }
+        _stop_blinker();
     else if (!blinker_id)
     {
         blinker_id = SDL_AddTimer(500, _blink_timer, NULL);
-        blinked_off = TRUE;
+        blinked_off = FALSE;
     }
+    else
+        blinked_off = !blinked_off;
 
-    blinked_off = !blinked_off;
-
-    for (i = 0; i < SP->lines; i++)
-    {
-        const chtype *srcp = curscr->_y[i];
-
-        for (j = 0; j < SP->cols; j++)
-            if (srcp[j] & A_BLINK)
-            {
-                k = j;
-                while (k < SP->cols && (srcp[k] & A_BLINK))
-                    k++;
-                PDC_transform_line(i, j, k - j, srcp + j);
-                j = k;
-            }
-    }
+    if (!PDC_redraw_blinking_text())
+        _stop_blinker();
 
     oldch = (chtype)(-1);
 
@@ -630,6 +821,9 @@ void PDC_blink_text(void)
 
 void PDC_doupdate(void)
 {
+    if ((SP->termattrs & A_BLINK) && SP->n_blink_rows && !blinker_id)
+        blinker_id = SDL_AddTimer(500, _blink_timer, NULL);
+
     PDC_update_rects();
 }
 
@@ -645,7 +839,7 @@ void PDC_pump_and_peep(void)
              SDL_WINDOWEVENT_SHOWN == event.window.event))
         {
             SDL_UpdateWindowSurface(pdc_window);
-            rectcount = 0;
+            _clear_update_region();
         }
         else
             SDL_PushEvent(&event);
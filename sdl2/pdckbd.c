@@ -4,6 +4,11 @@
 
 #include <ctype.h>
 #include <string.h>
+#include <SDL_syswm.h>
+#ifndef _WIN32
+# include <fcntl.h>
+# include <unistd.h>
+#endif
 
 static SDL_Event event;
 static SDL_Keycode oldkey;
@@ -93,6 +98,80 @@ void PDC_set_keyboard_binary(bool on)
 static int _stored_key;
 static Uint32 _stored_timestamp;
 
+/* SDL's drivers other than X11 (Wayland, KMSDRM...) give us no
+   descriptor that shows when events arrive.  For them,
+   PDC_get_input_fd() hands out the read end of a pipe,  and an SDL
+   timer (which runs in a thread of its own) writes a byte to it every
+   INPUT_TICK_MS,  so that a poll() loop wakes up to drain input.
+   PDC_check_key() empties the pipe whenever it finds nothing,  so that
+   the pipe doesn't stay readable. */
+
+#define INPUT_TICK_MS 20
+
+#ifndef _WIN32
+static int _tick_pipe[2] = {-1, -1};
+static SDL_TimerID _tick_timer;
+
+static Uint32 _input_tick(Uint32 interval, void *param)
+{
+    const char byte = 0;
+    const ssize_t written = write(_tick_pipe[1], &byte, 1);
+
+    INTENTIONALLY_UNUSED_PARAMETER(param);
+    INTENTIONALLY_UNUSED_PARAMETER(written);   /* if the pipe is full, */
+    return interval;                           /* it's readable anyway */
+}
+
+static int _start_input_ticks(void)
+{
+    if (_tick_pipe[0] < 0)
+    {
+        if (pipe(_tick_pipe))
+            return -1;
+        fcntl(_tick_pipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(_tick_pipe[1], F_SETFL, O_NONBLOCK);
+    }
+    if (!_tick_timer)
+        _tick_timer = SDL_AddTimer(INPUT_TICK_MS, _input_tick, NULL);
+    return (_tick_timer ? _tick_pipe[0] : -1);
+}
+
+static void _drain_input_ticks(void)
+{
+    char buff[64];
+
+    if (_tick_pipe[0] >= 0)
+        while (read(_tick_pipe[0], buff, sizeof(buff)) > 0)
+            ;
+}
+
+void PDC_stop_input_ticks(void)
+{
+    if (_tick_timer)
+        SDL_RemoveTimer(_tick_timer);
+    _tick_timer = 0;
+    if (_tick_pipe[0] >= 0)
+    {
+        close(_tick_pipe[0]);
+        close(_tick_pipe[1]);
+        _tick_pipe[0] = _tick_pipe[1] = -1;
+    }
+}
+#else
+static int _start_input_ticks(void)
+{
+    return -1;
+}
+
+static void _drain_input_ticks(void)
+{
+}
+
+void PDC_stop_input_ticks(void)
+{
+}
+#endif
+
 bool PDC_check_key(void)
 {
     bool haveevent;
@@ -109,6 +188,9 @@ bool PDC_check_key(void)
     else
         haveevent = (bool)SDL_PollEvent(&event);
 
+    if (!haveevent)
+        _drain_input_ticks();
+
     return haveevent;
 }
 
@@ -439,6 +521,19 @@ static int _process_mouse_event(void)
     return KEY_MOUSE;
 }
 
+/* While a window is being dragged to a new size, window managers send a
+   stream of size changes. Only the latest matters (and the size is read
+   from the window surface anyway), so those still queued are dropped,
+   and the screen is resized and redrawn once per batch rather than once
+   per event. */
+
+static int _merge_size_events(void *userdata, SDL_Event *ev)
+{
+    INTENTIONALLY_UNUSED_PARAMETER( userdata);
+    return !(ev->type == SDL_WINDOWEVENT &&
+             ev->window.event == SDL_WINDOWEVENT_SIZE_CHANGED);
+}
+
 /* return the next available key or mouse event */
 
 int PDC_get_key(void)
@@ -466,12 +561,14 @@ int PDC_get_key(void)
             const int prev_cols = pdc_swidth / pdc_fwidth;
             bool size_actually_changed;
 
+            SDL_FilterEvents(_merge_size_events, NULL);
+
             pdc_screen = SDL_GetWindowSurface(pdc_window);
             pdc_sheight = pdc_screen->h - pdc_xoffset;
             pdc_swidth = pdc_screen->w - pdc_yoffset;
             size_actually_changed = ( pdc_sheight / pdc_fheight != prev_rows ||
                                       pdc_swidth / pdc_fwidth != prev_cols);
-            if( size_actually_changed && curscr)
+            if( size_actually_changed && curscr && !SP->resized)
             {
                 touchwin(curscr);
                 wrefresh(curscr);
@@ -503,6 +600,37 @@ int PDC_get_key(void)
     return -1;
 }
 
+/* block until SDL has an event for us,  or for up to 'ms' milliseconds.
+   The blink timer posts events,  so blinking carries on meanwhile */
+
+void PDC_wait_for_input(int ms)
+{
+    PDC_LOG(("PDC_wait_for_input() - called: ms=%d\n", ms));
+
+    if (_stored_key)        /* PDC_check_key() will have it in 2 ms */
+        ms = 3;
+    SDL_WaitEventTimeout(NULL, ms < 0 ? -1 : ms);
+}
+
+/* with SDL's X11 driver,  events come in on the X server connection;
+   for other drivers,  we hand out the pipe described above */
+
+int PDC_get_input_fd(void)
+{
+    SDL_SysWMinfo info;
+
+    PDC_LOG(("PDC_get_input_fd() - called\n"));
+
+    SDL_VERSION(&info.version);
+    if (!pdc_window || !SDL_GetWindowWMInfo(pdc_window, &info))
+        return -1;
+#ifdef SDL_VIDEO_DRIVER_X11
+    if (info.subsystem == SDL_SYSWM_X11)
+        return ConnectionNumber(info.info.x11.display);
+#endif
+    return _start_input_ticks();
+}
+
 /* discard any pending keyboard or mouse input -- this is the core
    routine for flushinp() */
 
@@ -521,7 +649,8 @@ bool PDC_has_mouse(void)
 
 int PDC_mouse_set(void)
 {
-    SDL_ShowCursor(SP->_trap_mbe ? SDL_ENABLE : SDL_DISABLE);
+    SDL_ShowCursor((SP->_trap_mbe & ~PDC_MOUSE_COALESCE) ?
+                   SDL_ENABLE : SDL_DISABLE);
 
     return OK;
 }
@@ -111,7 +111,9 @@ static void _clean(void)
         TTF_Quit();
         pdc_ttffont = NULL;
     }
+    PDC_free_acs_glyphs();
 #endif
+    PDC_free_update_region();
     if( pdc_tileback)
         SDL_FreeSurface(pdc_tileback);
     if( pdc_back)
@@ -129,6 +131,7 @@ static void _clean(void)
         pdc_window = NULL;
     }
 
+    PDC_stop_input_ticks();
     SDL_Quit();
     pdc_sheight = pdc_swidth = 0;
 }
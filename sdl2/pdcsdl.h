@@ -24,6 +24,8 @@ PDCEX  int pdc_font_size;
 #define PDC_SDL_RENDER_BLENDED 3
 
 PDCEX int pdc_sdl_render_mode;
+
+extern void PDC_free_acs_glyphs(void);
 #endif
 PDCEX  SDL_Window *pdc_window;
 PDCEX  SDL_Surface *pdc_screen, *pdc_font, *pdc_icon, *pdc_back;
@@ -41,7 +43,9 @@ extern bool pdc_own_window;          /* if pdc_window was not set
                                         responsible for (owns) it */
 
 PDCEX  void PDC_update_rects(void);
+extern void PDC_free_update_region(void);
 PDCEX  void PDC_retile(void);
 
 extern void PDC_pump_and_peep(void);
+extern void PDC_stop_input_ticks(void);
 extern void PDC_blink_text(void);
@@ -0,0 +1,277 @@
+/* Plays back a recording made with PDC_record_start() (or by setting the
+PDC_RECORD environment variable;  see pdcurses/debug.c),  as fast as
+possible,  and reports how long each frame took compared to how long it
+took when recorded.  This lets changes to a port's PDC_transform_line()
+be timed against what real programs actually draw.  Run as
+
+replay [-v] recording.bin
+
+-v lists the time for each frame,  after the summary.  The replay must
+be built with the same chtype layout (WIDE,  CHTYPE_32) as the program
+that made the recording.
+
+   Each recorded frame's runs of cells are written into stdscr with
+mvaddchnstr(),  then the frame is refresh()ed,  so the timing includes
+the core's own work in doupdate() as well as the port's.  Color pairs
+and palette changes are replayed as they occur;  input events are just
+counted.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <curspriv.h>
+
+typedef struct
+{
+   uint32_t recorded_usec, replayed_usec;
+   long n_cells;
+} FRAME_TIME;
+
+static FILE *ifile;
+
+static uint64_t get_varint( void)
+{
+   uint64_t rval = 0;
+   int shift = 0, byte;
+
+   do
+      {
+      byte = getc( ifile);
+      if( byte == EOF)
+         return( 0);
+      rval |= (uint64_t)( byte & 0x7f) << shift;
+      shift += 7;
+      }
+      while( byte & 0x80);
+   return( rval);
+}
+
+static int get_signed( void)
+{
+   const uint64_t zz = get_varint( );
+
+   return( (int)( zz >> 1) ^ -(int)( zz & 1));
+}
+
+static uint64_t current_usec( void)
+{
+#ifdef CLOCK_MONOTONIC
+   struct timespec t;
+
+   clock_gettime( CLOCK_MONOTONIC, &t);
+   return( (uint64_t)t.tv_sec * 1000000 + (uint64_t)t.tv_nsec / 1000);
+#else
+   return( (uint64_t)clock( ) * 1000000 / CLOCKS_PER_SEC);
+#endif
+}
+
+static int compare_usec( const void *a, const void *b)
+{
+   const uint32_t *ua = (const uint32_t *)a, *ub = (const uint32_t *)b;
+
+   return( *ua > *ub ? 1 : (*ua < *ub ? -1 : 0));
+}
+
+/* Sorts the times (in place) and prints total, mean,  and percentiles */
+
+static void show_stats( const char *title, uint32_t *usec, const long n)
+{
+   double total = 0.;
+   long i;
+
+   for( i = 0; i < n; i++)
+      total += (double)usec[i];
+   qsort( usec, n, sizeof( uint32_t), compare_usec);
+   printf( "%-9s %10.3f %9.1f %9lu %9lu %9lu %9lu\n", title, total / 1000.,
+            total / (double)n, (unsigned long)usec[n / 2],
+            (unsigned long)usec[n * 9 / 10], (unsigned long)usec[n * 99 / 100],
+            (unsigned long)usec[n - 1]);
+}
+
+int main( const int argc, const char **argv)
+{
+   const char *filename = NULL;
+   char magic[8];
+   int i, verbose = 0, type, shown_vis = -1;
+   long n_frames = 0, n_alloced = 0, n_inputs = 0, n_cells = 0;
+   long cells_alloced = 0;
+   FRAME_TIME *frames = NULL;
+   chtype *cells = NULL;
+   uint64_t *rgb = NULL;
+   uint64_t t0 = 0;
+   uint32_t *usec;
+
+   for( i = 1; i < argc; i++)
+      if( !strcmp( argv[i], "-v"))
+         verbose = 1;
+      else
+         filename = argv[i];
+   if( !filename)
+      {
+      fprintf( stderr, "Usage:  replay [-v] recording.bin\n");
+      return( -1);
+      }
+   ifile = fopen( filename, "rb");
+   if( !ifile)
+      {
+      fprintf( stderr, "Couldn't open '%s'\n", filename);
+      return( -2);
+      }
+   if( !fread( magic, 8, 1, ifile) || memcmp( magic, PDC_RECORD_MAGIC, 8))
+      {
+      fprintf( stderr, "'%s' isn't a PDCursesMod recording\n", filename);
+      return( -3);
+      }
+   if( get_varint( ) != sizeof( chtype) || get_varint( ) != (uint64_t)A_CHARTEXT)
+      {
+      fprintf( stderr, "Recording was made with a different chtype layout\n"
+                       "(WIDE or CHTYPE_32 setting)\n");
+      return( -4);
+      }
+   initscr( );
+   start_color( );
+   noecho( );
+   while( (type = getc( ifile)) != EOF)
+      switch( type)
+         {
+         case PDC_REC_SIZE:
+            {
+            const int lines = (int)get_varint( );
+            const int cols = (int)get_varint( );
+
+            if( lines != LINES || cols != COLS)
+               resize_term( lines, cols);
+            }
+            break;
+         case PDC_REC_PAIR:
+            {
+            const int pair = (int)get_varint( );
+            const int fg = get_signed( );
+            const int bg = get_signed( );
+
+            if( pair)
+               init_extended_pair( pair, fg, bg);
+            else
+               assume_default_colors( fg, bg);
+            }
+            break;
+         case PDC_REC_COLOR:
+            {
+            const int color = (int)get_varint( );
+            const int red = get_signed( );
+            const int green = get_signed( );
+            const int blue = get_signed( );
+
+            init_extended_color( color, red, green, blue);
+            }
+            break;
+         case PDC_REC_FRAME_BEGIN:
+            get_varint( );
+            if( get_varint( ))
+               clearok( curscr, TRUE);
+            if( n_frames == n_alloced)
+               {
+               n_alloced = (n_alloced ? n_alloced * 2 : 1024);
+               frames = (FRAME_TIME *)realloc( frames,
+                                    n_alloced * sizeof( FRAME_TIME));
+               }
+            frames[n_frames].n_cells = 0;
+            break;
+         case PDC_REC_RUN:
+            {
+            const int y = (int)get_varint( );
+            const int x = (int)get_varint( );
+            const int len = (int)get_varint( );
+            chtype prev = 0;
+
+            if( len > cells_alloced)
+               {
+               cells_alloced = len;
+               cells = (chtype *)realloc( cells, len * sizeof( chtype));
+               rgb = (uint64_t *)realloc( rgb, len * sizeof( uint64_t));
+               }
+            for( i = 0; i < len; i++)
+               {
+               prev = cells[i] = prev ^ (chtype)get_varint( );
+               if( cells[i] & A_DIRECT_COLOR)
+                  rgb[i] = get_varint( );
+               }
+            mvaddchnstr( y, x, cells, len);
+            for( i = 0; i < len; i++)     /* direct colors go in cell by cell */
+               if( cells[i] & A_DIRECT_COLOR)
+                  {
+                  PDC_set_rgb( (int32_t)( rgb[i] & 0xffffff),
+                               (int32_t)( rgb[i] >> 24));
+                  mvaddchnstr( y, x + i, cells + i, 1);
+                  }
+            if( frames)
+               frames[n_frames].n_cells += len;
+            }
+            break;
+         case PDC_REC_FRAME_END:
+            {
+            const uint32_t recorded_usec = (uint32_t)get_varint( );
+            const int y = (int)get_varint( );
+            const int x = (int)get_varint( );
+            const int vis = (int)get_varint( );
+
+            if( vis != shown_vis)
+               curs_set( vis);
+            shown_vis = vis;
+            move( y, x);
+            t0 = current_usec( );
+            refresh( );
+            if( frames)
+               {
+               frames[n_frames].replayed_usec = (uint32_t)( current_usec( ) - t0);
+               frames[n_frames].recorded_usec = recorded_usec;
+               n_cells += frames[n_frames].n_cells;
+               n_frames++;
+               }
+            }
+            break;
+         case PDC_REC_KEY:
+            get_varint( );
+            get_varint( );
+            get_varint( );
+            n_inputs++;
+            break;
+         case PDC_REC_MOUSE:
+            for( i = 0; i < 9; i++)
+               get_varint( );
+            n_inputs++;
+            break;
+         default:
+            endwin( );
+            fprintf( stderr, "Unknown record type %d at offset %ld\n",
+                        type, ftell( ifile) - 1);
+            return( -5);
+         }
+   endwin( );
+   fclose( ifile);
+   printf( "%s: %ld frames,  %ld cells,  %ld input events\n", filename,
+                        n_frames, n_cells, n_inputs);
+   if( n_frames)
+      {
+      usec = (uint32_t *)malloc( n_frames * sizeof( uint32_t));
+      printf( "(usec)    total (ms)      mean    median       90%%       99%%       max\n");
+      for( i = 0; i < n_frames; i++)
+         usec[i] = frames[i].recorded_usec;
+      show_stats( "recorded", usec, n_frames);
+      for( i = 0; i < n_frames; i++)
+         usec[i] = frames[i].replayed_usec;
+      show_stats( "replayed", usec, n_frames);
+      free( usec);
+      }
+   if( verbose)
+      for( i = 0; i < n_frames; i++)
+         printf( "%6d %7ld cells %9lu %9lu\n", i, frames[i].n_cells,
+                  (unsigned long)frames[i].recorded_usec,
+                  (unsigned long)frames[i].replayed_usec);
+   free( frames);
+   free( cells);
+   free( rgb);
+   delscreen( SP);
+   return( 0);
+}
@@ -0,0 +1,77 @@
+#include <curses.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Regression test for scrolling a window that has been narrowed with
+wresize(),  and a subwindow.  In both,  lines are not _maxx cells apart
+in memory,  and wscrl() used to move and blank the wrong cells.  Each
+row of a window is filled with one letter ('A', 'B', ...),  the window
+is scrolled,  and the rows read back with winnstr().  After endwin(),
+prints the rows found and "OK" or "FAILED";  the exit code is zero if
+all went well.
+
+gcc -Wall -Wextra -pedantic -o rsz_scrl rsz_scrl.c -lncursesw    */
+
+static char _results[400];
+
+static int _check( WINDOW *win, const char *title, const char *expected)
+{
+    char found[20], tbuff[40], line[100];
+    int y, rval = 0;
+
+    for( y = 0; y < getmaxy( win); y++)
+    {
+        wmove( win, y, 0);
+        winnstr( win, tbuff, 1);
+        found[y] = tbuff[0];
+    }
+    found[y] = '\0';
+    if( strcmp( found, expected))
+        rval = -1;
+    sprintf( line, "%-28s '%s' (expected '%s') %s\n", title, found,
+                     expected, (rval ? "FAILED" : "OK"));
+    strcat( _results, line);
+    return( rval);
+}
+
+static void _fill( WINDOW *win)
+{
+    int y;
+
+    for( y = 0; y < getmaxy( win); y++)
+    {
+        wmove( win, y, 0);
+        whline( win, (chtype)( 'A' + y), getmaxx( win));
+    }
+}
+
+int main( void)
+{
+    WINDOW *win, *sub;
+    int n_failures = 0;
+
+    initscr( );
+    win = newwin( 4, 20, 0, 0);
+    wresize( win, 4, 10);
+    scrollok( win, TRUE);
+    _fill( win);
+    wscrl( win, 1);
+    n_failures += _check( win, "narrowed window, up 1", "BCD ");
+    _fill( win);
+    wscrl( win, -2);
+    n_failures += _check( win, "narrowed window, down 2", "  AB");
+
+    sub = subwin( stdscr, 4, 10, 5, 5);
+    scrollok( sub, TRUE);
+    _fill( sub);
+    wscrl( sub, 1);
+    n_failures += _check( sub, "subwindow, up 1", "BCD ");
+    _fill( sub);
+    wscrl( sub, -1);
+    n_failures += _check( sub, "subwindow, down 1", " ABC");
+    delwin( sub);
+    delwin( win);
+    endwin( );
+    printf( "%s%s\n", _results, n_failures ? "FAILED" : "All tests passed");
+    return( n_failures ? -1 : 0);
+}
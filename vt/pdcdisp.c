@@ -19,20 +19,26 @@
 #include "../common/acs_defs.h"
 #include "../common/pdccolor.h"
 
+/* Output goes to the descriptor behind the 'outfd' given to newterm( )
+(stdout for initscr( )).  If that's stdout,  and it's been redirected to
+a file,  we use stderr instead. */
+
 int PDC_get_terminal_fd( void)
 {
-    static int stdout_fd = -1;
+    struct _pdc_port_state *port = SP->port;
 
-    if( stdout_fd == -1)
+    if( port->out_fd == -1)
       {
 #if defined( _WIN32) || defined( __DMC__)
 /*    if( FILE_TYPE_CHAR == GetFileType( GetStdHandle( STD_OUTPUT_HANDLE)))  */
-      stdout_fd = 2;
+      port->out_fd = 2;
 #else
-      if( isatty( STDOUT_FILENO))
-         stdout_fd = STDOUT_FILENO;   /* stdout hasn't been redirected;  use it */
+      const int fd = fileno( SP->output_fd);
+
+      if( SP->output_fd != stdout || isatty( fd))
+         port->out_fd = fd;
       else if( isatty( STDERR_FILENO))
-         stdout_fd = STDERR_FILENO;    /* stdout is redirected to a file;  use stderr */
+         port->out_fd = STDERR_FILENO;    /* stdout is redirected to a file;  use stderr */
       else
          {
          fprintf(stderr, "No output device found\n");
@@ -40,7 +46,7 @@ int PDC_get_terminal_fd( void)
          }
 #endif
       }
-   return( stdout_fd);
+   return( port->out_fd);
 }
 
                    /* Rarely,  writes to stdout fail if a signal handler is
@@ -51,50 +57,51 @@ int PDC_get_terminal_fd( void)
 
 static void put_to_stdout( const char *buff, size_t bytes_out)
 {
-    static char *tbuff = NULL;
-    static size_t bytes_cached;
+    struct _pdc_port_state *port = (SP ? SP->port : NULL);
     int stdout_fd;
 
-    if( !buff && !tbuff)
+    if( !port || (!buff && !port->tbuff))
         return;
 
     if( !buff && bytes_out == 1)        /* release memory at shutdown */
     {
-        free( tbuff);
-        tbuff = NULL;
-        bytes_cached = 0;
+        free( port->tbuff);
+        port->tbuff = NULL;
+        port->bytes_cached = 0;
         return;
     }
 
-    if( buff && !tbuff)
-        tbuff = (char *)malloc( TBUFF_SIZE);
+    if( buff && !port->tbuff)
+        port->tbuff = (char *)malloc( TBUFF_SIZE);
     stdout_fd = PDC_get_terminal_fd( );
-    while( bytes_out || (!buff && bytes_cached))
+    while( bytes_out || (!buff && port->bytes_cached))
     {
         if( buff)
         {
             size_t n_copy = bytes_out;
 
-            if( n_copy > TBUFF_SIZE - bytes_cached)
-                n_copy = TBUFF_SIZE - bytes_cached;
-            memcpy( tbuff + bytes_cached, buff, n_copy);
+            if( n_copy > TBUFF_SIZE - port->bytes_cached)
+                n_copy = TBUFF_SIZE - port->bytes_cached;
+            memcpy( port->tbuff + port->bytes_cached, buff, n_copy);
             buff += n_copy;
             bytes_out -= n_copy;
-            bytes_cached += n_copy;
+            port->bytes_cached += n_copy;
         }
-        if( bytes_cached == TBUFF_SIZE || !buff)
-            while( bytes_cached)
+        if( port->bytes_cached == TBUFF_SIZE || !buff)
+            while( port->bytes_cached)
             {
 #ifdef _WIN32
-                const size_t bytes_written = _write( stdout_fd, tbuff,
-                                             (unsigned int)bytes_cached);
+                const size_t bytes_written = _write( stdout_fd, port->tbuff,
+                                             (unsigned int)port->bytes_cached);
 #else
-                const size_t bytes_written = write( stdout_fd, tbuff, bytes_cached);
+                const size_t bytes_written = write( stdout_fd, port->tbuff,
+                                                    port->bytes_cached);
 #endif
 
-                bytes_cached -= bytes_written;
-                if( bytes_cached)
-                    memmove( tbuff, tbuff + bytes_written, bytes_cached);
+                port->bytes_cached -= bytes_written;
+                if( port->bytes_cached)
+                    memmove( port->tbuff, port->tbuff + bytes_written,
+                                                    port->bytes_cached);
             }
     }
 }
@@ -182,18 +189,17 @@ static int get_sixteen_color_idx( const PACKED_RGB rgb)
 
 static void reset_color( char *obuff, const chtype ch)
 {
-    static PACKED_RGB prev_bg = (PACKED_RGB)-2;
-    static PACKED_RGB prev_fg = (PACKED_RGB)-2;
+    struct _pdc_port_state *port = SP->port;
     PACKED_RGB bg, fg;
 
     if( !obuff)
         {
-        prev_bg = prev_fg = (PACKED_RGB)-2;
+        port->prev_bg = port->prev_fg = (PACKED_RGB)-2;
         return;
         }
     PDC_get_rgb_values( ch, &fg, &bg);
     *obuff = '\0';
-    if( bg != prev_bg)
+    if( bg != port->prev_bg)
         {
         if( bg == (PACKED_RGB)-1)   /* default background */
             strcpy( obuff, CSI "49m");
@@ -206,10 +212,10 @@ static void reset_color( char *obuff, const chtype ch)
             strcpy( obuff, CSI "48;");
             color_string( obuff + 5, bg);
             }
-        prev_bg = bg;
+        port->prev_bg = bg;
         }
 
-    if( fg != prev_fg)
+    if( fg != port->prev_fg)
         {
         obuff += strlen( obuff);
         if( fg == (PACKED_RGB)-1)   /* default foreground */
@@ -221,7 +227,7 @@ static void reset_color( char *obuff, const chtype ch)
             strcpy( obuff, CSI "38;");
             color_string( obuff + 5, fg);
             }
-        prev_fg = fg;
+        port->prev_fg = fg;
         }
 }
 
@@ -231,14 +237,13 @@ int PDC_wc_to_utf8( char *dest, const int32_t code);
 
 void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
 {
-    static chtype prev_ch = 0;
-    static bool force_reset_all_attribs = TRUE;
+    struct _pdc_port_state *port = SP->port;
     char obuff[OBUFF_SIZE];
 
     if( !srcp)
     {
-        prev_ch = 0;
-        force_reset_all_attribs = TRUE;
+        port->prev_ch = 0;
+        port->force_reset_all_attribs = TRUE;
         PDC_puts_to_stdout( RESET_ATTRS);
         return;
     }
@@ -247,18 +252,17 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
     assert( lineno >= 0);
     assert( lineno < SP->lines);
     assert( len > 0);
-    assert( len < MAX_PACKET_LEN);
     PDC_gotoyx( lineno, x);
-    if( force_reset_all_attribs || (!x && !lineno))
+    if( port->force_reset_all_attribs || (!x && !lineno))
     {
-        force_reset_all_attribs = FALSE;
+        port->force_reset_all_attribs = FALSE;
         reset_color( NULL, 0);
-        prev_ch = ~*srcp;
+        port->prev_ch = ~*srcp;
     }
     while( len)
     {
        int ch = (int)( *srcp & A_CHARTEXT), count = 1;
-       chtype changes = *srcp ^ prev_ch;
+       chtype changes = *srcp ^ port->prev_ch;
        size_t bytes_out = 0;
 
        assert( ch != MAX_UNICODE);
@@ -270,7 +274,7 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
        *obuff = '\0';
        if( changes & (A_REVERSE | A_STRIKEOUT | A_BOLD))
        {
-          prev_ch = 0;
+          port->prev_ch = 0;
           changes = *srcp | A_COLOR;
           strcpy( obuff, RESET_ATTRS);
           reset_color( NULL, 0);
@@ -337,7 +341,7 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
        }
        put_to_stdout( obuff, bytes_out);
        bytes_out = 0;
-       prev_ch = *srcp;
+       port->prev_ch = *srcp;
        srcp += count;
        len -= count;
    }
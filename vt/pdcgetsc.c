@@ -1,6 +1,7 @@
 /* Public Domain Curses */
 
 #include <curspriv.h>
+#include "pdcvt.h"
 
 int PDC_get_cursor_mode(void)
 {
@@ -12,16 +13,12 @@ int PDC_get_cursor_mode(void)
 
 int PDC_get_columns(void)
 {
-    extern int PDC_cols;
-
     PDC_LOG(("PDC_get_columns() - called\n"));
-    return( PDC_cols);
+    return( SP->port->cols);
 }
 
 int PDC_get_rows(void)
 {
-    extern int PDC_rows;
-
     PDC_LOG(("PDC_get_rows() - called\n"));
-    return( PDC_rows);
+    return( SP->port->rows);
 }
@@ -8,6 +8,8 @@
 #else
    #include <sys/select.h>
    #include <unistd.h>
+   #include <fcntl.h>
+   #include <signal.h>
 #endif
 #include "curspriv.h"
 #include "pdcvt.h"
@@ -35,6 +37,91 @@ https://www.gnu.org/software/screen/manual/html_node/Control-Sequences.html
 
 extern bool PDC_resize_occurred;
 
+/* A select( ) call per check is what makes a busy nodelay( ) getch( )
+loop expensive.  If PDC_SIGIO=1 is set in the environment,  we ask the
+kernel to send SIGIO when input arrives on a screen's input,  and the
+handler just counts it.  That's off by default:  the signal interrupts
+sleep( ),  select( ) and the like in the rest of the program,  and kills
+a program that exec( )s another without calling endwin( ) first.
+The handler can't tell which input it was for,  so each screen keeps
+(in SP->port) the count it last saw.  So long as the count hasn't moved,
+nothing can have arrived for that screen and check_key( ) returns at
+once,  without a syscall.  The count is noted just before each select( ),
+and if that finds input,  the screen looks again next time (there may be
+more),  so input arriving in between is never missed.
+
+   Each screen sets O_ASYNC on its own input.  If the input already has
+it set (say,  another SCREEN on the same terminal did),  or isn't a
+terminal,  or the program has its own SIGIO handler,  or PDC_SIGIO isn't
+set,  that screen just select( )s every time. */
+
+#if defined( O_ASYNC) && defined( F_SETOWN) && defined( SIGIO)
+   #define USE_SIGIO
+#endif
+
+#ifdef USE_SIGIO
+static volatile sig_atomic_t _sigio_count = 0;
+static int _sigio_state = 0;      /* 0 = untried, 1 = usable, -1 = not */
+
+static void _sigio_handler( int sig)
+{
+    INTENTIONALLY_UNUSED_PARAMETER( sig);
+    _sigio_count = (_sigio_count + 1) & 0x3fffffff;
+}
+#endif
+
+/* Called with 'on' = TRUE from PDC_reset_prog_mode( ),  and FALSE from
+PDC_scr_close( ),  so that the terminal isn't left set up to signal us
+while the shell (or a program we've shelled out to) has it. */
+
+void PDC_watch_input( const bool on)
+{
+#ifdef USE_SIGIO
+    struct _pdc_port_state *port = (SP ? SP->port : NULL);
+    const int fd = (SP && SP->input_fd ? fileno( SP->input_fd) : -1);
+    int flags;
+
+    if( !port)
+        return;
+    port->more_input = TRUE;
+    if( !on)
+    {
+        if( port->sigio_active && fd >= 0
+                    && (flags = fcntl( fd, F_GETFL)) != -1)
+            fcntl( fd, F_SETFL, flags & ~O_ASYNC);
+        port->sigio_active = FALSE;
+        return;
+    }
+    if( port->sigio_active || fd < 0 || !isatty( fd))
+        return;
+    if( !_sigio_state)
+    {
+        struct sigaction sa;
+        const char *env = getenv( "PDC_SIGIO");
+
+        _sigio_state = -1;
+        if( env && atoi( env) > 0
+                    && !sigaction( SIGIO, NULL, &sa)
+                    && sa.sa_handler == SIG_DFL)
+        {
+            sigemptyset( &sa.sa_mask);
+            sa.sa_flags = SA_RESTART;
+            sa.sa_handler = _sigio_handler;
+            if( !sigaction( SIGIO, &sa, NULL))
+                _sigio_state = 1;
+        }
+    }
+    if( _sigio_state == 1
+                && (flags = fcntl( fd, F_GETFL)) != -1
+                && !(flags & O_ASYNC)
+                && fcntl( fd, F_SETOWN, getpid( )) != -1
+                && fcntl( fd, F_SETFL, flags | O_ASYNC) != -1)
+        port->sigio_active = TRUE;
+#else
+    INTENTIONALLY_UNUSED_PARAMETER( on);
+#endif
+}
+
 static bool check_key( int *c)
 {
     bool rval;
@@ -58,6 +145,17 @@ static bool check_key( int *c)
           }
        return( TRUE);
        }
+#ifdef USE_SIGIO
+    if( SP->port->sigio_active)
+       {
+       const sig_atomic_t count = _sigio_count;
+
+       if( count == SP->port->sigio_seen && !SP->port->more_input)
+          return( FALSE);
+       SP->port->sigio_seen = count;
+       SP->port->more_input = FALSE;
+       }
+#endif
     FD_ZERO( &rdset);
     FD_SET( fileno( SP->input_fd), &rdset);
     timeout.tv_sec = 0;
@@ -65,6 +163,7 @@ static bool check_key( int *c)
     if( select( fileno( SP->input_fd) + 1, &rdset, NULL, NULL, &timeout) > 0)
        {
        rval = TRUE;
+       SP->port->more_input = TRUE;
        if( c)
           *c = fgetc( SP->input_fd);
        }
@@ -83,20 +182,66 @@ static bool check_key( int *c)
     return( rval);
 }
 
-static MOUSE_STATUS _cached_mouse_status;
-
 bool PDC_check_key( void)
 {
-   if( _cached_mouse_status.changes)
+   if( SP->port->cached_mouse_status.changes)
       return( TRUE);
    return( check_key( NULL));
 }
 
+/* Sleep in select() until there's something on the input,  rather than
+napping in 50 ms slices.  A SIGWINCH or Ctrl-C interrupts the select().
+The framebuffer port draws its own blinking cursor and text,  so it
+must wake up in time for the next blink -- if anything is blinking. */
+
+void PDC_wait_for_input( int ms)
+{
+#ifndef USE_CONIO
+    struct timeval timeout;
+    fd_set rdset;
+    extern int PDC_n_ctrl_c;
+
+    if( PDC_resize_occurred || PDC_n_ctrl_c)
+       return;
+#ifdef LINUX_FRAMEBUFFER_PORT
+    {
+       const long until_blink = PDC_check_for_blinking( );
+
+       if( until_blink >= 0 && (ms < 0 || ms > until_blink))
+          ms = (int)until_blink;
+    }
+#endif
+    FD_ZERO( &rdset);
+    FD_SET( fileno( SP->input_fd), &rdset);
+    if( ms >= 0)
+       {
+       timeout.tv_sec = ms / 1000;
+       timeout.tv_usec = (ms % 1000) * 1000;
+       }
+    if( select( fileno( SP->input_fd) + 1, &rdset, NULL, NULL,
+                                 (ms >= 0 ? &timeout : NULL)) > 0)
+       SP->port->more_input = TRUE;    /* SIGIO may not have been handled yet */
+#else
+    PDC_napms( (ms < 0 || ms > 50) ? 50 : ms);
+#endif
+}
+
+/* the terminal;  PDC_check_key( ) select()s on it,  too */
+
+int PDC_get_input_fd( void)
+{
+#ifndef USE_CONIO
+    if( SP && SP->input_fd)
+       return( fileno( SP->input_fd));
+#endif
+    return( -1);
+}
+
 void PDC_flushinp( void)
 {
    int thrown_away_char;
 
-   _cached_mouse_status.changes = 0;
+   SP->port->cached_mouse_status.changes = 0;
    while( check_key( &thrown_away_char))
       ;
 }
@@ -411,10 +556,10 @@ int PDC_get_key( void)
       PDC_resize_occurred = FALSE;
       return( KEY_RESIZE);
       }
-   if( !recursed && _cached_mouse_status.changes)
+   if( !recursed && SP->port->cached_mouse_status.changes)
       {
-      SP->mouse_status = _cached_mouse_status;
-      _cached_mouse_status.changes = 0;
+      SP->mouse_status = SP->port->cached_mouse_status;
+      SP->port->cached_mouse_status.changes = 0;
       return( KEY_MOUSE);
       }
    if( check_key( &rval))
@@ -463,7 +608,6 @@ int PDC_get_key( void)
          if( rval == KEY_MOUSE)
             {
             int idx, button, flags = 0, i, x, y;
-            static int held = 0;
             bool release;
 
             if( c[1] == 'M')     /* 'traditional' mouse encoding */
@@ -476,7 +620,7 @@ int PDC_get_key( void)
                if( release)         /* which button was released? */
                   {
                   button = 0;
-                  while( button < 3 && !((held >> button) & 1))
+                  while( button < 3 && !((SP->port->held >> button) & 1))
                      button++;
                   }
                }
@@ -564,14 +708,14 @@ int PDC_get_key( void)
                            else     /* some other mouse event;  store and report */
                               {     /* next time we're asked for a key/mouse event */
                               keep_going = FALSE;
-                              _cached_mouse_status = SP->mouse_status;
+                              SP->port->cached_mouse_status = SP->mouse_status;
                               }
                            }
                      }
                   SP->mouse_status = stored;
                   recursed = FALSE;
                   if( !n_events)   /* just a click,  no release(s) */
-                     held ^= (1 << button);
+                     SP->port->held ^= (1 << button);
                   else if( n_events < 3)
                       SP->mouse_status.button[button] = BUTTON_CLICKED;
                   else if( n_events < 5)
@@ -677,7 +821,7 @@ int PDC_mouse_set( void)
    if( !PDC_is_ansi)
 #endif
       {
-      static int curr_tracking_state = -1;
+      struct _pdc_port_state *port = SP->port;
       int tracking_state;
 
       if( SP->_trap_mbe & REPORT_MOUSE_POSITION)
@@ -685,17 +829,17 @@ int PDC_mouse_set( void)
       else if( SP->_trap_mbe & (BUTTON1_MOVED | BUTTON2_MOVED | BUTTON3_MOVED))
          tracking_state = 1002;
       else
-         tracking_state = (SP->_trap_mbe ? 1000 : 0);
-      if( curr_tracking_state != tracking_state)
+         tracking_state = ((SP->_trap_mbe & ~PDC_MOUSE_COALESCE) ? 1000 : 0);
+      if( port->tracking_state != tracking_state)
          {
          char tbuff[80];
 
-         if( curr_tracking_state > 0)
+         if( port->tracking_state > 0)
             {
 #ifdef HAVE_SNPRINTF
-            snprintf( tbuff, sizeof( tbuff), CSI "?%dl", curr_tracking_state);
+            snprintf( tbuff, sizeof( tbuff), CSI "?%dl", port->tracking_state);
 #else
-            sprintf( tbuff, CSI "?%dl", curr_tracking_state);
+            sprintf( tbuff, CSI "?%dl", port->tracking_state);
 #endif
             PDC_puts_to_stdout( tbuff);
             }
@@ -708,7 +852,7 @@ int PDC_mouse_set( void)
 #endif
             PDC_puts_to_stdout( tbuff);
             }
-         curr_tracking_state = tracking_state;
+         port->tracking_state = tracking_state;
          PDC_doupdate( );
          }
       }
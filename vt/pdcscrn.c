@@ -7,8 +7,6 @@
 #include <unistd.h>
 #include <termios.h>
 #include <sys/ioctl.h>
-
-static struct termios orig_term;
 #endif
 
 #ifdef _WIN32
@@ -33,8 +31,6 @@ int PDC_is_ansi = TRUE;
 int PDC_is_ansi = FALSE;
 #endif
 
-int PDC_rows = -1, PDC_cols = -1;
-
 #ifdef _WIN32
 
 #ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
@@ -109,13 +105,12 @@ static int set_win10_for_vt_codes( const bool setting_mode)
               /* set up to process xterm-like sequences : */
     PDC_is_ansi = FALSE;
     if( setting_mode)
-        PDC_get_screen_size( &PDC_cols, &PDC_rows);
+        PDC_get_screen_size( &SP->port->cols, &SP->port->rows);
     return( 0);
 }
 #endif
 
 bool PDC_resize_occurred = FALSE;
-static mmask_t _stored_trap_mbe;
 
 /* COLOR_PAIR to attribute encoding table. */
 
@@ -124,8 +119,8 @@ void PDC_reset_prog_mode( void)
 #ifdef USE_TERMIOS
     struct termios term;
 
-    tcgetattr( fileno( SP->input_fd), &orig_term);
-    memcpy( &term, &orig_term, sizeof( term));
+    tcgetattr( fileno( SP->input_fd), &SP->port->orig_term);
+    memcpy( &term, &SP->port->orig_term, sizeof( term));
     term.c_lflag &= ~(ICANON | ECHO);
     term.c_iflag &= ~ICRNL;
     term.c_cc[VSUSP] = _POSIX_VDISABLE;   /* disable Ctrl-Z */
@@ -141,9 +136,10 @@ void PDC_reset_prog_mode( void)
        PDC_puts_to_stdout( CSI "?47h");      /* Save screen */
     PDC_puts_to_stdout( "\033" "7");         /* save cursor & attribs (VT100) */
 
-    SP->_trap_mbe = _stored_trap_mbe;
+    SP->_trap_mbe = SP->port->stored_trap_mbe;
     PDC_mouse_set( );          /* clear any mouse event captures */
     PDC_resize_occurred = FALSE;
+    PDC_watch_input( TRUE);
 }
 
 void PDC_reset_shell_mode( void)
@@ -154,7 +150,7 @@ static int initial_PDC_rows, initial_PDC_cols;
 
 int PDC_resize_screen(int nlines, int ncols)
 {
-   if( PDC_rows == -1)     /* initscr( ) hasn't been called;  we're just */
+   if( !SP || !SP->port)   /* initscr( ) hasn't been called;  we're just */
       {                    /* setting desired size at startup */
       initial_PDC_rows = nlines;
       initial_PDC_cols = ncols;
@@ -169,8 +165,8 @@ int PDC_resize_screen(int nlines, int ncols)
       sprintf( tbuff, CSI "8;%d;%dt", nlines, ncols);
 #endif
       PDC_puts_to_stdout( tbuff);
-      PDC_rows = nlines;
-      PDC_cols = ncols;
+      SP->port->rows = nlines;
+      SP->port->cols = ncols;
       }
    return( 0);
 }
@@ -195,17 +191,18 @@ void PDC_scr_close( void)
    PDC_puts_to_stdout( CSI "m");         /* set default screen attributes */
    PDC_puts_to_stdout( CSI "?47l");      /* restore screen */
    PDC_curs_set( 2);          /* blinking block cursor */
-   PDC_gotoyx( PDC_cols - 1, 0);
-   _stored_trap_mbe = SP->_trap_mbe;
+   PDC_gotoyx( SP->port->cols - 1, 0);
+   SP->port->stored_trap_mbe = SP->_trap_mbe;
    SP->_trap_mbe = 0;
    PDC_mouse_set( );          /* clear any mouse event captures */
 #ifdef _WIN32
    set_win10_for_vt_codes( FALSE);
 #else
    #if !defined( DOS)
-      tcsetattr( fileno( SP->input_fd), TCSANOW, &orig_term);
+      tcsetattr( fileno( SP->input_fd), TCSANOW, &SP->port->orig_term);
    #endif
 #endif
+   PDC_watch_input( FALSE);
    PDC_doupdate( );
    PDC_flushinp( );
    PDC_puts_to_stdout( NULL);      /* free internal cache */
@@ -218,25 +215,30 @@ void PDC_scr_free( void)
 #ifdef USING_COMBINING_CHARACTER_SCHEME
     PDC_expand_combined_characters( 0, NULL);
 #endif
+    if( SP->port)
+    {
+        free( SP->port->tbuff);
+        free( SP->port);
+        SP->port = NULL;
+    }
 }
 
 #ifdef USE_TERMIOS
 
-int PDC_get_terminal_fd( void);        /* pdckbd.c */
-
 static void sigwinchHandler( int sig)
 {
    struct winsize ws;
 
    INTENTIONALLY_UNUSED_PARAMETER( sig);
+   if( !SP || !SP->port)      /* only the current screen is checked */
+      return;
    if( -1 != ioctl( PDC_get_terminal_fd( ), TIOCGWINSZ, &ws))
-      if( PDC_rows != ws.ws_row || PDC_cols != ws.ws_col)
+      if( SP->port->rows != ws.ws_row || SP->port->cols != ws.ws_col)
          {
-         PDC_rows = ws.ws_row;
-         PDC_cols = ws.ws_col;
+         SP->port->rows = ws.ws_row;
+         SP->port->cols = ws.ws_col;
          PDC_resize_occurred = TRUE;
-         if (SP)
-            SP->resized = TRUE;
+         SP->resized = TRUE;
          }
 }
 
@@ -270,11 +272,26 @@ int PDC_scr_open(void)
 #ifdef USE_TERMIOS
     struct sigaction sa;
 #endif
+
+    PDC_LOG(("PDC_scr_open called\n"));
+    assert( SP);
+    if( !SP)
+        return ERR;
+    if( !SP->port)
+    {
+        SP->port = (struct _pdc_port_state *)calloc( 1,
+                                      sizeof( struct _pdc_port_state));
+        if( !SP->port)
+            return ERR;
+        SP->port->out_fd = -1;       /* determined on first output */
+        SP->port->force_reset_all_attribs = TRUE;
+        SP->port->prev_fg = SP->port->prev_bg = (PACKED_RGB)-2;
+        SP->port->rows = SP->port->cols = -1;
+        SP->port->tracking_state = -1;
+    }
 #ifdef _WIN32
     set_win10_for_vt_codes( TRUE);
 #endif
-
-    PDC_LOG(("PDC_scr_open called\n"));
     if( term_env && !strcmp( term_env, "linux"))
        PDC_is_ansi = TRUE;
     else if( colorterm && !strcmp( colorterm, "truecolor"))
@@ -297,8 +314,7 @@ int PDC_scr_open(void)
     COLORS = (PDC_is_ansi ? 16 : 256);
     if( PDC_has_rgb_color)
        COLORS = 256 + (256 * 256 * 256);
-    assert( SP);
-    if (!SP || PDC_init_palette( ))
+    if( PDC_init_palette( ))
         return ERR;
 
     setbuf( SP->input_fd, NULL);
@@ -324,14 +340,14 @@ int PDC_scr_open(void)
         const char *env = getenv("PDC_LINES");
 
         if( env)
-           PDC_rows = atoi( env);
-        if( PDC_rows < 2)
-           PDC_rows = 24;
+           SP->port->rows = atoi( env);
+        if( SP->port->rows < 2)
+           SP->port->rows = 24;
         env = getenv( "PDC_COLS");
         if( env)
-           PDC_cols = atoi( env);
-        if( PDC_cols < 2)
-           PDC_cols = 80;
+           SP->port->cols = atoi( env);
+        if( SP->port->cols < 2)
+           SP->port->cols = 80;
     }
 #endif
     SP->mouse_wait = PDC_CLICK_PERIOD;
@@ -341,7 +357,7 @@ int PDC_scr_open(void)
     SP->mono = FALSE;
     SP->orig_attr = TRUE;
     SP->orig_fore = SP->orig_back = -1;
-    SP->termattrs = PDC_capabilities & ~A_BLINK;
+    SP->termattrs = (PDC_capabilities & ~A_BLINK) | A_DIRECT_COLOR;
 
     while( PDC_get_rows( ) < 1 && PDC_get_columns( ) < 1)
       ;     /* wait for screen to be drawn and size determined */
@@ -4,6 +4,8 @@
    #undef MOUSE_MOVED
 #else
    #include <unistd.h>
+   #include <errno.h>
+   #include <time.h>
 #endif
 #include "curspriv.h"
 
@@ -11,6 +13,22 @@ void PDC_beep(void)
 {
 }
 
+#if !defined( _WIN32) && !defined( DOS)
+/* nanosleep() rather than usleep(),  so that if a signal (SIGWINCH,  or
+SIGIO if that's turned on;  see pdckbd.c) interrupts the nap,  we can go
+back to sleep for whatever is left of it. */
+
+static void _nap( const int ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)( ms % 1000) * 1000000L;
+    while( nanosleep( &ts, &ts) == -1 && errno == EINTR)
+        ;
+}
+#endif
+
 void PDC_napms(int ms)
 {
 #ifdef _WIN32
@@ -18,17 +36,18 @@ void PDC_napms(int ms)
 #else
 #ifndef DOS
 #ifdef LINUX_FRAMEBUFFER_PORT
-    PDC_check_for_blinking( );
     while( ms > 0)
     {
-        const int ms_to_nap = (ms > 50 ? 50 : ms);
+        const long until_blink = PDC_check_for_blinking( );
+        const int ms_to_nap = (until_blink >= 0 && ms > until_blink ?
+                                    (int)until_blink : ms);
 
-        usleep( 1000 * ms_to_nap);
+        _nap( ms_to_nap);
         ms -= ms_to_nap;
         PDC_check_for_blinking( );
     }
 #else
-    usleep(1000 * ms);
+    _nap( ms);
 #endif
 #endif
 #endif
@@ -23,3 +23,34 @@ extern int PDC_is_ansi;
 #define OSC "\x1b]"
 
 void PDC_puts_to_stdout( const char *buff);        /* pdcdisp.c */
+int PDC_get_terminal_fd( void);                    /* pdcdisp.c */
+void PDC_watch_input( const bool on);              /* pdckbd.c */
+
+#if !defined( _WIN32) && !defined( DOS)
+   #include <termios.h>
+#endif
+
+   /* State kept for each terminal (SCREEN) the VT port drives,  hung off
+   SP->port.  Allocated in PDC_scr_open( ),  freed in PDC_scr_free( ).
+   The Linux framebuffer port shares the parts it needs. */
+
+struct _pdc_port_state
+{
+   int out_fd;                /* where PDC_puts_to_stdout( ) writes */
+   char *tbuff;               /* output not yet written to out_fd */
+   size_t bytes_cached;
+   chtype prev_ch;            /* last cell sent,  for attribute changes */
+   bool force_reset_all_attribs;
+   uint32_t prev_fg, prev_bg; /* colors last sent,  or -2 */
+   int rows, cols;            /* terminal size */
+   mmask_t stored_trap_mbe;   /* mouse mask to restore after endwin( ) */
+   MOUSE_STATUS cached_mouse_status;
+   int held;                  /* mouse buttons down,  for X10 decoding */
+   int tracking_state;        /* xterm mouse mode now enabled,  or -1 */
+   bool sigio_active;         /* O_ASYNC set on our input (pdckbd.c) */
+   bool more_input;           /* select( ) again,  whatever SIGIO says */
+   int sigio_seen;            /* SIGIO count at our last select( ) */
+#if !defined( _WIN32) && !defined( DOS)
+   struct termios orig_term;
+#endif
+};
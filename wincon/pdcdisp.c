@@ -154,6 +154,14 @@ static void _set_ansi_color(short f, short b, attr_t attr)
    int PDC_expand_combined_characters( const cchar_t c, cchar_t *added);  /* addch.c */
 #endif
 
+/* Output is assembled in buffers of MAX_PACKET_LEN UTF-16 units.  A cell
+can take two (a surrogate pair),  and the last cell of a packet may also
+carry up to ten combining characters,  so _new_packet() hands on at most
+MAX_PACKET_CELLS cells at a time. */
+
+#define MAX_PACKET_LEN   512
+#define MAX_PACKET_CELLS ((MAX_PACKET_LEN - 12) / 2)
+
 #ifdef PDC_WIDE
 const chtype DUMMY_CHAR_NEXT_TO_FULLWIDTH = (chtype)MAX_UNICODE;
 #define IS_SUPPLEMENTAL_MULTILINGUAL_PLANE( c) ((c) & 0x1f0000)
@@ -297,7 +305,13 @@ static void _new_packet( attr_t attr, const int lineno,
     bool blink, ansi;
 
     assert( len >= 0);
-    assert( len < MAX_PACKET_LEN);
+    while (len > MAX_PACKET_CELLS)
+    {
+        _new_packet(attr, lineno, x, MAX_PACKET_CELLS, srcp);
+        x += MAX_PACKET_CELLS;
+        len -= MAX_PACKET_CELLS;
+        srcp += MAX_PACKET_CELLS;
+    }
     if (pdc_ansi && (lineno == (SP->lines - 1)) && ((x + len) == SP->cols))
     {
         len--;
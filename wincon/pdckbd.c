@@ -771,6 +771,36 @@ int PDC_get_key(void)
     return -1;
 }
 
+/* block until there's console input,  or for up to 'ms' milliseconds.
+   If text is blinking,  wake up in time for the next blink */
+
+void PDC_wait_for_input(int ms)
+{
+    DWORD timeout = (ms < 0 ? INFINITE : (DWORD)ms);
+
+    PDC_LOG(("PDC_wait_for_input() - called: ms=%d\n", ms));
+
+    PDC_napms(0);           /* blinks text,  if it's time to */
+    if (SP->termattrs & A_BLINK)
+    {
+        const DWORD since_blink = GetTickCount() - pdc_last_blink;
+        const DWORD until_blink = (since_blink >= 500 ? 0 : 500 - since_blink);
+
+        if (timeout > until_blink)
+            timeout = until_blink;
+    }
+    WaitForSingleObject(pdc_con_in, timeout);
+}
+
+/* no descriptor to watch for input on this platform */
+
+int PDC_get_input_fd(void)
+{
+    PDC_LOG(("PDC_get_input_fd() - called\n"));
+
+    return -1;
+}
+
 /* discard any pending keyboard or mouse input -- this is the core
    routine for flushinp() */
 
@@ -797,7 +827,7 @@ int PDC_mouse_set(void)
 
     GetConsoleMode(pdc_con_in, &mode);
     mode = (mode & 1) | 0x0088;
-    SetConsoleMode(pdc_con_in, mode | (SP->_trap_mbe ?
+    SetConsoleMode(pdc_con_in, mode | ((SP->_trap_mbe & ~PDC_MOUSE_COALESCE) ?
                    ENABLE_MOUSE_INPUT : pdc_quick_edit));
 
     memset(&old_mouse_status, 0, sizeof(old_mouse_status));
@@ -57,6 +57,29 @@ int PDC_get_key(void)
     return rval;
 }
 
+/* block until a message arrives for the window (blinking is driven
+   by WM_TIMER messages),  or for up to 'ms' milliseconds */
+
+void PDC_wait_for_input(int ms)
+{
+    extern bool PDC_bDone;
+
+    PDC_LOG(("PDC_wait_for_input() - called: ms=%d\n", ms));
+
+    if (!PDC_bDone)
+        MsgWaitForMultipleObjects(0, NULL, FALSE,
+                          (ms < 0 ? INFINITE : (DWORD)ms), QS_ALLINPUT);
+}
+
+/* no descriptor to watch for input on this platform */
+
+int PDC_get_input_fd(void)
+{
+    PDC_LOG(("PDC_get_input_fd() - called\n"));
+
+    return -1;
+}
+
 /* discard any pending keyboard or mouse input -- this is the core
    routine for flushinp() */
 
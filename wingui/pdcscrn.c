@@ -2249,7 +2249,8 @@ int PDC_scr_open(void)
     SP->audible = TRUE;
     SP->mono = FALSE;
     SP->termattrs = A_COLOR | WA_ITALIC | WA_UNDERLINE | WA_LEFT | WA_RIGHT |
-                    WA_REVERSE | WA_STRIKEOUT | WA_TOP | WA_BLINK | WA_DIM | WA_BOLD;
+                    WA_REVERSE | WA_STRIKEOUT | WA_TOP | WA_BLINK | WA_DIM | WA_BOLD |
+                    WA_DIRECT_COLOR;
 
 #ifdef NO_LONGER_AVAILABLE
             /* (Jan 2020 : the wmcbrine flavor lacks Xinitscr) */
@@ -4,6 +4,10 @@
 
 #include <string.h>
 
+#ifdef USE_XFT
+# include <X11/Xft/Xft.h>
+#endif
+
 #ifdef PDC_WIDE
    #define USE_UNICODE_ACS_CHARS 1
 #else
@@ -23,7 +27,202 @@ bool pdc_vertical_cursor = FALSE;
 static void _make_xy(int x, int y, int *xpos, int *ypos)
 {
     *xpos = x * pdc_fwidth;
-    *ypos = pdc_app_data.normalFont->ascent + (y * pdc_fheight);
+    *ypos = pdc_fascent + (y * pdc_fheight);
+}
+
+#ifdef USE_XFT
+/* With Xft,  text goes through the XRender extension:  each glyph is
+rasterized once (by FreeType,  antialiased),  uploaded to a glyph set on
+the server,  and from then on drawn by index,  many glyphs to a request
+(XRenderCompositeText32).  Since glyphs are 32-bit,  characters past the
+BMP work,  too.  Backgrounds,  lines and the cursor are still drawn with
+the core GCs,  into the same back buffer. */
+
+static XftFont *_xft_font[3];       /* normal,  italic,  bold */
+static XftDraw *_xft_draw;
+static XRectangle _xft_clip;
+static bool _xft_clip_set;
+
+/* Open the fonts named by the renderFont resource (an Xft/fontconfig
+   pattern such as "monospace-12"),  and set the cell size from the
+   normal one.  FALSE if there's no such font,  or none was asked for;
+   we then use the core fonts. */
+
+bool PDC_xft_open_fonts(const char *name)
+{
+    static const char *styles[3] = { "", ":slant=italic", ":weight=bold" };
+    Display *dpy = XtDisplay(pdc_toplevel);
+    char buff[256];
+    int i;
+
+    if (!name || !*name || strlen(name) >= sizeof(buff) - 20)
+        return FALSE;
+
+    for (i = 0; i < 3; i++)
+    {
+        strcpy(buff, name);
+        strcat(buff, styles[i]);
+        _xft_font[i] = XftFontOpenName(dpy, DefaultScreen(dpy), buff);
+        if (!_xft_font[0])
+            return FALSE;
+    }
+
+    pdc_fwidth = _xft_font[0]->max_advance_width;
+    pdc_fascent = _xft_font[0]->ascent;
+    pdc_fdescent = _xft_font[0]->descent;
+    pdc_fheight = pdc_fascent + pdc_fdescent;
+
+    return TRUE;
+}
+
+void PDC_xft_close_fonts(void)
+{
+    int i;
+
+    if (_xft_draw)
+    {
+        XftDrawDestroy(_xft_draw);
+        _xft_draw = NULL;
+    }
+    for (i = 0; i < 3; i++)
+        if (_xft_font[i])
+        {
+            XftFontClose(XtDisplay(pdc_toplevel), _xft_font[i]);
+            _xft_font[i] = NULL;
+        }
+}
+
+static void _xft_set_drawable(const Drawable drawable)
+{
+    if (!_xft_font[0])
+        return;
+    if (_xft_draw)
+        XftDrawChange(_xft_draw, drawable);
+    else
+        _xft_draw = XftDrawCreate(XCURSESDISPLAY, drawable,
+                                  DefaultVisualOfScreen(XtScreen(pdc_drawing)),
+                                  DefaultColormapOfScreen(XtScreen(pdc_drawing)));
+    _xft_clip_set = FALSE;
+}
+#endif
+
+/* Everything is drawn into an off-screen Pixmap,  the same size as the
+window.  The part of it changed since the last time is copied to the
+window by PDC_flush_backbuf() (called from PDC_doupdate(),  the blink
+timers and before waiting for input),  and Expose events are handled by
+copying the exposed rectangle,  rather than by redrawing the screen. If
+the Pixmap can't be had,  we draw straight to the window as before. */
+
+static Pixmap _backbuf;
+static GC _copy_gc;
+static int _backbuf_width, _backbuf_height;
+static int _dirty_x1, _dirty_y1, _dirty_x2 = -1, _dirty_y2;
+
+static Drawable _target(void)
+{
+    return (_backbuf ? _backbuf : XCURSESWIN);
+}
+
+static void _mark_dirty(const int x, const int y, const int width,
+                        const int height)
+{
+    if (_dirty_x2 < 0)
+    {
+        _dirty_x1 = x;
+        _dirty_y1 = y;
+        _dirty_x2 = x + width;
+        _dirty_y2 = y + height;
+    }
+    else
+    {
+        _dirty_x1 = min(_dirty_x1, x);
+        _dirty_y1 = min(_dirty_y1, y);
+        _dirty_x2 = max(_dirty_x2, x + width);
+        _dirty_y2 = max(_dirty_y2, y + height);
+    }
+}
+
+/* (re)create the back buffer at the current window size,  keeping what
+   was already drawn */
+
+void PDC_size_backbuf(void)
+{
+    Display *dpy = XCURSESDISPLAY;
+    Pixmap new_buf;
+
+    if (_backbuf && _backbuf_width == pdc_wwidth
+                 && _backbuf_height == pdc_wheight)
+        return;
+
+    new_buf = XCreatePixmap(dpy, XCURSESWIN, pdc_wwidth, pdc_wheight,
+                            DefaultDepthOfScreen(XtScreen(pdc_drawing)));
+    if (!_copy_gc)
+    {
+        XGCValues values;
+
+        values.graphics_exposures = False;
+        _copy_gc = XCreateGC(dpy, new_buf, GCGraphicsExposures, &values);
+    }
+    XSetForeground(dpy, _copy_gc, BlackPixelOfScreen(XtScreen(pdc_drawing)));
+    XFillRectangle(dpy, new_buf, _copy_gc, 0, 0, pdc_wwidth, pdc_wheight);
+    if (_backbuf)
+    {
+        XCopyArea(dpy, _backbuf, new_buf, _copy_gc, 0, 0,
+                  min(_backbuf_width, pdc_wwidth),
+                  min(_backbuf_height, pdc_wheight), 0, 0);
+        XFreePixmap(dpy, _backbuf);
+    }
+    _backbuf = new_buf;
+    _backbuf_width = pdc_wwidth;
+    _backbuf_height = pdc_wheight;
+#ifdef USE_XFT
+    _xft_set_drawable(_backbuf);
+#endif
+}
+
+void PDC_free_backbuf(void)
+{
+#ifdef USE_XFT
+    if (_xft_draw)
+    {
+        XftDrawDestroy(_xft_draw);
+        _xft_draw = NULL;
+    }
+#endif
+    if (_backbuf)
+    {
+        XFreePixmap(XCURSESDISPLAY, _backbuf);
+        _backbuf = 0;
+    }
+    if (_copy_gc)
+    {
+        XFreeGC(XCURSESDISPLAY, _copy_gc);
+        _copy_gc = NULL;
+    }
+    _dirty_x2 = -1;
+}
+
+/* copy part of the back buffer to the window;  FALSE if there's no
+   back buffer */
+
+bool PDC_copy_backbuf(const int x, const int y, const int width,
+                      const int height)
+{
+    if (!_backbuf)
+        return FALSE;
+    XCopyArea(XCURSESDISPLAY, _backbuf, XCURSESWIN, _copy_gc,
+              x, y, width, height, x, y);
+    return TRUE;
+}
+
+void PDC_flush_backbuf(void)
+{
+    if (_dirty_x2 >= 0)
+    {
+        PDC_copy_backbuf(_dirty_x1, _dirty_y1, _dirty_x2 - _dirty_x1,
+                         _dirty_y2 - _dirty_y1);
+        _dirty_x2 = -1;
+    }
 }
 
 static void _set_cursor_color(chtype *ch, int *fore, int *back)
@@ -93,9 +292,9 @@ static void _display_cursor(int old_row, int old_x, int new_row, int new_x)
         XSetForeground(XCURSESDISPLAY, pdc_cursor_gc, PDC_get_pixel( back));
 
         for (i = 1; i <= SP->visibility; i++)
-            XDrawLine(XCURSESDISPLAY, XCURSESWIN, pdc_cursor_gc,
-                      xpos + i, ypos - pdc_app_data.normalFont->ascent,
-                      xpos + i, ypos - pdc_app_data.normalFont->ascent +
+            XDrawLine(XCURSESDISPLAY, _target(), pdc_cursor_gc,
+                      xpos + i, ypos - pdc_fascent,
+                      xpos + i, ypos - pdc_fascent +
                       pdc_fheight - 1);
     }
     else
@@ -116,10 +315,12 @@ static void _display_cursor(int old_row, int old_x, int new_row, int new_x)
         }
 
         XSetFunction(XCURSESDISPLAY, pdc_cursor_gc, GXinvert);
-        XFillRectangle(XCURSESDISPLAY, XCURSESWIN, pdc_cursor_gc,
+        XFillRectangle(XCURSESDISPLAY, _target(), pdc_cursor_gc,
             xpos, yp, pdc_fwidth, yh);
     }
 
+    _mark_dirty(xpos, ypos - pdc_fascent, pdc_fwidth, pdc_fheight);
+
     PDC_LOG(("_display_cursor() - draw cursor at row %d col %d\n",
              new_row, new_x));
 }
@@ -129,42 +330,51 @@ void PDC_redraw_cursor(void)
     _display_cursor(SP->cursrow, SP->curscol, SP->cursrow, SP->curscol);
 }
 
+/* Xt can't tell us when its next timeout will fire,  so the blink timers
+are added through here,  noting when each is due.  PDC_wait_for_input()
+won't sleep past that.  pdc_blink_due[0] is for the cursor,  [1] for
+text;  zero means no timer is pending. */
+
+long pdc_blink_due[2];
+
+void PDC_add_blink_timeout(const bool text)
+{
+    const int rate = (text ? pdc_app_data.textBlinkRate :
+                             pdc_app_data.cursorBlinkRate);
+
+    XtAppAddTimeOut(pdc_app_context, rate,
+                    (text ? PDC_blink_text : PDC_blink_cursor), NULL);
+    pdc_blink_due[text ? 1 : 0] = PDC_millisecs() + rate;
+}
+
+/* Only rows that refresh.c has flagged as holding blinking text are
+   redrawn. Once there are none, the timeout isn't renewed, so an idle
+   screen gets no wakeups; PDC_doupdate() restarts it when blinking
+   text is next sent. */
+
 void PDC_blink_text(XtPointer unused, XtIntervalId *id)
 {
-    int row;
-    int j, k;
-    chtype *ch;
+    int n_rows;
 
     INTENTIONALLY_UNUSED_PARAMETER( unused);
     INTENTIONALLY_UNUSED_PARAMETER( id);
     PDC_LOG(("PDC_blink_text() - called:\n"));
 
+    pdc_blink_due[1] = 0;
     PDC_blink_state = pdc_blinked_off = !pdc_blinked_off;
 
-    /* Redraw changed lines on the screen to match the blink state */
-
-    for (row = 0; row < SP->lines; row++)
-    {
-        ch = curscr->_y[row];
+    /* Redraw blinking text on the screen to match the blink state */
 
-        for (j = 0; j < COLS; j++)
-            if (ch[j] & A_BLINK)
-            {
-                k = j;
-                while (ch[k] & A_BLINK && k < COLS)
-                    k++;
+    n_rows = PDC_redraw_blinking_text();
 
-                PDC_transform_line(row, j, k - j, ch + j);
+    if (curscr->_y[SP->cursrow][SP->curscol] & A_BLINK)
+        PDC_redraw_cursor();
+    PDC_flush_backbuf();
 
-                j = k;
-            }
-    }
-
-    PDC_redraw_cursor();
-
-    if ((SP->termattrs & A_BLINK) || !pdc_blinked_off)
-        XtAppAddTimeOut(pdc_app_context, pdc_app_data.textBlinkRate,
-                        PDC_blink_text, NULL);
+    if (!n_rows)
+        PDC_blink_state = pdc_blinked_off = FALSE;
+    else if (SP->termattrs & A_BLINK)
+        PDC_add_blink_timeout(TRUE);
 }
 
 static void _toggle_cursor(void)
@@ -220,9 +430,16 @@ void PDC_blink_cursor(XtPointer unused, XtIntervalId *id)
 
     INTENTIONALLY_UNUSED_PARAMETER( unused);
     INTENTIONALLY_UNUSED_PARAMETER( id);
+    /* An invisible cursor has nothing to blink; PDC_curs_set()
+       restarts the timeout when it's made visible again */
+
+    pdc_blink_due[0] = 0;
+    if (!SP->visibility)
+        return;
+
     _toggle_cursor();
-    XtAppAddTimeOut(pdc_app_context, pdc_app_data.cursorBlinkRate,
-                    PDC_blink_cursor, NULL);
+    PDC_flush_backbuf();
+    PDC_add_blink_timeout(FALSE);
 }
 
 /* position hardware cursor at (y, x) */
@@ -236,145 +453,198 @@ void PDC_gotoyx(int row, int col)
 
 #define reverse_bytes( rgb) ((rgb >> 16) | (rgb & 0xff00) | ((rgb & 0xff) << 16))
 
-/* update the given physical line to look like the corresponding line in
-   curscr */
-
-/* Output a block of characters with common attributes */
-
-static int _new_packet(const chtype attr, const int len, const int col, const int row,
 #ifdef PDC_WIDE
-                       const XChar2b *text)
+   typedef XChar2b TEXT_CHAR;
+   typedef XTextItem16 TEXT_ITEM;
+   #define XDRAWTEXT  XDrawText16
+   #define XTEXTWIDTH XTextWidth16
 #else
-                       const char *text)
+   typedef char TEXT_CHAR;
+   typedef XTextItem TEXT_ITEM;
+   #define XDRAWTEXT  XDrawText
+   #define XTEXTWIDTH XTextWidth
 #endif
+
+/* The foreground and clip rectangle last set for each of the text GCs
+(normal, italic, bold),  so that we only send changes.  Over a slow or
+remote link,  the XSetForeground/XSetClipRectangles requests for every
+attribute run used to outnumber the drawing requests. */
+
+static struct
 {
-    XRectangle bounds;
     GC gc;
-    int xpos, ypos;
-    PACKED_RGB fore_rgb, back_rgb;
-    attr_t sysattrs;
-
-    PDC_get_rgb_values( attr, &fore_rgb, &back_rgb);
-    fore_rgb = reverse_bytes( fore_rgb);
-    back_rgb = reverse_bytes( back_rgb);
+    XFontStruct *font;
+    Pixel fore;
+    XRectangle clip;
+    bool fore_set, clip_set;
+} _text_gc[3];
 
-    /* Specify the color table offsets */
+/* called by PDC_scr_open() whenever the GCs are (re)created */
 
-    sysattrs = SP->termattrs;
+void PDC_init_text_gcs(XFontStruct *italic_font, XFontStruct *bold_font)
+{
+    memset(_text_gc, 0, sizeof(_text_gc));
+    _text_gc[0].gc = pdc_normal_gc;
+    _text_gc[0].font = pdc_app_data.normalFont;
+    _text_gc[1].gc = pdc_italic_gc;
+    _text_gc[1].font = italic_font;
+    _text_gc[2].gc = pdc_bold_gc;
+    _text_gc[2].font = bold_font;
+}
 
-    /* Determine which GC to use - normal, italic or bold */
+static GC _set_gc(const int idx, const Pixel fore, const XRectangle *clip)
+{
+    if (!_text_gc[idx].fore_set || _text_gc[idx].fore != fore)
+    {
+        XSetForeground(XCURSESDISPLAY, _text_gc[idx].gc, fore);
+        _text_gc[idx].fore = fore;
+        _text_gc[idx].fore_set = TRUE;
+    }
 
-    if ((attr & A_ITALIC) && (sysattrs & A_ITALIC))
-        gc = pdc_italic_gc;
-    else if ((attr & A_BOLD) && (sysattrs & A_BOLD))
-        gc = pdc_bold_gc;
-    else
-        gc = pdc_normal_gc;
+    if (!_text_gc[idx].clip_set || memcmp(&_text_gc[idx].clip, clip,
+                                          sizeof(XRectangle)))
+    {
+        XSetClipRectangles(XCURSESDISPLAY, _text_gc[idx].gc, 0, 0,
+                           (XRectangle *)clip, 1, Unsorted);
+        _text_gc[idx].clip = *clip;
+        _text_gc[idx].clip_set = TRUE;
+    }
 
-    _make_xy(col, row, &xpos, &ypos);
+    return _text_gc[idx].gc;
+}
 
-    bounds.x = xpos;
-    bounds.y = ypos - pdc_fascent;
-    bounds.width = pdc_fwidth * len;
-    bounds.height = pdc_fheight;
+/* A run of cells with common attributes */
 
-    XSetClipRectangles(XCURSESDISPLAY, gc, 0, 0, &bounds, 1, Unsorted);
+typedef struct
+{
+    int offset, len;       /* in cells,  from the start of the span */
+    int gc;                /* index into _text_gc[] */
+    Pixel fore, back;
+    chtype attr;
+    bool blank;            /* nothing but spaces */
+    bool hidden;           /* blinked off */
+    bool done;
+} PACKET;
 
-    if (pdc_blinked_off && (sysattrs & A_BLINK) && (attr & A_BLINK))
-    {
-        XSetForeground(XCURSESDISPLAY, gc, (Pixel)fore_rgb);
-        XFillRectangle(XCURSESDISPLAY, XCURSESWIN, gc, xpos, bounds.y,
-                       bounds.width, pdc_fheight);
-    }
-    else
-    {
-        /* Draw it */
+#define MAX_PACKET_SIZE 128
+#define MAX_SPAN_SIZE   256
 
-        XSetForeground(XCURSESDISPLAY, gc, (Pixel)fore_rgb);
-        XSetBackground(XCURSESDISPLAY, gc, (Pixel)back_rgb);
+#ifdef USE_XFT
 
-#ifdef PDC_WIDE
-        XDrawImageString16(
-#else
-        XDrawImageString(
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+   int PDC_expand_combined_characters( const cchar_t c, cchar_t *added);  /* addch.c */
 #endif
-            XCURSESDISPLAY, XCURSESWIN, gc, xpos, ypos, text, len);
 
-        /* Underline, etc. */
+#define MAX_XFT_GLYPHS      (MAX_SPAN_SIZE * 2)
+#define MAX_GLYPHS_PER_CELL 12      /* a character and its combining marks */
 
-        if (attr & (WA_LEFT | WA_RIGHT | WA_UNDERLINE | WA_TOP | WA_STRIKEOUT))
-        {
-            int k;
-            const int xend = xpos + pdc_fwidth * len;
-
-            if (SP->line_color != -1)
-                XSetForeground(XCURSESDISPLAY, gc, PDC_get_pixel( SP->line_color));
-
-            if (attr & WA_UNDERLINE)
-                XDrawLine(XCURSESDISPLAY, XCURSESWIN, gc,
-                          xpos, ypos + 1, xend, ypos + 1);
+/* Xft counterpart to the text pass in _draw_span():  one request per
+   foreground color,  each glyph placed at its own cell (so the bold and
+   italic fonts needn't have quite the same advance as the normal one). */
 
-            if (attr & WA_TOP)
-                XDrawLine(XCURSESDISPLAY, XCURSESWIN, gc,
-                          xpos, ypos - pdc_fascent, xend,  ypos - pdc_fascent);
+static void _xft_draw_text(PACKET *packets, const int n_packets,
+                           const FcChar32 *ucs, const int xpos,
+                           const int ypos, const XRectangle *clip)
+{
+    XftCharFontSpec specs[MAX_XFT_GLYPHS];
+    int i, j, k;
 
-            if (attr & WA_STRIKEOUT)
-                XDrawLine(XCURSESDISPLAY, XCURSESWIN, gc,
-                          xpos, ypos - pdc_fascent / 2, xend,
-                                ypos - pdc_fascent / 2);
+    if (!_xft_clip_set || memcmp(&_xft_clip, clip, sizeof(XRectangle)))
+    {
+        XftDrawSetClipRectangles(_xft_draw, 0, 0, clip, 1);
+        _xft_clip = *clip;
+        _xft_clip_set = TRUE;
+    }
 
-            if (attr & WA_LEFT)
-                for (k = 0; k < len; k++)
+    for (i = 0; i < n_packets; i++)
+        if (!packets[i].done)
+        {
+            const Pixel fore = packets[i].fore;
+            XftColor color;
+            int n_specs = 0;
+
+            color.pixel = fore;
+            color.color.red =   (unsigned short)(((fore >> 16) & 0xff) * 0x101);
+            color.color.green = (unsigned short)(((fore >> 8) & 0xff) * 0x101);
+            color.color.blue =  (unsigned short)((fore & 0xff) * 0x101);
+            color.color.alpha = 0xffff;
+
+            for (j = i; j < n_packets; j++)
+                if (!packets[j].done && packets[j].fore == fore)
                 {
-                    int x = xpos + pdc_fwidth * k;
-                    XDrawLine(XCURSESDISPLAY, XCURSESWIN, gc,
-                              x, ypos - pdc_fascent, x, ypos + pdc_fdescent);
+                    XftFont *font = _xft_font[packets[j].gc];
+
+                    if (!font)
+                        font = _xft_font[0];
+                    for (k = packets[j].offset; k < packets[j].offset
+                                                    + packets[j].len; k++)
+                    {
+                        FcChar32 c = ucs[k];
+                        const short gx = (short)(xpos + pdc_fwidth * k);
+
+                        if (c == ' ' || c == MAX_UNICODE)
+                            continue;      /* right half of fullwidth char */
+                        if (n_specs > MAX_XFT_GLYPHS - MAX_GLYPHS_PER_CELL)
+                        {
+                            XftDrawCharFontSpec(_xft_draw, &color, specs,
+                                                n_specs);
+                            n_specs = 0;
+                        }
+#ifdef USING_COMBINING_CHARACTER_SCHEME
+                        while (c > MAX_UNICODE && n_specs < MAX_XFT_GLYPHS - 1)
+                        {
+                            cchar_t added;
+
+                            c = (FcChar32)PDC_expand_combined_characters(c,
+                                                                   &added);
+                            specs[n_specs].font = font;
+                            specs[n_specs].ucs4 = (FcChar32)added;
+                            specs[n_specs].x = gx;
+                            specs[n_specs++].y = (short)ypos;
+                        }
+#endif
+                        specs[n_specs].font = font;
+                        specs[n_specs].ucs4 = (c > MAX_UNICODE ? ' ' : c);
+                        specs[n_specs].x = gx;
+                        specs[n_specs++].y = (short)ypos;
+                    }
+                    packets[j].done = TRUE;
                 }
 
-            if (attr & WA_RIGHT)
-                for (k = 0; k < len; k++)
-                {
-                    int x = xpos + pdc_fwidth * (k + 1) - 1;
-                    XDrawLine(XCURSESDISPLAY, XCURSESWIN, gc,
-                              x, ypos - pdc_fascent, x, ypos + pdc_fdescent);
-                }
+            if (n_specs)
+                XftDrawCharFontSpec(_xft_draw, &color, specs, n_specs);
         }
-    }
-
-    PDC_LOG(("_new_packet() - row: %d col: %d "
-             "num_cols: %d fore: %x back: %x text:<%s>\n",
-             row, col, len, fore_rgb, back_rgb, text));
-
-    return OK;
 }
+#endif
 
-/* The core display routine -- update one line of text */
-
-#define MAX_PACKET_SIZE 128
+/* Draw up to MAX_SPAN_SIZE cells.  The runs are drawn in three passes --
+backgrounds,  then text,  then lines -- and within each pass,  runs that
+need the same GC state are drawn together with one XFillRectangles(),
+XDrawText() or XDrawSegments() request.  Everything is clipped to the
+span,  so glyphs from bold or italic fonts can't spill over into cells
+that we weren't asked to update. */
 
-void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
+static void _draw_span(const int lineno, const int x, const int len,
+                       const chtype *srcp)
 {
-#ifdef PDC_WIDE
-    XChar2b text[MAX_PACKET_SIZE];
-#else
-    char text[MAX_PACKET_SIZE];
+    TEXT_CHAR text[MAX_SPAN_SIZE];
+#ifdef USE_XFT
+    FcChar32 ucs[MAX_SPAN_SIZE];
 #endif
-    chtype old_attr, attr;
-    int i, j;
-
-    PDC_LOG(("PDC_transform_line() - called: lineno: %d x: %d "
-             "len: %d\n", lineno, x, len));
-
-    if (!len)
-        return;
+    PACKET packets[MAX_SPAN_SIZE];
+    XRectangle clip, rects[MAX_SPAN_SIZE];
+    TEXT_ITEM items[MAX_SPAN_SIZE];
+    XSegment segs[3 + 2 * MAX_PACKET_SIZE];
+    const attr_t sysattrs = SP->termattrs;
+    chtype old_attr = 0;
+    int i, j, n_packets = 0, xpos, ypos;
 
-    old_attr = *srcp & A_ATTRIBUTES;
+    /* Split the span into runs,  converting the text as we go */
 
-    for (i = 0, j = 0; j < len; j++)
+    for (i = 0; i < len; i++)
     {
-        chtype curr = srcp[j];
-
-        attr = curr & A_ATTRIBUTES;
+        chtype curr = srcp[i];
+        chtype attr = curr & (A_ATTRIBUTES | A_DIRECT_COLOR);
 
         if( _is_altcharset( curr))
         {
@@ -391,28 +661,229 @@ void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
             attr ^= A_REVERSE;
         }
 #endif
-        if (attr != old_attr || i == MAX_PACKET_SIZE - 1)
+        if (!n_packets || attr != old_attr
+                       || packets[n_packets - 1].len == MAX_PACKET_SIZE)
         {
-            if (_new_packet(old_attr, i, x, lineno, text) == ERR)
-                return;
+            PACKET *pptr = packets + n_packets++;
 
-            old_attr = attr;
-            x += i;
-            i = 0;
+            pptr->offset = i;
+            pptr->len = 0;
+            pptr->attr = old_attr = attr;
+            pptr->blank = TRUE;
+            pptr->done = FALSE;
         }
 
+        packets[n_packets - 1].len++;
+        if ((curr & A_CHARTEXT) != ' ')
+            packets[n_packets - 1].blank = FALSE;
 #ifdef PDC_WIDE
         text[i].byte1 = (curr & 0xff00) >> 8;
-        text[i++].byte2 = curr & 0x00ff;
+        text[i].byte2 = curr & 0x00ff;
 #else
-        text[i++] = curr & 0xff;
+        text[i] = curr & 0xff;
+#endif
+#ifdef USE_XFT
+        ucs[i] = (FcChar32)(curr & A_CHARTEXT);
+#endif
+    }
+
+    for (i = 0; i < n_packets; i++)
+    {
+        PACKET *pptr = packets + i;
+        const chtype attr = pptr->attr;
+        PACKED_RGB fore_rgb, back_rgb;
+
+        PDC_get_rgb_values( attr, &fore_rgb, &back_rgb);
+        pptr->fore = (Pixel)reverse_bytes( fore_rgb);
+        pptr->back = (Pixel)reverse_bytes( back_rgb);
+
+        /* Determine which GC to use - normal, italic or bold */
+
+        if ((attr & A_ITALIC) && (sysattrs & A_ITALIC))
+            pptr->gc = 1;
+        else if ((attr & A_BOLD) && (sysattrs & A_BOLD))
+            pptr->gc = 2;
+        else
+            pptr->gc = 0;
+
+        pptr->hidden = (pdc_blinked_off && (sysattrs & A_BLINK)
+                                        && (attr & A_BLINK));
+        if (pptr->hidden)     /* blinked-off text is painted over */
+        {
+            pptr->back = pptr->fore;
+            pptr->blank = TRUE;
+        }
+    }
+
+    _make_xy(x, lineno, &xpos, &ypos);
+
+    clip.x = xpos;
+    clip.y = ypos - pdc_fascent;
+    clip.width = pdc_fwidth * len;
+    clip.height = pdc_fheight;
+
+    /* Backgrounds,  one request per color.  Neighbouring runs of the
+       same color are merged into one rectangle. */
+
+    for (i = 0; i < n_packets; i++)
+        if (!packets[i].done)
+        {
+            const Pixel back = packets[i].back;
+            int n_rects = 0;
+
+            for (j = i; j < n_packets; j++)
+                if (packets[j].back == back)
+                {
+                    const int rx = xpos + pdc_fwidth * packets[j].offset;
+                    const int rwidth = pdc_fwidth * packets[j].len;
+
+                    if (n_rects && rects[n_rects - 1].x +
+                                   rects[n_rects - 1].width == rx)
+                        rects[n_rects - 1].width += rwidth;
+                    else
+                    {
+                        rects[n_rects].x = rx;
+                        rects[n_rects].y = clip.y;
+                        rects[n_rects].width = rwidth;
+                        rects[n_rects].height = pdc_fheight;
+                        n_rects++;
+                    }
+                    packets[j].done = TRUE;
+                }
+
+            XFillRectangles(XCURSESDISPLAY, _target(),
+                            _set_gc(0, back, &clip), rects, n_rects);
+        }
+
+    /* Text,  one request per GC and foreground color.  Spaces are
+       already drawn. */
+
+    for (i = 0; i < n_packets; i++)
+        packets[i].done = packets[i].blank;
+
+#ifdef USE_XFT
+    if (_xft_draw)
+        _xft_draw_text(packets, n_packets, ucs, xpos, ypos, &clip);
 #endif
+    for (i = 0; i < n_packets; i++)
+        if (!packets[i].done)
+        {
+            const int gc = packets[i].gc;
+            const Pixel fore = packets[i].fore;
+            const int x0 = xpos + pdc_fwidth * packets[i].offset;
+            int n_items = 0, pen = x0;
+
+            for (j = i; j < n_packets; j++)
+                if (!packets[j].done && packets[j].gc == gc
+                                     && packets[j].fore == fore)
+                {
+                    TEXT_ITEM *item = items + n_items++;
+                    TEXT_CHAR *chars = text + packets[j].offset;
+                    const int tx = xpos + pdc_fwidth * packets[j].offset;
+
+                    item->chars = chars;
+                    item->nchars = packets[j].len;
+                    item->delta = tx - pen;
+                    item->font = None;
+                    pen = tx + XTEXTWIDTH(_text_gc[gc].font, chars,
+                                          packets[j].len);
+                    packets[j].done = TRUE;
+                }
+
+            XDRAWTEXT(XCURSESDISPLAY, _target(), _set_gc(gc, fore, &clip),
+                      x0, ypos, items, n_items);
+        }
+
+    /* Underline, etc. */
+
+    for (i = 0; i < n_packets; i++)
+    {
+        const PACKET *pptr = packets + i;
+        const chtype attr = pptr->attr;
+
+        if (!pptr->hidden && (attr & (WA_LEFT | WA_RIGHT | WA_UNDERLINE
+                                      | WA_TOP | WA_STRIKEOUT)))
+        {
+            const int x1 = xpos + pdc_fwidth * pptr->offset;
+            const int xend = x1 + pdc_fwidth * pptr->len;
+            const Pixel color = (SP->line_color != -1 ?
+                                 PDC_get_pixel( SP->line_color) : pptr->fore);
+            int k, n_segs = 0;
+
+#define ADD_SEG( X1, Y1, X2, Y2) { segs[n_segs].x1 = (short)(X1); \
+                                   segs[n_segs].y1 = (short)(Y1); \
+                                   segs[n_segs].x2 = (short)(X2); \
+                                   segs[n_segs++].y2 = (short)(Y2); }
+
+            if (attr & WA_UNDERLINE)
+                ADD_SEG( x1, ypos + 1, xend, ypos + 1);
+
+            if (attr & WA_TOP)
+                ADD_SEG( x1, ypos - pdc_fascent, xend, ypos - pdc_fascent);
+
+            if (attr & WA_STRIKEOUT)
+                ADD_SEG( x1, ypos - pdc_fascent / 2, xend,
+                             ypos - pdc_fascent / 2);
+
+            if (attr & WA_LEFT)
+                for (k = 0; k < pptr->len; k++)
+                {
+                    const int lx = x1 + pdc_fwidth * k;
+
+                    ADD_SEG( lx, ypos - pdc_fascent, lx, ypos + pdc_fdescent);
+                }
+
+            if (attr & WA_RIGHT)
+                for (k = 0; k < pptr->len; k++)
+                {
+                    const int rx = x1 + pdc_fwidth * (k + 1) - 1;
+
+                    ADD_SEG( rx, ypos - pdc_fascent, rx, ypos + pdc_fdescent);
+                }
+#undef ADD_SEG
+
+            XDrawSegments(XCURSESDISPLAY, _target(),
+                          _set_gc(pptr->gc, color, &clip), segs, n_segs);
+        }
     }
 
-    _new_packet(old_attr, i, x, lineno, text);
+    _mark_dirty(clip.x, clip.y, clip.width, clip.height);
+
+    PDC_LOG(("_draw_span() - row: %d col: %d num_cols: %d runs: %d\n",
+             lineno, x, len, n_packets));
+}
+
+/* The core display routine -- update one line of text */
+
+void PDC_transform_line(int lineno, int x, int len, const chtype *srcp)
+{
+    PDC_LOG(("PDC_transform_line() - called: lineno: %d x: %d "
+             "len: %d\n", lineno, x, len));
+
+    while (len > 0)
+    {
+        const int n = (len > MAX_SPAN_SIZE ? MAX_SPAN_SIZE : len);
+
+        _draw_span(lineno, x, n, srcp);
+        x += n;
+        srcp += n;
+        len -= n;
+    }
 }
 
+/* Drawing requests are only buffered;  this copies the changes from the
+back buffer and sends them off without waiting for the server to process
+them,  unless the syncUpdates resource asks for the old behavior of a
+round trip per update. */
+
 void PDC_doupdate(void)
 {
-    XSync(XtDisplay(pdc_toplevel), False);
+    if (!pdc_blink_due[1] && (SP->termattrs & A_BLINK) && SP->n_blink_rows)
+        PDC_add_blink_timeout(TRUE);
+
+    PDC_flush_backbuf();
+    if (pdc_app_data.syncUpdates)
+        XSync(XtDisplay(pdc_toplevel), False);
+    else
+        XFlush(XtDisplay(pdc_toplevel));
 }
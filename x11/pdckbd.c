@@ -6,6 +6,10 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#ifdef HAVE_POLL
+# include <poll.h>
+#endif
+
 #ifdef HAVE_DECKEYSYM_H
 # include <DECkeysym.h>
 #endif
@@ -672,6 +676,52 @@ void PDC_set_keyboard_binary(bool on)
     INTENTIONALLY_UNUSED_PARAMETER( on);
 }
 
+/* block until there's something to read from the X server,  or for up
+   to 'ms' milliseconds.  Xt can't tell us when its next timeout is due,
+   so we don't sleep past the blink timers (see PDC_add_blink_timeout()) */
+
+void PDC_wait_for_input(int ms)
+{
+#ifdef HAVE_POLL
+    struct pollfd fd;
+    const long now = PDC_millisecs();
+    int i;
+
+    PDC_LOG(("PDC_wait_for_input() - called: ms=%d\n", ms));
+
+    PDC_flush_backbuf();
+    if (XtAppPending(pdc_app_context))
+        return;
+    for (i = 0; i < 2; i++)
+        if (pdc_blink_due[i])
+        {
+            const long until_due = pdc_blink_due[i] - now;
+
+            if (until_due <= 0)
+                return;
+            if (ms < 0 || ms > until_due)
+                ms = (int)until_due;
+        }
+    fd.fd = ConnectionNumber(XtDisplay(pdc_toplevel));
+    fd.events = POLLIN;
+    poll(&fd, 1, ms);
+#else
+    PDC_LOG(("PDC_wait_for_input() - called: ms=%d\n", ms));
+
+    PDC_flush_backbuf();
+    PDC_napms((ms < 0 || ms > 50) ? 50 : ms);
+#endif
+}
+
+/* the connection to the X server;  PDC_check_key() reads from it */
+
+int PDC_get_input_fd(void)
+{
+    PDC_LOG(("PDC_get_input_fd() - called\n"));
+
+    return (pdc_toplevel ? ConnectionNumber(XtDisplay(pdc_toplevel)) : -1);
+}
+
 /* discard any pending keyboard or mouse input -- this is the core
    routine for flushinp() */
 
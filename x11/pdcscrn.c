@@ -24,6 +24,10 @@
 # define DEFBFONT "-misc-fixed-bold-r-normal--13-120-75-75-c-70-iso8859-1"
 #endif
 
+#ifdef USE_XFT
+# define DEFRFONT "monospace-12"
+#endif
+
 #ifndef MAX_PATH
 # define MAX_PATH 256
 #endif
@@ -106,7 +110,11 @@ static XtResource app_resources[] =
     RINT(cursorBlinkRate, CursorBlinkRate, 0),
 
     RSTRING(textCursor, TextCursor),
-    RINT(textBlinkRate, TextBlinkRate, 500)
+    RINT(textBlinkRate, TextBlinkRate, 500),
+    RINT(syncUpdates, SyncUpdates, 0),
+#ifdef USE_XFT
+    RSTRINGP(renderFont, RenderFont, DEFRFONT),
+#endif
 };
 
 #undef RCURSOR
@@ -119,6 +127,9 @@ static XtResource app_resources[] =
 #undef DEFBFONT
 #undef DEFIFONT
 #undef DEFNFONT
+#ifdef USE_XFT
+# undef DEFRFONT
+#endif
 
 /* Macros for options */
 
@@ -132,6 +143,10 @@ static XrmOptionDescRec options[] =
     COPT(clickPeriod), COPT(doubleClickPeriod), COPT(scrollbarWidth),
     COPT(pointerForeColor), COPT(pointerBackColor),
     COPT(cursorBlinkRate), COPT(textCursor), COPT(textBlinkRate),
+    COPT(syncUpdates),
+#ifdef USE_XFT
+    COPT(renderFont),
+#endif
 
     CCOLOR(Black), CCOLOR(Red), CCOLOR(Green), CCOLOR(Yellow),
     CCOLOR(Blue), CCOLOR(Magenta), CCOLOR(Cyan), CCOLOR(White),
@@ -192,6 +207,10 @@ void PDC_scr_free(void)
         icon_pixmap_mask = 0;
     }
 
+    PDC_free_backbuf();
+#ifdef USE_XFT
+    PDC_xft_close_fonts();
+#endif
     if( pdc_normal_gc)
     {
         XFreeGC(XCURSESDISPLAY, pdc_normal_gc);
@@ -344,7 +363,18 @@ static void _handle_expose(Widget w, XtPointer client_data, XEvent *event,
     INTENTIONALLY_UNUSED_PARAMETER( w);
     INTENTIONALLY_UNUSED_PARAMETER( client_data);
     INTENTIONALLY_UNUSED_PARAMETER( unused);
-    /* ignore all Exposes except last */
+
+    /* with a back buffer,  just copy each exposed rectangle from it */
+
+    if (received_map_notify && PDC_copy_backbuf(event->xexpose.x,
+             event->xexpose.y, event->xexpose.width, event->xexpose.height))
+    {
+        if (!event->xexpose.count)
+            exposed = TRUE;
+        return;
+    }
+
+    /* otherwise,  ignore all Exposes except last */
 
     if (event->xexpose.count)
         return;
@@ -505,7 +535,7 @@ void PDC_set_args(int c, char **v)
 
 int PDC_scr_open(void)
 {
-    bool italic_font_valid, bold_font_valid;
+    XFontStruct *italic_font, *bold_font;
     int minwidth, minheight;
 
     PDC_LOG(("PDC_scr_open() - called\n"));
@@ -542,11 +572,17 @@ int PDC_scr_open(void)
 
     /* Check that the italic font and normal fonts are the same size */
 
-    italic_font_valid = pdc_fwidth ==
-        pdc_app_data.italicFont->max_bounds.width;
+    italic_font = (pdc_fwidth == pdc_app_data.italicFont->max_bounds.width ?
+                   pdc_app_data.italicFont : pdc_app_data.normalFont);
+
+    bold_font = (pdc_fwidth == pdc_app_data.boldFont->max_bounds.width ?
+                 pdc_app_data.boldFont : pdc_app_data.normalFont);
 
-    bold_font_valid = pdc_fwidth ==
-        pdc_app_data.boldFont->max_bounds.width;
+#ifdef USE_XFT
+    /* If the Xft font can be had,  it sets the cell size instead */
+
+    PDC_xft_open_fonts(pdc_app_data.renderFont);
+#endif
 
     /* Calculate size of display window */
 
@@ -620,7 +656,8 @@ int PDC_scr_open(void)
     SP->audible = TRUE;
 
     SP->termattrs = A_COLOR | WA_ITALIC | WA_UNDERLINE | WA_LEFT | WA_RIGHT |
-                    WA_REVERSE | WA_STRIKEOUT | WA_TOP | WA_BLINK | WA_DIM | WA_BOLD;
+                    WA_REVERSE | WA_STRIKEOUT | WA_TOP | WA_BLINK | WA_DIM | WA_BOLD |
+                    WA_DIRECT_COLOR;
 
     /* Add Event handlers to the drawing widget */
 
@@ -634,8 +671,7 @@ int PDC_scr_open(void)
     /* If there is a cursorBlink resource, start the Timeout event */
 
     if (pdc_app_data.cursorBlinkRate)
-        XtAppAddTimeOut(pdc_app_context, pdc_app_data.cursorBlinkRate,
-                        PDC_blink_cursor, NULL);
+        PDC_add_blink_timeout(FALSE);
 
     XtRealizeWidget(pdc_toplevel);
 
@@ -657,11 +693,11 @@ int PDC_scr_open(void)
 
     _get_gc(&pdc_normal_gc, pdc_app_data.normalFont, COLOR_WHITE, COLOR_BLACK);
 
-    _get_gc(&pdc_italic_gc, italic_font_valid ? pdc_app_data.italicFont :
-            pdc_app_data.normalFont, COLOR_WHITE, COLOR_BLACK);
+    _get_gc(&pdc_italic_gc, italic_font, COLOR_WHITE, COLOR_BLACK);
 
-    _get_gc(&pdc_bold_gc, bold_font_valid ? pdc_app_data.boldFont :
-            pdc_app_data.normalFont, COLOR_WHITE, COLOR_BLACK);
+    _get_gc(&pdc_bold_gc, bold_font, COLOR_WHITE, COLOR_BLACK);
+
+    PDC_init_text_gcs(italic_font, bold_font);
 
     _get_gc(&pdc_cursor_gc, pdc_app_data.normalFont,
             COLOR_WHITE, COLOR_BLACK);
@@ -669,6 +705,8 @@ int PDC_scr_open(void)
     XSetLineAttributes(XCURSESDISPLAY, pdc_cursor_gc, 2,
                        LineSolid, CapButt, JoinMiter);
 
+    PDC_size_backbuf();
+
     /* Set the pointer for the application */
 
     _pointer_setup();
@@ -690,6 +728,7 @@ int PDC_scr_open(void)
         pdc_wheight = resize_window_height;
         pdc_resize_now = FALSE;
         SP->resized = FALSE;
+        PDC_size_backbuf();
     }
 
     PDC_init_palette( );
@@ -741,6 +780,7 @@ int PDC_resize_screen(int nlines, int ncols)
     pdc_wwidth = resize_window_width;
     pdc_wheight = resize_window_height;
     pdc_visible_cursor = TRUE;
+    PDC_size_backbuf();
 
     return OK;
 }
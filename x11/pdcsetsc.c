@@ -49,6 +49,9 @@ int PDC_curs_set(int visibility)
     if (visibility != -1)
         SP->visibility = visibility;
 
+    if (SP->visibility && pdc_app_data.cursorBlinkRate && !pdc_blink_due[0])
+        PDC_add_blink_timeout(FALSE);
+
     PDC_display_cursor(SP->cursrow, SP->curscol, SP->cursrow,
                        SP->curscol, visibility);
 
@@ -76,8 +79,8 @@ int PDC_set_blink(bool blinkon)
         {
             SP->termattrs |= A_BLINK;
             pdc_blinked_off = FALSE;
-            XtAppAddTimeOut(pdc_app_context, pdc_app_data.textBlinkRate,
-                            PDC_blink_text, NULL);
+            if (!pdc_blink_due[1])
+                PDC_add_blink_timeout(TRUE);
         }
     }
     else if (SP->termattrs & A_BLINK)
@@ -17,7 +17,11 @@ void PDC_napms(int ms)
 {
     PDC_LOG(("PDC_napms() - called: ms=%d\n", ms));
 
-    XSync(XtDisplay(pdc_toplevel), False);
+    PDC_flush_backbuf();
+    if (pdc_app_data.syncUpdates)
+        XSync(XtDisplay(pdc_toplevel), False);
+    else
+        XFlush(XtDisplay(pdc_toplevel));
 
 #if defined(HAVE_USLEEP)
 
@@ -57,6 +57,10 @@ typedef struct
     int cursorBlinkRate;
     char *textCursor;
     int textBlinkRate;
+    int syncUpdates;
+#ifdef USE_XFT
+    char *renderFont;
+#endif
 } XCursesAppData;
 
 extern XIC pdc_xic;
@@ -72,11 +76,22 @@ extern int pdc_wwidth, pdc_wheight;
 
 extern bool pdc_blinked_off, pdc_window_entered, pdc_resize_now, pdc_return_window_close_as_key;
 extern bool pdc_vertical_cursor, pdc_visible_cursor;
+extern long pdc_blink_due[2];
 
 int PDC_display_cursor(int, int, int, int, int);
 
 void PDC_blink_cursor(XtPointer, XtIntervalId *);
 void PDC_blink_text(XtPointer, XtIntervalId *);
+void PDC_add_blink_timeout(const bool);
+void PDC_init_text_gcs(XFontStruct *, XFontStruct *);
+void PDC_size_backbuf(void);
+void PDC_free_backbuf(void);
+bool PDC_copy_backbuf(const int, const int, const int, const int);
+void PDC_flush_backbuf(void);
+#ifdef USE_XFT
+bool PDC_xft_open_fonts(const char *);
+void PDC_xft_close_fonts(void);
+#endif
 int PDC_kb_setup(void);
 void PDC_redraw_cursor(void);
 bool PDC_scrollbar_init(const char *);